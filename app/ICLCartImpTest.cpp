@@ -28,19 +28,26 @@
 #include "kukaselfctrltask.h"
 #include "tacservocontroller.h"
 #include "tacservotask.h"
+#include "ctrlpipeline.h"
+#include "ctrlpool.h"
+#include "trajqueue.h"
 //#include "CtrlParam.h"
 #include "Timer.h"
 #include <fstream>
 #include "Util.h"
 #include "RobotState.h"
 
-std::ofstream stiffness_data;
 ComOkc *com_okc;
 Robot *kuka_lwr;
 ActController *ac;
+CtrlPipeline *pipeline;
+CtrlPool *pool;
+TrajQueue *traj;
 Task *task;
 TaskNameT taskname;
-ParameterManager* pm;
+ParamSet pm;
+//!stiffness asked for by the commands, the shared parameter set is not changed
+stiffpara stiffness;
 RobotState *kuka_lwr_rs;
 
 GUI gui;
@@ -65,6 +72,8 @@ VisTool *visTool = 0;
 #endif
 
 #define SAMPLEFREQUENCE 4
+//!cartesian speed of movexyz_cb (m/s)
+#define P2P_VELOCITY 0.05
 
 char inp;
 
@@ -87,33 +96,34 @@ void moveto_cb(void){
     o(0) = newO_x;
     o(1) = newO_y;
     o(2) = newO_z;
-    delete ac;
-    delete task;
     for(int i = 0; i < 7; i++){
-        pm->stiff_ctrlpara.axis_stiffness[i] = 1000;
-        pm->stiff_ctrlpara.axis_damping[i] = 0.7;
+        stiffness.axis_stiffness[i] = 1000;
+        stiffness.axis_damping[i] = 0.7;
     }
-    ac = new ProActController(*pm);
-    task = new KukaSelfCtrlTask(RP_NOCONTROL);
-    task->mt = JOINTS;
-    task->mft = GLOBAL;
-    task->set_desired_p_eigen(p);
-    task->set_desired_o_ax(o);
+    //prepare a preallocated pair, the control loop switches to it at the next cycle
+    int slot = pool->acquire();
+    if(slot < 0)
+        return;
+    KukaSelfCtrlTask *next_task = pool->task(slot);
+    next_task->mt = JOINTS;
+    next_task->mft = GLOBAL;
+    next_task->set_desired_p_eigen(p);
+    next_task->set_desired_o_ax(o);
+    pool->submit(slot);
     rmt = NormalMode;
     startflag = false;
     //    std::cout<<"robot self movement and move to new pose"<<std::endl;
 }
 
 void movexyz_cb(){
-    Eigen::Vector3d cp, p, o;
+    Eigen::Vector3d cp, p;
     double x,y,z;
 
     cp.setZero();
     p.setZero();
-    o.setZero();
 
     cp = kuka_lwr->get_cur_cart_p();
-    o = tm2axisangle(kuka_lwr->get_cur_cart_o());
+    Eigen::Quaterniond q(kuka_lwr->get_cur_cart_o());
 
     //todo init xyz by slider.
     x = gui["tx"];
@@ -123,23 +133,25 @@ void movexyz_cb(){
     p(1) = cp(1) + y/1000.0;
     p(2) = cp(2) + z/1000.0;
 
-    delete ac;
-    delete task;
     for(int i = 0; i < 7; i++){
-        pm->stiff_ctrlpara.axis_stiffness[i] = 1000;
-        pm->stiff_ctrlpara.axis_damping[i] = 0.7;
+        stiffness.axis_stiffness[i] = 1000;
+        stiffness.axis_damping[i] = 0.7;
     }
     //std::cout<<"change the stiffness"<<std::endl;
-    ac = new ProActController(*pm);
-    task = new KukaSelfCtrlTask(RP_NOCONTROL);
-    task->mt = JOINTS;
-    task->mft = LOCALP2P;
-    task->velocity_p2p(0) = x/1000.0;
-    task->velocity_p2p(1) = y/1000.0;
-    task->velocity_p2p(2) = z/1000.0;
-    task->set_initial_p_eigen(cp);
-    task->set_desired_p_eigen(p);
-    task->set_desired_o_ax(o);
+    //prepare a preallocated pair, the control loop switches to it at the next cycle
+    int slot = pool->acquire();
+    if(slot < 0)
+        return;
+    KukaSelfCtrlTask *next_task = pool->task(slot);
+    //timed by the control cycles, not by the speed of the gui thread
+    if(traj->restart(cp,q) == false){
+        std::cout<<"trajectory queue is full, move ignored"<<std::endl;
+        return;
+    }
+    traj->push_linear(p,q,(p-cp).norm()/P2P_VELOCITY);
+    next_task->mt = JOINTS;
+    next_task->mft = TRAJECTORY;
+    pool->submit(slot);
     rmt = NormalMode;
     //    std::cout<<"robot self movement and move to new pose"<<std::endl;
 }
@@ -257,11 +269,16 @@ void run_ctrl(){
             kuka_lwr->update_robot_cp_stiffness(cp_stiff,cp_damping);
             kuka_lwr->update_robot_cp_exttcpft(extft);
         }
+        //take over a retargeted controller/task pair at the cycle boundary
+        if(pool->swap()){
+            ac = pool->active_controller();
+            task = pool->active_task();
+            pipeline->update_stage(PRO_STAGE,ac,task);
+            pipeline->reset();
+        }
         //using all kinds of controllers to update the reference
         if(task->mt == JOINTS)
-            ac->update_robot_reference(kuka_lwr,task);
-        ac->llv.setZero();
-        ac->lov.setZero();
+            pipeline->run(kuka_lwr);
         //use CBF to compute the desired joint angle rate
         kuka_lwr->update_cbf_controller();
         kuka_lwr->set_joint_command(rmt);
@@ -307,13 +324,23 @@ void run_vis(){
 
 void init(){
 //    if(!pa("-no-robot")){}
-    pm = new ParameterManager("right_arm_param.xml");
+    pm = load_param_set("right_arm_param.xml");
+    stiffness = pm->stiff_ctrlpara;
     com_okc = new ComOkc(kuka_right,OKC_HOST,OKC_PORT);
     com_okc->connect();
     kuka_lwr = new KukaLwr(kuka_right,*com_okc);
+    kuka_lwr->set_jnt_limits(pm->jnt_limits);
+    kuka_lwr->set_jnt_smoothing(pm->jnt_smoothing);
+    kuka_lwr->set_cart_limits(pm->cart_limits);
     kuka_lwr_rs = new RobotState(kuka_lwr);
-    ac = new ProActController(*pm);
-    task = new KukaSelfCtrlTask(RP_NOCONTROL);
+    pool = new CtrlPool(pm);
+    traj = new TrajQueue();
+    for(int i = 0; i < CTRL_POOL_SIZE; i++)
+        pool->controller(i)->attach_trajectory(traj);
+    ac = pool->active_controller();
+    task = pool->active_task();
+    pipeline = new CtrlPipeline();
+    pipeline->set_stage(PRO_STAGE,ac,task);
     Eigen::Vector3d p,o;
     p.setZero();
     o.setZero();
@@ -326,11 +353,11 @@ void init(){
     o(2) = newO_z;
     task->set_desired_p_eigen(p);
     task->set_desired_o_ax(o);
-    kuka_lwr->setAxisStiffnessDamping(ac->pm.stiff_ctrlpara.axis_stiffness, \
-                                      ac->pm.stiff_ctrlpara.axis_damping);
+    kuka_lwr->setAxisStiffnessDamping(stiffness.axis_stiffness, \
+                                      stiffness.axis_damping);
     rmt = NormalMode;
     //tHello.setSingleShot(false);
-    //tHello.setInterval(Timer::Interval(SAMPLEFREQUENCE));
+    //tHello.setInterval(std::chrono::milliseconds(SAMPLEFREQUENCE));
     //tHello.start(true);
     stiffflag = false;
     startflag = false;
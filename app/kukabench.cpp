@@ -0,0 +1,255 @@
+/*
+ ============================================================================
+ Name        : kukabench.cpp
+ Author      : Qiang Li
+ Version     :
+ Copyright   : Copyright Qiang Li, Universität Bielefeld
+ Description : Headless benchmark of the whole control cycle. A detached
+               ComOkc plays the robot, it follows the joint command exactly.
+               usage: kukabench [param.xml] [cycles] [scenario ...]
+               scenarios: hold p2p tactile modeswitch, default all
+ ============================================================================
+ */
+
+#include <iostream>
+#include <vector>
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+#include <time.h>
+
+#include "ComOkc.h"
+#include "KukaLwr.h"
+#include "proactcontroller.h"
+#include "kukaselfctrltask.h"
+#include "tacservocontroller.h"
+#include "tacservotask.h"
+#include "ctrlpipeline.h"
+#include "ctrlpool.h"
+#include "parametermanager.h"
+
+//!the callback holds the position if the command takes longer (us)
+#define BENCH_DEADLINE_US INLINE_BUDGET_US
+#define BENCH_CYCLE_TIME 0.004
+//!cycles between two commands of the scripted scenarios
+#define BENCH_RETARGET_CYCLES 500
+
+enum BenchScenarioT{
+    BENCH_HOLD,
+    BENCH_P2P,
+    BENCH_TACTILE,
+    BENCH_MODESWITCH
+};
+#define BENCH_SCENARIO_NUM 4
+static const char *scenario_names[BENCH_SCENARIO_NUM] = {"hold","p2p","tactile","modeswitch"};
+
+//!heap allocations while a cycle is timed
+static std::atomic<long> allocations(0);
+static std::atomic<bool> count_allocations(false);
+
+//!the malloc family is replaced, not operator new: Eigen allocates its dynamic
+//!matrices with malloc directly. glibc keeps the originals as __libc_*.
+extern "C" {
+void* __libc_malloc(size_t n);
+void* __libc_calloc(size_t n, size_t size);
+void* __libc_realloc(void *p, size_t n);
+void* __libc_memalign(size_t align, size_t n);
+void __libc_free(void *p);
+
+static inline void count_allocation(){
+    if(count_allocations.load(std::memory_order_relaxed))
+        allocations.fetch_add(1,std::memory_order_relaxed);
+}
+
+void* malloc(size_t n){
+    count_allocation();
+    return __libc_malloc(n);
+}
+
+void* calloc(size_t n, size_t size){
+    count_allocation();
+    return __libc_calloc(n,size);
+}
+
+void* realloc(void *p, size_t n){
+    count_allocation();
+    return __libc_realloc(p,n);
+}
+
+int posix_memalign(void **p, size_t align, size_t n){
+    if((align % sizeof(void*) != 0) || ((align & (align - 1)) != 0))
+        return EINVAL;
+    count_allocation();
+    *p = __libc_memalign(align,n);
+    return (*p == NULL) ? ENOMEM : 0;
+}
+
+void* aligned_alloc(size_t align, size_t n){
+    count_allocation();
+    return __libc_memalign(align,n);
+}
+
+void* memalign(size_t align, size_t n){
+    count_allocation();
+    return __libc_memalign(align,n);
+}
+
+void free(void *p){
+    __libc_free(p);
+}
+}
+
+static double monotonic_us(){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC,&ts);
+    return 1e6*ts.tv_sec + 1e-3*ts.tv_nsec;
+}
+
+//!sorted durations, p in [0,1]
+static double percentile(const std::vector<double>& d, double p){
+    size_t k = (size_t)ceil(p*d.size());
+    if(k > 0)
+        k--;
+    return d[std::min(k,d.size()-1)];
+}
+
+void run_scenario(const ParamSet& pm, BenchScenarioT s, long cycles){
+    //a joint configuration away from the singularities
+    const double q0[7] = {0.0,0.5,0.0,-1.2,0.0,0.6,0.0};
+    ComOkc com(kuka_right,(float)BENCH_CYCLE_TIME);
+    for(int i = 0; i < 7; i++){
+        com.jnt_position_act[i] = q0[i];
+        com.jnt_position_mea[i] = q0[i];
+        com.jnt_command[i] = q0[i];
+    }
+    KukaLwr kuka(kuka_right,com);
+    kuka.set_jnt_limits(pm->jnt_limits);
+    kuka.set_jnt_smoothing(pm->jnt_smoothing);
+    kuka.set_cart_limits(pm->cart_limits);
+    CtrlPool pool(pm);
+    ActController *ac = pool.active_controller();
+    Task *task = pool.active_task();
+    CtrlPipeline pipeline;
+    pipeline.set_stage(PRO_STAGE,ac,task);
+    TacServoController tac_ac(pm);
+    TacServoTask tac_task(CONTACT_POINT_FORCE_TRACKING);
+    myrmex_msg tacfb;
+    memset(&tacfb,0,sizeof(tacfb));
+    RobotModeT rmt = NormalMode;
+
+    kuka.get_joint_position_act();
+    kuka.get_joint_position_mea();
+    kuka.update_robot_state();
+    Eigen::Vector3d home = kuka.get_cur_cart_p();
+    task->set_desired_p_eigen(home);
+    if(s == BENCH_TACTILE){
+        //tactile servoing on top of a proprioceptive stage that only holds
+        task->mft = LOCAL;
+        task->commit();
+        tac_task.mft = LOCAL;
+        tac_task.commit();
+        pipeline.set_stage(TAC_STAGE,&tac_ac,&tac_task,1.0,1);
+    }
+
+    std::vector<double> durations(cycles);
+    long misses = 0;
+    allocations.store(0);
+    for(long c = 0; c < cycles; c++){
+        //scripted commands, prepared outside the timed cycle like the keyboard thread does
+        if((s == BENCH_P2P) && (c % BENCH_RETARGET_CYCLES == 0)){
+            int slot = pool.acquire();
+            if(slot >= 0){
+                KukaSelfCtrlTask *next = pool.task(slot);
+                next->mt = JOINTS;
+                next->mft = LOCALP2P;
+                next->velocity_p2p.setZero();
+                next->velocity_p2p(2) = ((c/BENCH_RETARGET_CYCLES)%2) ? -0.05 : 0.05;
+                pool.submit(slot);
+            }
+        }
+        if(s == BENCH_TACTILE){
+            double phase = 2*M_PI*c/1000.0;
+            tacfb.cogx = 8.0 + 3.0*sin(phase);
+            tacfb.cogy = 8.0 + 3.0*cos(phase);
+            tacfb.contactnum = 1;
+            tacfb.contactflag = true;
+            tacfb.cf = 0.1 + 0.05*sin(0.5*phase);
+            tacfb.lineorien = 0.3*sin(phase);
+        }
+        if((s == BENCH_MODESWITCH) && (c % BENCH_RETARGET_CYCLES == 0)){
+            rmt = (rmt == NormalMode) ? PsudoGravityCompensation : NormalMode;
+            int slot = pool.acquire();
+            if(slot >= 0){
+                Eigen::Vector3d p = home;
+                p(0) += ((c/BENCH_RETARGET_CYCLES)%2) ? 0.05 : -0.05;
+                pool.task(slot)->mt = JOINTS;
+                pool.task(slot)->mft = GLOBAL;
+                pool.task(slot)->set_desired_p_eigen(p);
+                pool.submit(slot);
+            }
+        }
+        //the simulated robot follows the last command
+        for(int i = 0; i < 7; i++){
+            com.jnt_position_act[i] = com.jnt_command[i];
+            com.jnt_position_mea[i] = com.jnt_command[i];
+        }
+
+        count_allocations.store(true,std::memory_order_relaxed);
+        double t0 = monotonic_us();
+        kuka.get_joint_position_act();
+        kuka.get_joint_position_mea();
+        kuka.update_robot_state();
+        if(pool.swap()){
+            ac = pool.active_controller();
+            task = pool.active_task();
+            pipeline.update_stage(PRO_STAGE,ac,task);
+            pipeline.reset();
+        }
+        if(task->mt == JOINTS)
+            pipeline.run(&kuka,(s == BENCH_TACTILE) ? &tacfb : NULL);
+        kuka.update_cbf_controller();
+        kuka.set_joint_command(rmt);
+        double t1 = monotonic_us();
+        count_allocations.store(false,std::memory_order_relaxed);
+
+        durations[c] = t1 - t0;
+        if(durations[c] > BENCH_DEADLINE_US)
+            misses++;
+    }
+    std::sort(durations.begin(),durations.end());
+    std::cout<<scenario_names[s]<<","<<cycles<<","<<percentile(durations,0.5)<<","<<percentile(durations,0.99)<<","\
+             <<percentile(durations,0.999)<<","<<durations.back()<<","<<(double)allocations.load()/cycles<<","\
+             <<misses<<std::endl;
+}
+
+int main(int argc, char* argv[])
+{
+    std::string param_file = "right_arm_param.xml";
+    long cycles = 20000;
+    std::vector<BenchScenarioT> scenarios;
+    if(argc > 1)
+        param_file = argv[1];
+    if(argc > 2)
+        cycles = atol(argv[2]);
+    for(int i = 3; i < argc; i++){
+        for(int k = 0; k < BENCH_SCENARIO_NUM; k++){
+            if(strcmp(argv[i],scenario_names[k]) == 0)
+                scenarios.push_back((BenchScenarioT)k);
+        }
+    }
+    if(scenarios.empty()){
+        for(int k = 0; k < BENCH_SCENARIO_NUM; k++)
+            scenarios.push_back((BenchScenarioT)k);
+    }
+    if(cycles < 1)
+        cycles = 1;
+
+    ParamSet pm = load_param_set(param_file);
+    std::cout<<"scenario,cycles,p50_us,p99_us,p999_us,max_us,allocations_per_cycle,deadline_misses"<<std::endl;
+    for(size_t i = 0; i < scenarios.size(); i++)
+        run_scenario(pm,scenarios[i],cycles);
+    return 0;
+}
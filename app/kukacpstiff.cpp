@@ -25,14 +25,19 @@
 #include "Timer.h"
 #include <fstream>
 #include "Util.h"
+#include "tracer.h"
+#include "cmdqueue.h"
+#include "ctrlpool.h"
 
-std::ofstream stiffness_data;
 ComOkc *com_okc;
 Robot *kuka_lwr;
 ActController *ac;
+CtrlPool *pool;
 Task *task;
 TaskNameT taskname;
-ParameterManager* pm;
+ParamSet pm;
+//!stiffness asked for by the commands, the shared parameter set is not changed
+stiffpara stiffness;
 #ifdef DJALLIL_CONF
 #define newP_x 0.28
 #define newP_y 0.5
@@ -51,8 +56,12 @@ ParameterManager* pm;
 #endif
 
 #define SAMPLEFREQUENCE 4
+//!the control loop looks at the keyboard commands at least this often without measurements (us)
+#define DATA_TIMEOUT_US 100000
 
-char inp;
+int inp;
+//!key presses of the keyboard thread for the control loop
+CmdQueue cmds;
 
 RobotModeT rmt;
 KUKACTRLMODET kmt;
@@ -76,13 +85,22 @@ int getch()
 
 //The function we want to make the thread run.
 void keypresscap(void)
-{	char inp_tmp;
-    while(inp != 'e'){
+{	int inp_tmp = 0;
+    while((inp_tmp != 'e') && (inp_tmp != EOF)){
         inp_tmp = getch();
-            if ( inp_tmp != '\n' ) {
-            inp = inp_tmp;
-//            std::cout<<"in sub task loop, you input char "<<inp<<std::endl;
+        if(inp_tmp == 't'){
+            //toggle tracing, stopping writes the trace here and not on the control thread
+            if(Tracer::enabled()){
+                Tracer::enable(false);
+                Tracer::write_chrome_json(TRACE_FILE);
             }
+            else
+                Tracer::enable(true);
+        }
+        else if ( inp_tmp != '\n' ) {
+            if(cmds.push(inp_tmp) == false)
+                std::cout<<"command queue is full, dropped "<<(char)inp_tmp<<std::endl;
+        }
     }
 }
 
@@ -97,19 +115,21 @@ void moveto_cb(void){
     o(0) = newO_x;
     o(1) = newO_y;
     o(2) = newO_z;
-    delete ac;
-    delete task;
     for(int i = 0; i < 7; i++){
-        pm->stiff_ctrlpara.axis_stiffness[i] = 1000;
-        pm->stiff_ctrlpara.axis_damping[i] = 0.7;
+        stiffness.axis_stiffness[i] = 1000;
+        stiffness.axis_damping[i] = 0.7;
     }
     std::cout<<"change the stiffness"<<std::endl;
-    ac = new ProActController(*pm);
-    task = new KukaSelfCtrlTask(RP_NOCONTROL);
-    task->mt == JOINTS;
-    task->mft = GLOBAL;
-    task->set_desired_p_eigen(p);
-    task->set_desired_o_ax(o);
+    //prepare a preallocated pair, the control loop switches to it at the next cycle
+    int slot = pool->acquire();
+    if(slot < 0)
+        return;
+    KukaSelfCtrlTask *next_task = pool->task(slot);
+    next_task->mt = JOINTS;
+    next_task->mft = GLOBAL;
+    next_task->set_desired_p_eigen(p);
+    next_task->set_desired_o_ax(o);
+    pool->submit(slot);
     rmt = NormalMode;
 //    std::cout<<"robot self movement and move to new pose"<<std::endl;
 }
@@ -128,23 +148,25 @@ void movein_xyz(float x, float y, float z){
     p(1) = cp(1) + y;
     p(2) = cp(2) + z;
 
-    delete ac;
-    delete task;
     for(int i = 0; i < 7; i++){
-        pm->stiff_ctrlpara.axis_stiffness[i] = 1000;
-        pm->stiff_ctrlpara.axis_damping[i] = 0.7;
+        stiffness.axis_stiffness[i] = 1000;
+        stiffness.axis_damping[i] = 0.7;
     }
     //std::cout<<"change the stiffness"<<std::endl;
-    ac = new ProActController(*pm);
-    task = new KukaSelfCtrlTask(RP_NOCONTROL);
-    task->mt == JOINTS;
-    task->mft = LOCALP2P;
-    task->velocity_p2p(0) = x/1.0;
-    task->velocity_p2p(1) = y/1.0;
-    task->velocity_p2p(2) = z/1.0;
-    task->set_initial_p_eigen(cp);
-    task->set_desired_p_eigen(p);
-    task->set_desired_o_ax(o);
+    //prepare a preallocated pair, the control loop switches to it at the next cycle
+    int slot = pool->acquire();
+    if(slot < 0)
+        return;
+    KukaSelfCtrlTask *next_task = pool->task(slot);
+    next_task->mt = JOINTS;
+    next_task->mft = LOCALP2P;
+    next_task->velocity_p2p(0) = x/1.0;
+    next_task->velocity_p2p(1) = y/1.0;
+    next_task->velocity_p2p(2) = z/1.0;
+    next_task->set_initial_p_eigen(cp);
+    next_task->set_desired_p_eigen(p);
+    next_task->set_desired_o_ax(o);
+    pool->submit(slot);
     rmt = NormalMode;
 //    std::cout<<"robot self movement and move to new pose"<<std::endl;
 }
@@ -223,7 +245,6 @@ Timer tHello([]()
 //        pm->stiff_ctrlpara.axis_stiffness[i] = K_axis(i,i);
 //        pm->stiff_ctrlpara.axis_damping[i] = 0.7;
 //    }
-//    stiffness_data<<K_axis(0,0)<<","<<K_axis(1,1)<<","<<K_axis(2,2)<<","<<K_axis(3,3)<<","<<K_axis(4,4)<<","<<K_axis(5,5)<<std::endl;
 //    std::cout<<"change the stiffness"<<std::endl;
 //    std::cout<<"stiffness are "<<std::endl;std::cout<<K_axis<<std::endl;
 //    std::cout<<"Jacobian are "<<std::endl;std::cout<<J_eigen<<std::endl;
@@ -236,6 +257,12 @@ int counter1 = 0;
 void run(){
     //only call for this function, the ->jnt_position_act is updated
     if((com_okc->data_available == true)&&(com_okc->controller_update == false)){
+        TRACE_SCOPE("control_cycle");
+        //take over a retargeted controller/task pair at the cycle boundary
+        if(pool->swap()){
+            ac = pool->active_controller();
+            task = pool->active_task();
+        }
 //        //        counter1++;
 //        //        if(counter1 > 50){
 //        //            kuka_lwr->update_robot_stiffness(pm);
@@ -279,7 +306,6 @@ void run(){
 //            pm->stiff_ctrlpara.axis_damping[i] = 0.7;
 //        }
 //        K_cart = (J_eigen*K_axis_diag.inverse()*J_eigen.transpose()).inverse();
-////        stiffness_data<<K_axis(0,0)<<","<<K_axis(1,1)<<","<<K_axis(2,2)<<","<<K_axis(3,3)<<","<<K_axis(4,4)<<","<<K_axis(5,5);
 
 //        //kuka_lwr->update_robot_stiffness(pm);
 
@@ -324,8 +350,6 @@ void run(){
 //        //using all kinds of controllers to update the reference
 //        if(task->mt == JOINTS)
 //            ac->update_robot_reference(kuka_lwr,task);
-//        ac->llv.setZero();
-//        ac->lov.setZero();
         //use CBF to compute the desired joint angle rate
         kuka_lwr->update_cbf_controller();
         kuka_lwr->set_joint_command(rmt);
@@ -341,19 +365,23 @@ void run(){
 //        intervaltime = timeval_diff(NULL,&v_cur,&v_old);
 //        std::cout<<"stiffness are in J"<<std::endl;std::cout<<K_axis<<std::endl;
 //        std::cout<<"stiffness are in C"<<std::endl;std::cout<<K_cart<<std::endl;
-        //stiffness_data<<","<<intervaltime<<std::endl;
         //std::cout<<"interval is "<<intervaltime<<std::endl;
     }
 }
 
 void init(){
-    pm = new ParameterManager("right_arm_param.xml");
+    pm = load_param_set("right_arm_param.xml");
+    stiffness = pm->stiff_ctrlpara;
     kmt = CART_IMP;
     com_okc = new ComOkc(kuka_right,OKC_HOST,OKC_PORT,CART_IMP);
     com_okc->connect();
     kuka_lwr = new KukaLwr(kuka_right,*com_okc);
-    ac = new ProActController(*pm);
-    task = new KukaSelfCtrlTask(RP_NOCONTROL);
+    kuka_lwr->set_jnt_limits(pm->jnt_limits);
+    kuka_lwr->set_jnt_smoothing(pm->jnt_smoothing);
+    kuka_lwr->set_cart_limits(pm->cart_limits);
+    pool = new CtrlPool(pm);
+    ac = pool->active_controller();
+    task = pool->active_task();
     Eigen::Vector3d p,o;
     p.setZero();
     o.setZero();
@@ -366,11 +394,11 @@ void init(){
     o(2) = newO_z;
     task->set_desired_p_eigen(p);
     task->set_desired_o_ax(o);
-    kuka_lwr->setAxisStiffnessDamping(ac->pm.stiff_ctrlpara.axis_stiffness, \
-                                           ac->pm.stiff_ctrlpara.axis_damping);
+    kuka_lwr->setAxisStiffnessDamping(stiffness.axis_stiffness, \
+                                           stiffness.axis_damping);
     rmt = NormalMode;
     tHello.setSingleShot(false);
-    tHello.setInterval(Timer::Interval(SAMPLEFREQUENCE));
+    tHello.setInterval(std::chrono::milliseconds(SAMPLEFREQUENCE));
     tHello.start(true);
     stiffflag = false;
     t_t = 0.0;
@@ -384,10 +412,13 @@ int main(int argc, char* argv[])
     bool sinOn = false;
     double step = 0.1;
     std::thread t1(keypresscap);
-    stiffness_data.open("/tmp/stiff.txt");
     inp = 'f';
     init();
+    Tracer::register_thread("control");
     while(inp != 'e' && inp != EOF){
+        int cmd;
+        if(cmds.pop(cmd))
+            inp = cmd;
         switch (inp){
 
         case 'g':
@@ -433,11 +464,20 @@ int main(int argc, char* argv[])
                 //std::cout<<"teta = "<< sin(teta)<<std::endl;
             }
         }
-        run();
-        usleep(20);
+        //block until the callback publishes the next measurement
+        if(com_okc->wait_for_data(DATA_TIMEOUT_US))
+            run();
 }
     std::cout<<"main function is end "<<std::endl;
     tHello.stop();
+    TimerStats ts = tHello.stats();
+    std::cout<<"timer: "<<ts.cycles<<" cycles, "<<ts.overruns<<" overruns, latency "<<ts.latency_mean<<"/"\
+             <<ts.latency_max<<" us mean/max, callback "<<ts.run_mean<<"/"<<ts.run_max<<" us mean/max"<<std::endl;
+    const DataWaitStats& ws = com_okc->wait_stats();
+    std::cout<<"control start after a measurement: "<<ws.wakeups<<" cycles, "<<ws.timeouts<<" timeouts, latency "\
+             <<ws.latency_mean<<"/"<<ws.latency_max<<" us mean/max"<<std::endl;
+    //flushes the cycle log
+    delete kuka_lwr;
     t1.join();
     std::cout<<"keypress thread is end "<<std::endl;
 }
@@ -0,0 +1,76 @@
+/*
+ ============================================================================
+ Name        : kukalog2csv.cpp
+ Author      : Qiang Li
+ Version     :
+ Copyright   : Copyright Qiang Li, Universität Bielefeld
+ Description : Streams a session log as csv to stdout for the legacy tools.
+               usage: kukalog2csv log [-t t0 t1] [-l] [channel ...]
+               -t only the rows with t0 <= time < t1, -l lists the channels,
+               without channels all channels are written
+ ============================================================================
+ */
+
+#include <iostream>
+#include <iomanip>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <vector>
+
+#include "sessionlog.h"
+
+int main(int argc, char* argv[])
+{
+    if(argc < 2){
+        std::cout<<"usage: kukalog2csv log [-t t0 t1] [-l] [channel ...]"<<std::endl;
+        return 1;
+    }
+    SessionLogReader log;
+    if(log.open(argv[1]) == false)
+        return 1;
+    double t0 = -std::numeric_limits<double>::infinity();
+    double t1 = std::numeric_limits<double>::infinity();
+    std::vector<int> channels;
+    for(int i = 2; i < argc; i++){
+        if((strcmp(argv[i],"-t") == 0) && (i + 2 < argc)){
+            t0 = atof(argv[i+1]);
+            t1 = atof(argv[i+2]);
+            i += 2;
+        }
+        else if(strcmp(argv[i],"-l") == 0){
+            for(uint32_t c = 0; c < log.channels(); c++)
+                std::cout<<log.channel_name(c)<<std::endl;
+            std::cout<<log.rows()<<" rows in "<<log.chunks()<<" chunks"<<std::endl;
+            return 0;
+        }
+        else{
+            int c = log.channel_index(argv[i]);
+            if(c < 0){
+                std::cerr<<"unknown channel "<<argv[i]<<std::endl;
+                return 1;
+            }
+            channels.push_back(c);
+        }
+    }
+    if(channels.empty()){
+        for(uint32_t c = 0; c < log.channels(); c++)
+            channels.push_back(c);
+    }
+
+    std::cout<<"time";
+    for(size_t c = 0; c < channels.size(); c++)
+        std::cout<<","<<log.channel_name(channels[c]);
+    std::cout<<"\n"<<std::setprecision(std::numeric_limits<double>::digits10 + 2);
+    for(uint64_t row = log.lower_bound(t0); row < log.rows(); row++){
+        double t = log.time(row);
+        if(t >= t1)
+            break;
+        std::cout<<t;
+        for(size_t c = 0; c < channels.size(); c++)
+            std::cout<<","<<log.value(row,channels[c]);
+        std::cout<<"\n";
+    }
+    std::cout.flush();
+    return 0;
+}
@@ -0,0 +1,1081 @@
+/*
+ ============================================================================
+ Name        : kukamicrobench.cpp
+ Author      : Qiang Li
+ Version     :
+ Copyright   : Copyright Qiang Li, Universität Bielefeld
+ Description : Microbenchmark of the per cycle controller kernels, runs
+               without robot. usage: kukamicrobench [param.xml] [iterations] [-b baseline.csv]
+               -b compares with the output of an earlier run and fails if a
+               kernel got more than BENCH_REGRESSION slower
+ ============================================================================
+ */
+
+#include <iostream>
+#include <map>
+#include <chrono>
+#include <cstdlib>
+#include <cmath>
+#include <limits>
+#include <thread>
+#include <atomic>
+#include <semaphore.h>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <algorithm>
+#include <cstring>
+#include <deque>
+
+#include "parametermanager.h"
+#include "proactcontroller.h"
+#include "kukaselfctrltask.h"
+#include "tacservocontroller.h"
+#include "tacservotask.h"
+#include "ctrlpool.h"
+#include "trajqueue.h"
+#include "jntlimitfilter.h"
+#include "jnttrajgenerator.h"
+#include "cartlimiter.h"
+#include "tracer.h"
+#include "ComOkc.h"
+#include "KukaLwr.h"
+#include "RobotState.h"
+#include "Util.h"
+#include "streamfilter.h"
+
+//!every kernel is timed this often, the median is reported
+#define BENCH_REPEATS 5
+//!a kernel this much slower than the baseline is a regression
+#define BENCH_REGRESSION 1.10
+
+//!keeps the compiler from dropping the benchmarked computation
+volatile double bench_sink;
+
+//!time per call in ns, median and fastest of the repeats
+struct BenchResult{
+    double ns;
+    double ns_min;
+};
+
+//!run f for iterations times in BENCH_REPEATS rounds after a warm up
+template <typename F>
+BenchResult bench_ns(F f, long iterations){
+    double rounds[BENCH_REPEATS];
+    long n = iterations/BENCH_REPEATS + 1;
+    for(long i = 0; i < iterations/10; i++)
+        f();
+    for(int r = 0; r < BENCH_REPEATS; r++){
+        std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+        for(long i = 0; i < n; i++)
+            f();
+        std::chrono::steady_clock::time_point t1 = std::chrono::steady_clock::now();
+        rounds[r] = std::chrono::duration<double,std::nano>(t1-t0).count()/n;
+    }
+    std::sort(rounds,rounds + BENCH_REPEATS);
+    BenchResult b;
+    b.ns = rounds[BENCH_REPEATS/2];
+    b.ns_min = rounds[0];
+    return b;
+}
+
+//!mean ns from publishing a measurement to having the command, with the
+//!controller work on a second thread as in ComOkc's handoff mode
+template <typename F>
+double bench_handoff_ns(F work, long cycles){
+    sem_t data;
+    std::atomic<bool> update(false);
+    std::atomic<bool> running(true);
+    sem_init(&data,0,0);
+    std::thread control([&](){
+        while(true){
+            sem_wait(&data);
+            if(running.load() == false)
+                break;
+            work();
+            update.store(true);
+        }
+    });
+    std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+    for(long i = 0; i < cycles; i++){
+        sem_post(&data);
+        while(update.load() == false);
+        update.store(false);
+    }
+    std::chrono::steady_clock::time_point t1 = std::chrono::steady_clock::now();
+    running.store(false);
+    sem_post(&data);
+    control.join();
+    sem_destroy(&data);
+    return std::chrono::duration<double,std::nano>(t1-t0).count()/cycles;
+}
+
+//!kernel name and median of every result printed so far
+std::vector<std::pair<std::string,double> > results;
+
+void print_result(const char *name, long iterations, BenchResult r){
+    results.push_back(std::make_pair(std::string(name),r.ns));
+    std::cout<<name<<","<<iterations<<","<<r.ns<<","<<r.ns_min<<std::endl;
+}
+
+void print_result(const char *name, long iterations, double ns){
+    BenchResult r;
+    r.ns = ns;
+    r.ns_min = ns;
+    print_result(name,iterations,r);
+}
+
+//!compare the results with an earlier kernel section, false if a kernel regressed
+bool check_baseline(const std::string& path){
+    std::ifstream f(path.c_str());
+    if(!f){
+        std::cout<<"can not read the baseline "<<path<<std::endl;
+        return false;
+    }
+    bool ok = true;
+    std::string line;
+    std::cout<<"regression,baseline_ns,ns,ratio"<<std::endl;
+    while(std::getline(f,line)){
+        std::stringstream ss(line);
+        std::string name,it,ns;
+        if(!std::getline(ss,name,',') || !std::getline(ss,it,',') || !std::getline(ss,ns,','))
+            continue;
+        double base = atof(ns.c_str());
+        if(base <= 0.0)
+            continue;
+        for(size_t i = 0; i < results.size(); i++){
+            if((results[i].first == name) && (results[i].second > BENCH_REGRESSION*base)){
+                std::cout<<name<<","<<base<<","<<results[i].second<<","<<results[i].second/base<<std::endl;
+                ok = false;
+            }
+        }
+    }
+    return ok;
+}
+
+//!the proprioceptive controller evaluation as it was done before the gain cache
+struct LegacyProLv{
+    std::map<PROTaskNameT, Eigen::MatrixXd> psm;
+    std::map<PROTaskNameT, Eigen::MatrixXd> Kpp;
+    std::map<PROTaskNameT, Eigen::Matrix3d> Kop;
+    Eigen::Vector3d llv_pro,lov_pro;
+    Eigen::VectorXd lv_pro;
+    LegacyProLv(const ParameterManager& pm){
+        for(int i = 0; i < PRO_TASK_NUM; i++){
+            if(pm.pro_task_ctrl_param[i].loaded == false)
+                continue;
+            Kpp[(PROTaskNameT)i] = pm.pro_task_ctrl_param[i].kpp;
+            psm[(PROTaskNameT)i] = pm.pro_task_ctrl_param[i].psm;
+            Kop[(PROTaskNameT)i].setIdentity();
+        }
+    }
+    void get_desired_lv(Task *t){
+        Eigen::VectorXd identity_v;
+        identity_v.setOnes(6);
+        KukaSelfCtrlTask tst(t->curtaskname.prot);
+        tst = *(KukaSelfCtrlTask*)t;
+        lv_pro = Kpp[tst.curtaskname.prot] * psm[tst.curtaskname.prot] * identity_v;
+        llv_pro = lv_pro.head(3);
+        lov_pro = Kop[tst.curtaskname.prot] * lv_pro.tail(3);
+    }
+};
+
+//!the tactile servo PID evaluation as it was done before the fused gains
+struct LegacyTacLv{
+    std::map<TACTaskNameT, Eigen::MatrixXd> sm,tjkm,Kpp,Kpi,Kpd,Kop;
+    Eigen::VectorXd deltais,deltais_int,deltais_old,deltape;
+    Eigen::Vector3d llv_tac,lov_tac;
+    LegacyTacLv(const ParameterManager& pm){
+        for(int i = 0; i < TAC_TASK_NUM; i++){
+            const taskctrlpara& tp = pm.tac_task_ctrl_param[i];
+            if(tp.loaded == false)
+                continue;
+            Kpp[(TACTaskNameT)i] = tp.kpp;
+            Kpi[(TACTaskNameT)i] = tp.kpi;
+            Kpd[(TACTaskNameT)i] = tp.kpd;
+            Kop[(TACTaskNameT)i] = tp.kop;
+            sm[(TACTaskNameT)i] = tp.tsm;
+            tjkm[(TACTaskNameT)i] = tp.ttjkm;
+        }
+        deltais.setZero(6);
+        deltais_int.setZero(6);
+        deltais_old.setZero(6);
+    }
+    void get_desired_lv(Task *t, myrmex_msg *tacfb){
+        TacServoTask tst(t->curtaskname.tact);
+        tst = *(TacServoTask*)t;
+        double desired_cp[2];
+        double desiredf;
+        tst.get_desired_cp_myrmex(desired_cp);
+        tst.get_desired_cf_myrmex(desiredf);
+        deltais(1) = tacfb->cogx - desired_cp[0];
+        deltais(0) = tacfb->cogy - desired_cp[1];
+        deltais(5) = M_PI/2 - tacfb->lineorien;
+        deltais(2) =  desiredf - tacfb->cf;
+        deltais_int = deltais_int + deltais;
+        TACTaskNameT tnt = tst.curtaskname.tact;
+        deltape = Kpp[tnt] * tjkm[tnt] * sm[tnt] * deltais + \
+                Kpi[tnt] * tjkm[tnt] * sm[tnt] * deltais_int + \
+                Kpd[tnt] * tjkm[tnt] * sm[tnt] * (deltais - deltais_old);
+        llv_tac = deltape.head(3);
+        lov_tac = Kop[tnt] * deltape.tail(3);
+        deltais_old = deltais;
+    }
+};
+
+//!the joint limit filter as it was before the packed lanes
+struct LegacyJntLimitFilter{
+    double jerk_limits[7],accel_limits[7],velocity_limits[7];
+    double lastCorr[7],lastAccel[7],lastJerk[7];
+    double cycle_time,speedlimit;
+    //!velocity/acceleration factor and jerk blend factor of the last call
+    double last_factor,last_jerk_factor;
+    LegacyJntLimitFilter(double t, const JntLimits& l = JntLimits()){
+        for(int i = 0; i < 7; i++){
+            jerk_limits[i] = l.jerk_limits[i];
+            accel_limits[i] = l.accel_limits[i];
+            velocity_limits[i] = l.velocity_limits[i];
+            lastJerk[i] = 0;
+            lastAccel[i] = 0;
+            lastCorr[i] = 0;
+        }
+        cycle_time = t;
+        speedlimit = l.speedlimit;
+    }
+    void get_filtered_value(double *v_in, double* v_out){
+        double factor = 1.0;
+        double temp;
+        for (int i = 0; i < 7; i++){
+            if (fabs(factor*v_in[i]-lastCorr[i]) > std::numeric_limits<double>::epsilon()){
+                if ( (temp = (speedlimit*accel_limits[i]*cycle_time / fabs(factor*v_in[i]-lastCorr[i])))  < factor)
+                    factor = temp;
+            }
+            if (fabs (factor*v_in[i]) > std::numeric_limits<double>::epsilon()){
+                if ((temp = (speedlimit*velocity_limits[i]*cycle_time / fabs (factor*v_in[i])))  < factor)
+                    factor = temp;
+            }
+        }
+        for (int i=0; i < 7; i++)
+            v_out[i] = v_in[i]*factor;
+        last_factor = factor;
+        double f,f_min = 1.0;
+        for (int j=0; j < 7; j++){
+            f = (speedlimit*jerk_limits[j]*cycle_time) / fabsf ( v_out[j] - lastCorr[j] - lastAccel[j]);
+            if (f < f_min)
+                f_min = f;
+        }
+        last_jerk_factor = f_min;
+        for (int i=0; i < 7; i++)
+            v_out[i] = f_min*v_out[i] + ((1.0-f_min)*lastCorr[i]);
+        for (int i = 0; i < 7; i++){
+            lastJerk[i] = lastAccel[i] - (lastCorr[i] - v_out[i]);
+            lastAccel[i] = lastCorr[i] - v_out[i];
+            lastCorr[i] = v_out[i];
+        }
+    }
+};
+
+void print_property(const char *name, long cases, long failures){
+    std::cout<<name<<","<<cases<<","<<failures<<std::endl;
+}
+
+//!properties of the packed JntLimitFilter against the legacy one, printed as
+//!property,cases,failures
+void check_jntlimitfilter(const ParameterManager& pm, long cases){
+    const double dt = 0.004;
+    JntLimits l;
+    long failures = 0;
+    std::cout<<"property,cases,failures"<<std::endl;
+
+    //the parameter file carries the same limits as the built in defaults
+    for(int i = 0; i < 7; i++){
+        if(fabs(pm.jnt_limits.velocity_limits[i] - l.velocity_limits[i]) > 1e-6*l.velocity_limits[i]) failures++;
+        if(fabs(pm.jnt_limits.accel_limits[i] - l.accel_limits[i]) > 1e-6*l.accel_limits[i]) failures++;
+        if(fabs(pm.jnt_limits.jerk_limits[i] - l.jerk_limits[i]) > 1e-6*l.jerk_limits[i]) failures++;
+    }
+    if(pm.jnt_limits.speedlimit != l.speedlimit) failures++;
+    print_property("jntlimitfilter_param_file_defaults",22,failures);
+
+    //a slowly varying increment far below every limit passes both filters unchanged
+    JntLimitFilter jlf(dt,l);
+    LegacyJntLimitFilter legacy(dt,l);
+    double v_in[7],v_new[7],v_old[7];
+    failures = 0;
+    srand(1);
+    double drift[7] = {0,0,0,0,0,0,0};
+    for(long c = 0; c < cases; c++){
+        for(int i = 0; i < 7; i++){
+            drift[i] += 1e-7*(2.0*rand()/RAND_MAX - 1.0);
+            drift[i] = std::max(-1e-4,std::min(1e-4,drift[i]));
+            v_in[i] = drift[i];
+        }
+        jlf.get_filtered_value(v_in,v_new);
+        legacy.get_filtered_value(v_in,v_old);
+        for(int i = 0; i < 7; i++){
+            if((v_new[i] != v_in[i]) || (v_old[i] != v_in[i]))
+                failures++;
+        }
+    }
+    print_property("jntlimitfilter_unlimited_equals_legacy",cases,failures);
+
+    //an increment sweeping up to twice the velocity bound, the legacy filter runs from
+    //the state of the packed one every cycle. The packed filter differs on purpose in
+    //two places: its velocity/acceleration factor is the largest feasible one instead
+    //of the order dependent estimate, and its jerk stage limits the change of the
+    //acceleration (the legacy blend bounded the sum of the last two changes). In the
+    //velocity limited cycles where neither applies both must give the same increment.
+    JntLimitFilter jlf_c(dt,l);
+    LegacyJntLimitFilter legacy_c(dt,l);
+    double c_last[7] = {0,0,0,0,0,0,0}, e_last[7] = {0,0,0,0,0,0,0};
+    long compared = 0;
+    failures = 0;
+    for(long c = 0; c < cases; c++){
+        for(int i = 0; i < 7; i++){
+            v_in[i] = 2.0*l.speedlimit*l.velocity_limits[i]*dt*sin(1e-3*c*(i + 1) + i);
+            legacy_c.lastCorr[i] = c_last[i];
+            legacy_c.lastAccel[i] = -e_last[i];
+        }
+        jlf_c.get_filtered_value(v_in,v_new);
+        legacy_c.get_filtered_value(v_in,v_old);
+        double exact = 1.0;
+        for(int i = 0; i < 7; i++){
+            double d = fabs(v_in[i]);
+            double s = (v_in[i] < 0) ? -1.0 : 1.0;
+            if(d > 0.0)
+                exact = std::min(exact,std::min((s*c_last[i] + l.speedlimit*l.accel_limits[i]*dt)/d,\
+                                                l.speedlimit*l.velocity_limits[i]*dt/d));
+        }
+        exact = std::max(0.0,exact);
+        bool jerk_free = true;
+        for(int i = 0; i < 7; i++){
+            if(fabs(exact*v_in[i] - c_last[i] - e_last[i]) > l.speedlimit*l.jerk_limits[i]*dt)
+                jerk_free = false;
+        }
+        if((exact < 1.0) && (fabs(legacy_c.last_factor - exact) <= 1e-12) && (legacy_c.last_jerk_factor >= 1.0)\
+                && jerk_free){
+            compared++;
+            for(int i = 0; i < 7; i++){
+                if(fabs(v_new[i] - v_old[i]) > 1e-12*l.speedlimit*l.velocity_limits[i]*dt){
+                    failures++;
+                    break;
+                }
+            }
+        }
+        for(int i = 0; i < 7; i++){
+            e_last[i] = v_new[i] - c_last[i];
+            c_last[i] = v_new[i];
+        }
+    }
+    print_property("jntlimitfilter_clamped_equals_legacy",compared,failures);
+
+    //random jumps of the target: the increment never exceeds the velocity bound, its
+    //change stays within the acceleration bound and the change of that within the
+    //jerk bound, unless continuing with the last change would break the velocity bound
+    JntLimitFilter jlf_r(dt,l);
+    double last[7] = {0,0,0,0,0,0,0}, last_change[7] = {0,0,0,0,0,0,0};
+    long vel_failures = 0, acc_failures = 0, jerk_failures = 0, jerk_cases = 0;
+    for(long c = 0; c < cases; c++){
+        for(int i = 0; i < 7; i++)
+            v_in[i] = 0.5*(2.0*rand()/RAND_MAX - 1.0);
+        jlf_r.get_filtered_value(v_in,v_new);
+        bool continuation_ok = true;
+        for(int i = 0; i < 7; i++){
+            if(fabs(last[i] + last_change[i]) > l.speedlimit*l.velocity_limits[i]*dt)
+                continuation_ok = false;
+        }
+        if(continuation_ok)
+            jerk_cases++;
+        bool jerk_failed = false;
+        for(int i = 0; i < 7; i++){
+            double v_bound = l.speedlimit*l.velocity_limits[i]*dt;
+            double a_bound = l.speedlimit*l.accel_limits[i]*dt;
+            double j_bound = l.speedlimit*l.jerk_limits[i]*dt;
+            double change = v_new[i] - last[i];
+            if(fabs(v_new[i]) > v_bound*(1.0+1e-9))
+                vel_failures++;
+            if(fabs(change) > a_bound*(1.0+1e-9))
+                acc_failures++;
+            if(continuation_ok && (fabs(change - last_change[i]) > j_bound*(1.0+1e-9)))
+                jerk_failed = true;
+            last[i] = v_new[i];
+            last_change[i] = change;
+        }
+        if(jerk_failed)
+            jerk_failures++;
+    }
+    print_property("jntlimitfilter_velocity_bound",cases,vel_failures);
+    print_property("jntlimitfilter_accel_bound",cases,acc_failures);
+    print_property("jntlimitfilter_jerk_bound",jerk_cases,jerk_failures);
+}
+
+//!the generator run on its commanded positions, failures counted per joint and cycle
+struct JtgRun{
+    long vel,acc,jerk,late;
+};
+
+//!moves q to target from rest, retargets after retarget cycles if retarget_to is set.
+//!Velocity, acceleration and jerk are the finite differences of the commanded
+//!positions, what the robot sees. Late counts joints not on the target after the
+//!rest-to-rest time plus JTG_CHECK_SLACK cycles, a retargeted joint that is still
+//!moving first has to brake, it only has to arrive.
+#define JTG_CHECK_SLACK 5
+//!length of a checked move in cycles
+#define JTG_CHECK_CYCLES 5000
+static void run_jnttrajgenerator(const JntLimits& l, const double *q, const double *target, long retarget,\
+                                 const double *retarget_to, JtgRun& r, double *arrival){
+    const double dt = 0.004;
+    JntTrajGenerator jtg(dt,l);
+    double tgt[7],out[7],q_last[7],v_last[7],a_last[7];
+    for(int i = 0; i < 7; i++){
+        tgt[i] = target[i];
+        q_last[i] = q[i];
+        v_last[i] = 0.0;
+        a_last[i] = 0.0;
+        arrival[i] = -1.0;
+    }
+    jtg.reset(q);
+    long deadline = -1;
+    for(long c = 0; c < JTG_CHECK_CYCLES; c++){
+        if((retarget_to != NULL) && (c == retarget)){
+            for(int i = 0; i < 7; i++){
+                tgt[i] = retarget_to[i];
+                arrival[i] = -1.0;
+            }
+            deadline = JTG_CHECK_CYCLES - 1;
+        }
+        jtg.step(tgt,out);
+        if(deadline < 0)
+            deadline = c + (long)ceil(jtg.get_sync_time()/dt) + JTG_CHECK_SLACK;
+        bool settled = true;
+        for(int i = 0; i < 7; i++){
+            double V = l.speedlimit*l.velocity_limits[i];
+            double A = l.speedlimit*l.accel_limits[i]/dt;
+            double J = l.speedlimit*l.jerk_limits[i]/(dt*dt);
+            double v = (out[i] - q_last[i])/dt;
+            double a = (v - v_last[i])/dt;
+            double j = (a - a_last[i])/dt;
+            //rounding of the differences, relative to the bound
+            if(fabs(v) > V*(1.0 + 1e-12)) r.vel++;
+            if(fabs(a) > A*(1.0 + 1e-9)) r.acc++;
+            if((c > 1) && (fabs(j) > J*(1.0 + 1e-6))) r.jerk++;
+            q_last[i] = out[i];
+            v_last[i] = v;
+            a_last[i] = a;
+            if((out[i] == tgt[i]) && (arrival[i] < 0))
+                arrival[i] = (c + 1)*dt;
+            if(out[i] != tgt[i])
+                settled = false;
+        }
+        if(c == deadline){
+            for(int i = 0; i < 7; i++){
+                if(out[i] != tgt[i]) r.late++;
+            }
+        }
+        //on the target before the deadline, nothing left to check
+        if(settled && ((retarget_to == NULL) || (c > retarget)))
+            break;
+    }
+}
+
+//!properties of JntTrajGenerator with the default limits of right_arm_param.xml
+void check_jnttrajgenerator(long cases){
+    JntLimits l;
+    JtgRun r = {0,0,0,0};
+    double arrival[7];
+    //a 1 rad move of every joint alone
+    for(int k = 0; k < 7; k++){
+        double q[7] = {0,0,0,0,0,0,0}, target[7] = {0,0,0,0,0,0,0};
+        target[k] = 1.0;
+        run_jnttrajgenerator(l,q,target,0,NULL,r,arrival);
+        std::cout<<"jnttrajgenerator_1rad_joint"<<k<<"_s,"<<arrival[k]<<std::endl;
+    }
+    //random moves of all joints, with a new target in the middle of the move
+    srand(5);
+    long moves = cases/100 + 1;
+    for(long c = 0; c < moves; c++){
+        double q[7],target[7],next[7];
+        for(int i = 0; i < 7; i++){
+            q[i] = 2.0*rand()/RAND_MAX - 1.0;
+            target[i] = 2.0*rand()/RAND_MAX - 1.0;
+            next[i] = 2.0*rand()/RAND_MAX - 1.0;
+        }
+        run_jnttrajgenerator(l,q,target,rand() % 200,next,r,arrival);
+    }
+    print_property("jnttrajgenerator_velocity_bound",moves + 7,r.vel);
+    print_property("jnttrajgenerator_accel_bound",moves + 7,r.acc);
+    print_property("jnttrajgenerator_jerk_bound",moves + 7,r.jerk);
+    print_property("jnttrajgenerator_arrives",moves + 7,r.late);
+}
+
+//!Util::euler2tm as it was before the closed form
+static Eigen::Matrix3d legacy_euler2tm(Eigen::Vector3d la,Eigen::Matrix3d tm){
+    Eigen::Matrix3d z,x,y;
+    z.setIdentity();
+    x.setIdentity();
+    y.setIdentity();
+    z(0,0) = cos(la(2)); z(0,1) = -sin(la(2)); z(1,0) = sin(la(2)); z(1,1) = cos(la(2));
+    x(1,1) = cos(la(0)); x(1,2) = -sin(la(0)); x(2,1) = sin(la(0)); x(2,2) = cos(la(0));
+    y(0,0) = cos(la(1)); y(0,2) = sin(la(1)); y(2,0) = -sin(la(1)); y(2,2) = cos(la(1));
+    return tm * z * y * x;
+}
+
+static Eigen::Matrix3d legacy_g_euler2tm(Eigen::Vector3d la,Eigen::Matrix3d tm){
+    Eigen::Matrix3d z,x,y;
+    z.setIdentity();
+    x.setIdentity();
+    y.setIdentity();
+    z(0,0) = cos(la(2)); z(0,1) = -sin(la(2)); z(1,0) = sin(la(2)); z(1,1) = cos(la(2));
+    x(1,1) = cos(la(0)); x(1,2) = -sin(la(0)); x(2,1) = sin(la(0)); x(2,2) = cos(la(0));
+    y(0,0) = cos(la(1)); y(0,2) = sin(la(1)); y(2,0) = -sin(la(1)); y(2,2) = cos(la(1));
+    return x * y * z * tm;
+}
+
+//!Util::tm2axisangle as it was before, acos and the antisymmetric part only
+static Eigen::Vector3d legacy_tm2axisangle(Eigen::Matrix3d tm){
+    Eigen::Vector3d omega;
+    double mtrace = std::max(-1.0,std::min(3.0,tm.trace()));
+    double theta = acos((mtrace-1)/2);
+    omega(0) = (tm(2,1) - tm(1,2));
+    omega(1) = (tm(0,2) - tm(2,0));
+    omega(2) = (tm(1,0) - tm(0,1));
+    omega *= (1.0/(2*sin(theta)));
+    return omega.normalized()*theta;
+}
+
+static Eigen::Matrix3d random_rotation(){
+    Eigen::Quaterniond q(Eigen::Vector4d::Random());
+    return q.normalized().toRotationMatrix();
+}
+
+//!rotation about a random axis by an angle in [lo,hi]
+static Eigen::Matrix3d random_rotation(double lo, double hi, Eigen::Vector3d& axis, double& theta){
+    axis = Eigen::Vector3d::Random().normalized();
+    theta = lo + (hi - lo)*rand()/RAND_MAX;
+    return Eigen::Matrix3d(Eigen::AngleAxisd(theta,axis));
+}
+
+//!the rotation a rotation vector stands for
+static Eigen::Matrix3d axisangle_tm(const Eigen::Vector3d& ax){
+    double theta = ax.norm();
+    if(theta == 0.0)
+        return Eigen::Matrix3d::Identity();
+    return Eigen::Matrix3d(Eigen::AngleAxisd(theta,ax/theta));
+}
+
+//!accuracy of the rotation conversions of Util, printed as property,cases,failures.
+//!The legacy lines show where the conversions before the closed forms failed.
+void check_rotations(long cases){
+    long f_e = 0, f_g = 0;
+    srand(2);
+    for(long c = 0; c < cases; c++){
+        Eigen::Vector3d la = M_PI*Eigen::Vector3d::Random();
+        Eigen::Matrix3d tm = random_rotation();
+        if(!((euler2tm(la,tm) - legacy_euler2tm(la,tm)).cwiseAbs().maxCoeff() <= 1e-12)) f_e++;
+        if(!((g_euler2tm(la,tm) - legacy_g_euler2tm(la,tm)).cwiseAbs().maxCoeff() <= 1e-12)) f_g++;
+    }
+    print_property("euler2tm_equals_legacy",cases,f_e);
+    print_property("g_euler2tm_equals_legacy",cases,f_g);
+
+    //the rotation vector reproduces the matrix, away from, close to 0 and close to pi
+    const double ranges[3][2] = {{0.0,M_PI},{0.0,1e-6},{M_PI - 1e-6,M_PI}};
+    const char *names[3][2] = {{"tm2axisangle_roundtrip","tm2axisangle_legacy_roundtrip"},\
+                               {"tm2axisangle_near_zero","tm2axisangle_legacy_near_zero"},\
+                               {"tm2axisangle_near_pi","tm2axisangle_legacy_near_pi"}};
+    for(int r = 0; r < 3; r++){
+        long f_new = 0, f_old = 0;
+        for(long c = 0; c < cases; c++){
+            Eigen::Vector3d axis;
+            double theta;
+            Eigen::Matrix3d tm = random_rotation(ranges[r][0],ranges[r][1],axis,theta);
+            //no rotation at all
+            if((r == 1) && (c == 0))
+                tm.setIdentity();
+            if(!((axisangle_tm(tm2axisangle(tm)) - tm).cwiseAbs().maxCoeff() <= 1e-9)) f_new++;
+            if(!((axisangle_tm(legacy_tm2axisangle(tm)) - tm).cwiseAbs().maxCoeff() <= 1e-9)) f_old++;
+        }
+        print_property(names[r][0],cases,f_new);
+        print_property(names[r][1],cases,f_old);
+    }
+
+    //q and the quaternion of its rotation vector are the same rotation
+    long f_q = 0;
+    for(long c = 0; c < cases; c++){
+        Eigen::Quaterniond q(Eigen::Vector4d::Random());
+        q.normalize();
+        Eigen::Quaterniond p = axisangle2quat(quat2axisangle(q));
+        if(!(fabs(fabs(p.dot(q)) - 1.0) <= 1e-12)) f_q++;
+    }
+    print_property("quat2axisangle_roundtrip",cases,f_q);
+}
+
+//!Util::_smooth_filter as it was before the streaming filters, copies and re-sums the window
+static double legacy_smooth_filter(std::deque<double> t){
+    double sum;
+    sum = 0;
+    for (std::deque<double>::iterator it = t.begin(); it!=t.end(); ++it)
+        sum+= *it;
+    return sum/t.size();
+}
+
+//!window of the moving average checks and benchmarks
+#define BENCH_FILTER_WINDOW 10
+
+//!the streaming filters against their direct definitions, printed as property,cases,failures
+void check_streamfilters(long cases){
+    typedef Eigen::Matrix<double,7,1> Vector7d;
+    srand(4);
+    //running sum against the mean of the window, over several wraps of the ring
+    MovingAverage<Vector7d,BENCH_FILTER_WINDOW> ma;
+    std::deque<Vector7d> window;
+    long f_ma = 0;
+    for(long c = 0; c < cases; c++){
+        Vector7d x = 100.0*Vector7d::Random();
+        window.push_back(x);
+        if(window.size() > BENCH_FILTER_WINDOW)
+            window.pop_front();
+        Vector7d mean = Vector7d::Zero();
+        for(size_t i = 0; i < window.size(); i++)
+            mean += window[i];
+        mean /= (double)window.size();
+        if(!((ma.add(x) - mean).cwiseAbs().maxCoeff() <= 1e-9)) f_ma++;
+    }
+    print_property("moving_average_equals_mean",cases,f_ma);
+
+    //median against a sorted copy of the window, with repeated values
+    MedianFilter<Eigen::Vector3d,5> md;
+    std::deque<Eigen::Vector3d> mwindow;
+    long f_md = 0;
+    for(long c = 0; c < cases; c++){
+        Eigen::Vector3d x;
+        for(int i = 0; i < 3; i++)
+            x(i) = rand() % 7;
+        mwindow.push_back(x);
+        if(mwindow.size() > 5)
+            mwindow.pop_front();
+        const Eigen::Vector3d& m = md.add(x);
+        for(int i = 0; i < 3; i++){
+            std::vector<double> v;
+            for(size_t k = 0; k < mwindow.size(); k++)
+                v.push_back(mwindow[k](i));
+            std::sort(v.begin(),v.end());
+            size_t n = v.size();
+            double expected = (n % 2) ? v[n/2] : 0.5*(v[n/2 - 1] + v[n/2]);
+            if(m(i) != expected){
+                f_md++;
+                break;
+            }
+        }
+    }
+    print_property("median_equals_sorted_window",cases,f_md);
+
+    //the one pole section is the former y = 0.5*(x + y_last) of RobotState
+    Biquad<Eigen::Vector3d> op;
+    op.set_one_pole(0.5);
+    Eigen::Vector3d y_last = Eigen::Vector3d::Zero();
+    long f_op = 0;
+    for(long c = 0; c < cases; c++){
+        Eigen::Vector3d x = Eigen::Vector3d::Random();
+        y_last = 0.5*(x + y_last);
+        if(!((op.add(x) - y_last).cwiseAbs().maxCoeff() <= 1e-12)) f_op++;
+    }
+    print_property("one_pole_equals_average",cases,f_op);
+
+    //a low pass started in the steady state of a constant stays there
+    long f_lp = 0;
+    for(long c = 0; c < cases; c++){
+        Biquad<Eigen::Matrix<double,6,1> > lp;
+        lp.set_lowpass(1.0 + 50.0*rand()/RAND_MAX,0.004);
+        Eigen::Matrix<double,6,1> x = 10.0*Eigen::Matrix<double,6,1>::Random();
+        lp.reset(x);
+        if(!((lp.add(x) - x).cwiseAbs().maxCoeff() <= 1e-9)) f_lp++;
+    }
+    print_property("biquad_lowpass_steady_state",cases,f_lp);
+
+    //a constant passes the one euro filter unchanged
+    OneEuroFilter<Eigen::Vector3d> oe(1.0,0.5,0.004);
+    Eigen::Vector3d x = Eigen::Vector3d::Random();
+    long f_oe = 0;
+    for(long c = 0; c < cases; c++){
+        if(!((oe.add(x) - x).cwiseAbs().maxCoeff() <= 1e-12)) f_oe++;
+    }
+    print_property("one_euro_constant",cases,f_oe);
+}
+
+//!restarts in the middle of streamed segments: a cycle before the next push holds
+//!the restart pose, the next segment starts there
+void check_trajqueue(long cases){
+    srand(5);
+    TrajQueue traj;
+    Eigen::Vector3d p;
+    Eigen::Quaterniond q;
+    Eigen::Quaterniond qr(Eigen::AngleAxisd(0.2,Eigen::Vector3d::UnitX()));
+    long f_hold = 0, f_start = 0;
+    for(long c = 0; c < cases; c++){
+        Eigen::Vector3d far = Eigen::Vector3d::Random();
+        traj.push_linear(far,Eigen::Quaterniond::Identity(),0.1 + 0.01*(rand() % 50));
+        traj.push_linear(-far,Eigen::Quaterniond::Identity(),0.5);
+        for(int k = rand() % 100; k >= 0; k--)
+            traj.sample(0.004,p,q);
+        Eigen::Vector3d pr = 0.1*Eigen::Vector3d::Random();
+        if(traj.restart(pr,qr) == false){
+            f_hold++;
+            continue;
+        }
+        traj.sample(0.004,p,q);
+        if(!(((p - pr).norm() <= 1e-12) && (q.angularDistance(qr) <= 1e-9))) f_hold++;
+        traj.push_linear(Eigen::Vector3d::Zero(),qr,1.0);
+        traj.sample(0.004,p,q);
+        if(!((p - pr).norm() <= 0.004*pr.norm() + 1e-12)) f_start++;
+    }
+    print_property("trajqueue_restart_holds_restart_pose",cases,f_hold);
+    print_property("trajqueue_restart_continuous",cases,f_start);
+}
+
+int main(int argc, char* argv[])
+{
+    std::string param_file = "right_arm_param.xml";
+    std::string baseline;
+    long iterations = 1000000;
+    int arg = 0;
+    for(int i = 1; i < argc; i++){
+        if((strcmp(argv[i],"-b") == 0) && (i + 1 < argc))
+            baseline = argv[++i];
+        else if(arg++ == 0)
+            param_file = argv[i];
+        else
+            iterations = atol(argv[i]);
+    }
+
+    ParamSet ps = load_param_set(param_file);
+    const ParameterManager& pm = *ps;
+    KukaSelfCtrlTask task(RLXP);
+    std::cout<<"kernel,iterations,ns_per_call,ns_min"<<std::endl;
+
+    //parsing the xml against the compiled cache the constructor above wrote
+    long loads = iterations/10000 + 1;
+    print_result("param_load_xml",loads,bench_ns([&](){
+        ParameterManager p(param_file,false);
+        bench_sink = p.stiff_ctrlpara.axis_stiffness[0];
+    },loads));
+    print_result("param_load_cache",loads,bench_ns([&](){
+        ParameterManager p(param_file);
+        bench_sink = p.stiff_ctrlpara.axis_stiffness[0];
+    },loads));
+
+    LegacyProLv legacy(pm);
+    print_result("proact_get_desired_lv_legacy",iterations,bench_ns([&](){
+        legacy.get_desired_lv(&task);
+        bench_sink = legacy.llv_pro(0);
+    },iterations));
+
+    ProActController pac(ps);
+    Eigen::Vector3d lv,ov;
+    print_result("proact_get_desired_lv",iterations,bench_ns([&](){
+        pac.get_desired_lv(NULL,&task);
+        pac.get_lv(lv,ov);
+        bench_sink = lv(0);
+    },iterations));
+
+    TacServoTask tac_task(CONTACT_POINT_FORCE_TRACKING);
+    myrmex_msg tacfb;
+    tacfb.cogx = 7.5;
+    tacfb.cogy = 8.5;
+    tacfb.contactnum = 1;
+    tacfb.contactflag = true;
+    tacfb.cf = 0.2;
+    tacfb.lineorien = M_PI/3;
+
+    LegacyTacLv legacy_tac(pm);
+    print_result("tacservo_get_desired_lv_legacy",iterations,bench_ns([&](){
+        legacy_tac.get_desired_lv(&tac_task,&tacfb);
+        legacy_tac.deltais_int.setZero();
+        bench_sink = legacy_tac.llv_tac(0);
+    },iterations));
+
+    TacServoController tsc(ps);
+    print_result("tacservo_get_desired_lv",iterations,bench_ns([&](){
+        tsc.get_desired_lv(NULL,&tac_task,&tacfb);
+        tsc.deltais_int.setZero();
+        tsc.get_lv(lv,ov);
+        bench_sink = lv(0);
+    },iterations));
+
+    //retargeting allocates a fresh pair, as the apps did before the pool
+    Eigen::Vector3d target(0.1,0.3,0.3);
+    long retarget_it = iterations/100 + 1;
+    ProActController *r_ac = new ProActController(ps);
+    KukaSelfCtrlTask *r_task = new KukaSelfCtrlTask(RP_NOCONTROL);
+    print_result("retarget_new_delete",retarget_it,bench_ns([&](){
+        delete r_ac;
+        delete r_task;
+        r_ac = new ProActController(ps);
+        r_task = new KukaSelfCtrlTask(RP_NOCONTROL);
+        r_task->mft = LOCALP2P;
+        r_task->set_desired_p_eigen(target);
+        bench_sink = r_task->velocity_p2p(0);
+    },retarget_it));
+    delete r_ac;
+    delete r_task;
+
+    CtrlPool pool(ps);
+    print_result("retarget_pool",iterations,bench_ns([&](){
+        int slot = pool.acquire();
+        pool.task(slot)->mft = LOCALP2P;
+        pool.task(slot)->set_desired_p_eigen(target);
+        pool.submit(slot);
+        pool.swap();
+        bench_sink = pool.active_task()->velocity_p2p(0);
+    },iterations));
+
+    //one control cycle of a streamed trajectory, a segment is refilled when one retires
+    TrajQueue traj;
+    Eigen::Quaterniond q0(Eigen::AngleAxisd(0.3,Eigen::Vector3d::UnitZ()));
+    Eigen::Quaterniond q1(Eigen::AngleAxisd(0.6,Eigen::Vector3d::UnitY()));
+    Eigen::Vector3d tp;
+    Eigen::Quaterniond tq;
+    traj.restart(target,q0);
+    bool forward = true;
+    print_result("trajqueue_sample",iterations,bench_ns([&](){
+        if(traj.end_time() - traj.time() < 0.5){
+            traj.push_spline(forward ? Eigen::Vector3d(0.2,0.3,0.3) : target,Eigen::Vector3d::Zero(),\
+                             forward ? q1 : q0,1.0);
+            forward = !forward;
+        }
+        traj.sample(0.004,tp,tq);
+        bench_sink = tp(0) + tq.w();
+    },iterations));
+
+    //joint smoothing of one cycle, the target jumps back and forth every 2s
+    double q_jnt[7] = {0,0,0,0,0,0,0};
+    double q_goal[7],q_next[7],dq[7];
+    long jnt_cycle = 0;
+    LegacyJntLimitFilter jlf_legacy(0.004);
+    print_result("jntlimitfilter_legacy",iterations,bench_ns([&](){
+        double sign = ((jnt_cycle++/500)%2) ? 1.0 : -1.0;
+        for(int i = 0; i < 7; i++)
+            dq[i] = sign*0.5 - q_jnt[i];
+        jlf_legacy.get_filtered_value(dq,q_next);
+        for(int i = 0; i < 7; i++)
+            q_jnt[i] += q_next[i];
+        bench_sink = q_jnt[0];
+    },iterations));
+
+    for(int i = 0; i < 7; i++)
+        q_jnt[i] = 0.0;
+    jnt_cycle = 0;
+    JntLimitFilter jlf(0.004,pm.jnt_limits);
+    print_result("jntlimitfilter",iterations,bench_ns([&](){
+        double sign = ((jnt_cycle++/500)%2) ? 1.0 : -1.0;
+        for(int i = 0; i < 7; i++)
+            dq[i] = sign*0.5 - q_jnt[i];
+        jlf.get_filtered_value(dq,q_next);
+        for(int i = 0; i < 7; i++)
+            q_jnt[i] += q_next[i];
+        bench_sink = q_jnt[0];
+    },iterations));
+
+    JntTrajGenerator jtg(0.004);
+    jtg.reset(q_jnt);
+    jnt_cycle = 0;
+    print_result("jnttrajgenerator",iterations,bench_ns([&](){
+        double sign = ((jnt_cycle++/500)%2) ? 1.0 : -1.0;
+        for(int i = 0; i < 7; i++)
+            q_goal[i] = sign*(0.5 - 0.1*i);
+        jtg.step(q_goal,q_next);
+        bench_sink = q_next[0];
+    },iterations));
+
+    //cartesian limiting of one cycle, the target pose jumps back and forth every 2s
+    CartLimiter cl(0.004,pm.cart_limits);
+    double c_goal[6],c_next[6];
+    long cart_cycle = 0;
+    print_result("cartlimiter",iterations,bench_ns([&](){
+        double sign = ((cart_cycle++/500)%2) ? 1.0 : -1.0;
+        for(int i = 0; i < 3; i++){
+            c_goal[i] = 0.3 + sign*0.1;
+            c_goal[i+3] = 0.5 + sign*0.2;
+        }
+        cl.limit(c_goal,c_next);
+        bench_sink = c_next[0];
+    },iterations));
+
+    //controller start after a measurement: handed to the control thread or inline in the callback
+    long handoff_cycles = iterations/100 + 1;
+    auto cycle_work = [&](){
+        double sign = ((cart_cycle++/500)%2) ? 1.0 : -1.0;
+        for(int i = 0; i < 3; i++){
+            c_goal[i] = 0.3 + sign*0.1;
+            c_goal[i+3] = 0.5 + sign*0.2;
+        }
+        cl.limit(c_goal,c_next);
+        for(int i = 0; i < 7; i++)
+            q_goal[i] = sign*(0.5 - 0.1*i);
+        jtg.step(q_goal,q_next);
+        bench_sink = c_next[0] + q_next[0];
+    };
+    print_result("cycle_handoff",handoff_cycles,bench_handoff_ns(cycle_work,handoff_cycles));
+    print_result("cycle_inline",handoff_cycles,bench_ns(cycle_work,handoff_cycles));
+
+    //cost of a trace point in the hot path, off and recording
+    long trace_cycle = 0;
+    Tracer::register_thread("bench");
+    Tracer::enable(false);
+    print_result("trace_scope_disabled",iterations,bench_ns([&](){
+        TRACE_SCOPE("bench");
+        bench_sink = trace_cycle++;
+    },iterations));
+    Tracer::enable(true);
+    print_result("trace_scope_enabled",iterations,bench_ns([&](){
+        TRACE_SCOPE("bench");
+        bench_sink = trace_cycle++;
+    },iterations));
+    Tracer::enable(false);
+    Tracer::clear();
+
+    //kinematics and the CBF step of a right arm on a detached node, the joints sweep slowly
+    const double q_home[7] = {0.0,0.5,0.0,-1.2,0.0,0.6,0.0};
+    ComOkc com(kuka_right,0.004f);
+    for(int i = 0; i < 7; i++){
+        com.jnt_position_act[i] = q_home[i];
+        com.jnt_position_mea[i] = q_home[i];
+    }
+    KukaLwr kuka(kuka_right,com);
+    KDL::JntArray q_kdl(7);
+    KDL::Frame frame;
+    KDL::Jacobian jac(7);
+    long kin_cycle = 0;
+    auto sweep = [&](){
+        double a = 0.1*sin(1e-3*kin_cycle++);
+        for(int i = 0; i < 7; i++)
+            q_kdl(i) = q_home[i] + a;
+    };
+    print_result("fk_world_to_tool",iterations,bench_ns([&](){
+        sweep();
+        kuka.worldToToolFkSolver->JntToCart(q_kdl,frame);
+        bench_sink = frame.p(0);
+    },iterations));
+    print_result("fk_base_to_tool",iterations,bench_ns([&](){
+        sweep();
+        kuka.baseToToolFkSolver->JntToCart(q_kdl,frame);
+        bench_sink = frame.p(0);
+    },iterations));
+    print_result("jacobian_world_to_tool",iterations,bench_ns([&](){
+        sweep();
+        kuka.worldToToolJacSolver->JntToJac(q_kdl,jac);
+        bench_sink = jac.data(0,0);
+    },iterations));
+
+    kuka.get_joint_position_act();
+    kuka.get_joint_position_mea();
+    kuka.update_robot_state();
+    CBF::FloatVector resource(7);
+    for(int i = 0; i < 7; i++)
+        resource(i) = q_home[i];
+    //every step starts from the same joint position, the reference is the current pose
+    print_result("cbf_step",iterations/10 + 1,bench_ns([&](){
+        kuka.kukaResourceP->set(resource);
+        kuka.primitiveControllerP->step();
+        bench_sink = kuka.kukaResourceP->get()(0);
+    },iterations/10 + 1));
+
+    RobotState rs(&kuka);
+    print_result("robotstate_updated",iterations/10 + 1,bench_ns([&](){
+        rs.updated(&kuka);
+        bench_sink = rs.position(0);
+    },iterations/10 + 1));
+
+    //rotation conversions of Util on slowly changing inputs
+    Eigen::Matrix3d tm_init = kuka.get_cur_cart_o();
+    Eigen::Vector3d euler,v_cur,v_des,ax;
+    long util_cycle = 0;
+    auto rotation = [&](){
+        double a = 1e-3*(util_cycle++ % 3000);
+        return Eigen::Matrix3d(Eigen::AngleAxisd(a,Eigen::Vector3d(0.3,-0.5,0.8).normalized()));
+    };
+    print_result("euler2tm_legacy",iterations,bench_ns([&](){
+        double a = 1e-3*(util_cycle++ % 3000);
+        euler << a,-0.5*a,0.25*a;
+        bench_sink = legacy_euler2tm(euler,tm_init)(0,0);
+    },iterations));
+    print_result("euler2tm",iterations,bench_ns([&](){
+        double a = 1e-3*(util_cycle++ % 3000);
+        euler << a,-0.5*a,0.25*a;
+        bench_sink = euler2tm(euler,tm_init)(0,0);
+    },iterations));
+    print_result("tm2axisangle_legacy",iterations,bench_ns([&](){
+        ax = legacy_tm2axisangle(rotation()*tm_init);
+        bench_sink = ax(0);
+    },iterations));
+    print_result("tm2axisangle",iterations,bench_ns([&](){
+        ax = tm2axisangle(rotation()*tm_init);
+        bench_sink = ax(0);
+    },iterations));
+    print_result("euler2axisangle_legacy",iterations,bench_ns([&](){
+        double a = 1e-3*(util_cycle++ % 3000);
+        euler << a,-0.5*a,0.25*a;
+        ax = legacy_tm2axisangle(legacy_euler2tm(euler,tm_init));
+        bench_sink = ax(0);
+    },iterations));
+    print_result("euler2axisangle",iterations,bench_ns([&](){
+        double a = 1e-3*(util_cycle++ % 3000);
+        euler << a,-0.5*a,0.25*a;
+        ax = euler2axisangle(euler,tm_init);
+        bench_sink = ax(0);
+    },iterations));
+    Eigen::Quaterniond q_init(tm_init);
+    print_result("quat2axisangle",iterations,bench_ns([&](){
+        double a = 1e-3*(util_cycle++ % 3000);
+        ax = quat2axisangle(Eigen::Quaterniond(Eigen::AngleAxisd(a,Eigen::Vector3d::UnitY()))*q_init);
+        bench_sink = ax(0);
+    },iterations));
+    print_result("tm2axisangle_4",iterations,bench_ns([&](){
+        bool b;
+        std::pair<Eigen::Vector3d,double> r_ax = tm2axisangle_4(rotation()*tm_init,b);
+        bench_sink = r_ax.second;
+    },iterations));
+    print_result("alignvec",iterations,bench_ns([&](){
+        v_cur = rotation()*Eigen::Vector3d::UnitZ();
+        v_des << 0.0,0.3,1.0;
+        bench_sink = AlignVec(v_cur,v_des)(0,0);
+    },iterations));
+
+    //filters of the force/torque, tactile and velocity signals, one sample per call
+    long filter_cycle = 0;
+    std::deque<double> smooth_window;
+    print_result("smooth_filter_legacy",iterations,bench_ns([&](){
+        smooth_window.push_back(sin(1e-3*(filter_cycle++)));
+        if(smooth_window.size() > BENCH_FILTER_WINDOW)
+            smooth_window.pop_front();
+        bench_sink = legacy_smooth_filter(smooth_window);
+    },iterations));
+    MovingAverage<double,BENCH_FILTER_WINDOW> ma;
+    print_result("moving_average",iterations,bench_ns([&](){
+        bench_sink = ma.add(sin(1e-3*(filter_cycle++)));
+    },iterations));
+    Biquad<Eigen::Matrix<double,6,1> > ft_lp;
+    ft_lp.set_lowpass(FT_FILTER_CUTOFF,0.004);
+    Eigen::Matrix<double,6,1> ft_in = Eigen::Matrix<double,6,1>::Random();
+    print_result("biquad_ft",iterations,bench_ns([&](){
+        ft_in(filter_cycle++ % 6) += 1e-3;
+        bench_sink = ft_lp.add(ft_in)(0);
+    },iterations));
+    MedianFilter<Eigen::Vector4d,TAC_MEDIAN_N> tac_md;
+    print_result("median_tactile",iterations,bench_ns([&](){
+        double a = 1e-3*(filter_cycle++ % 3000);
+        bench_sink = tac_md.add(Eigen::Vector4d(8.0 + sin(a),8.0 + cos(a),0.1*a,a))(0);
+    },iterations));
+    OneEuroFilter<Eigen::Vector3d> vel_oe(VEL_FILTER_MIN_CUTOFF,VEL_FILTER_BETA,0.004);
+    print_result("one_euro_vel",iterations,bench_ns([&](){
+        double a = 1e-3*(filter_cycle++ % 3000);
+        bench_sink = vel_oe.add(Eigen::Vector3d(sin(a),cos(a),a))(0);
+    },iterations));
+
+    check_jntlimitfilter(pm,iterations/10 + 1);
+    check_jnttrajgenerator(iterations/10 + 1);
+    check_rotations(iterations/10 + 1);
+    check_streamfilters(iterations/10 + 1);
+    check_trajqueue(iterations/10 + 1);
+    if((baseline.empty() == false) && (check_baseline(baseline) == false))
+        return 1;
+    return 0;
+}
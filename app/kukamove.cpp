@@ -13,6 +13,8 @@
 #include <thread>
 #include <unistd.h>
 #include <termios.h>
+#include <cstring>
+#include <atomic>
 
 #include "ComOkc.h"
 #include "KukaLwr.h"
@@ -21,18 +23,30 @@
 #include "kukaselfctrltask.h"
 #include "tacservocontroller.h"
 #include "tacservotask.h"
+#include "ctrlpipeline.h"
+#include "ctrlpool.h"
+#include "trajqueue.h"
 //#include "CtrlParam.h"
 #include "Timer.h"
 #include <fstream>
 #include "Util.h"
+#include "tracer.h"
+#include "cmdqueue.h"
+#include "paramwatcher.h"
+#include "posesnapshot.h"
 
-std::ofstream stiffness_data;
 ComOkc *com_okc;
 Robot *kuka_lwr;
 ActController *ac;
+CtrlPipeline *pipeline;
+CtrlPool *pool;
+TrajQueue *traj;
 Task *task;
 TaskNameT taskname;
-ParameterManager* pm;
+ParamSet pm;
+//!stiffness asked for by the commands, the shared parameter set is not changed
+stiffpara stiffness;
+ParamWatcher *param_watcher;
 #ifdef DJALLIL_CONF
 #define newP_x 0.28
 #define newP_y 0.5
@@ -51,10 +65,24 @@ ParameterManager* pm;
 #endif
 
 #define SAMPLEFREQUENCE 4
-
-char inp;
-
-RobotModeT rmt;
+//!the control loop looks at the keyboard commands at least this often without measurements (us)
+#define DATA_TIMEOUT_US 100000
+//!cartesian speed of movein_xyz (m/s)
+#define P2P_VELOCITY 0.05
+//!sine test: amplitude (m) and period (s) in x
+#define SINE_AMPLITUDE 0.1
+#define SINE_PERIOD 20.0
+//!the sine test keeps at least this much trajectory (s) queued
+#define TRAJ_LEAD 2.0
+
+int inp;
+//!key presses of the keyboard thread for the control loop
+CmdQueue cmds;
+
+//!written by the commands, read by the control cycle (the FRI callback with -inline)
+std::atomic<RobotModeT> rmt;
+//!pose of the last control cycle for the commands of the main thread
+PoseSnapshot cart_pose;
 KUKACTRLMODET kmt;
 
 int getch()
@@ -72,13 +100,22 @@ int getch()
 
 //The function we want to make the thread run.
 void keypresscap(void)
-{	char inp_tmp;
-    while(inp != 'e'){
+{	int inp_tmp = 0;
+    while((inp_tmp != 'e') && (inp_tmp != EOF)){
         inp_tmp = getch();
-            if ( inp_tmp != '\n' ) {
-            inp = inp_tmp;
-//            std::cout<<"in sub task loop, you input char "<<inp<<std::endl;
+        if(inp_tmp == 't'){
+            //toggle tracing, stopping writes the trace here and not on the control thread
+            if(Tracer::enabled()){
+                Tracer::enable(false);
+                Tracer::write_chrome_json(TRACE_FILE);
             }
+            else
+                Tracer::enable(true);
+        }
+        else if ( inp_tmp != '\n' ) {
+            if(cmds.push(inp_tmp) == false)
+                std::cout<<"command queue is full, dropped "<<(char)inp_tmp<<std::endl;
+        }
     }
 }
 
@@ -93,58 +130,98 @@ void moveto_cb(void){
     o(0) = newO_x;
     o(1) = newO_y;
     o(2) = newO_z;
-    delete ac;
-    delete task;
     for(int i = 0; i < 7; i++){
-        pm->stiff_ctrlpara.axis_stiffness[i] = 1000;
-        pm->stiff_ctrlpara.axis_damping[i] = 0.7;
+        stiffness.axis_stiffness[i] = 1000;
+        stiffness.axis_damping[i] = 0.7;
     }
     std::cout<<"change the stiffness"<<std::endl;
-    ac = new ProActController(*pm);
-    task = new KukaSelfCtrlTask(RP_NOCONTROL);
-    task->mt == JOINTS;
-    task->mft = GLOBAL;
-    task->set_desired_p_eigen(p);
-    task->set_desired_o_ax(o);
+    //prepare a preallocated pair, the control loop switches to it at the next cycle
+    int slot = pool->acquire();
+    if(slot < 0)
+        return;
+    KukaSelfCtrlTask *next_task = pool->task(slot);
+    next_task->mt = JOINTS;
+    next_task->mft = GLOBAL;
+    next_task->set_desired_p_eigen(p);
+    next_task->set_desired_o_ax(o);
+    pool->submit(slot);
     rmt = NormalMode;
 //    std::cout<<"robot self movement and move to new pose"<<std::endl;
 }
 
 void movein_xyz(float x, float y, float z){
-    Eigen::Vector3d cp, p, o;
+    Eigen::Vector3d cp, p;
 
     cp.setZero();
     p.setZero();
-    o.setZero();
 
-    cp = kuka_lwr->get_cur_cart_p();
-    o = tm2axisangle(kuka_lwr->get_cur_cart_o());
+    Eigen::Quaterniond q;
+    if(cart_pose.read(cp,q) == false){
+        std::cout<<"no control cycle yet, move ignored"<<std::endl;
+        return;
+    }
 
     p(0) = cp(0) + x;
     p(1) = cp(1) + y;
     p(2) = cp(2) + z;
 
-    delete ac;
-    delete task;
     for(int i = 0; i < 7; i++){
-        pm->stiff_ctrlpara.axis_stiffness[i] = 1000;
-        pm->stiff_ctrlpara.axis_damping[i] = 0.7;
+        stiffness.axis_stiffness[i] = 1000;
+        stiffness.axis_damping[i] = 0.7;
     }
     //std::cout<<"change the stiffness"<<std::endl;
-    ac = new ProActController(*pm);
-    task = new KukaSelfCtrlTask(RP_NOCONTROL);
-    task->mt == JOINTS;
-    task->mft = LOCALP2P;
-    task->velocity_p2p(0) = x/1.0;
-    task->velocity_p2p(1) = y/1.0;
-    task->velocity_p2p(2) = z/1.0;
-    task->set_initial_p_eigen(cp);
-    task->set_desired_p_eigen(p);
-    task->set_desired_o_ax(o);
+    //prepare a preallocated pair, the control loop switches to it at the next cycle
+    int slot = pool->acquire();
+    if(slot < 0)
+        return;
+    KukaSelfCtrlTask *next_task = pool->task(slot);
+    //timed by the control cycles, not by the speed of this loop
+    if(traj->restart(cp,q) == false){
+        std::cout<<"trajectory queue is full, move ignored"<<std::endl;
+        return;
+    }
+    traj->push_linear(p,q,(p-cp).norm()/P2P_VELOCITY);
+    next_task->mt = JOINTS;
+    next_task->mft = TRAJECTORY;
+    pool->submit(slot);
     rmt = NormalMode;
 //    std::cout<<"robot self movement and move to new pose"<<std::endl;
 }
 
+//!keep TRAJ_LEAD seconds of sine periods queued ahead of the control thread
+void stream_sine(){
+    Eigen::Vector3d amp;
+    amp.setZero();
+    amp(0) = -1 * SINE_AMPLITUDE;
+    while(traj->end_time() - traj->time() < TRAJ_LEAD){
+        if(traj->push_sinusoid(amp,1.0/SINE_PERIOD,0.0,SINE_PERIOD) == false)
+            break;
+    }
+}
+
+//!start the sine test in x around the current pose, false if it did not start
+bool start_sine(){
+    Eigen::Vector3d p;
+    Eigen::Quaterniond q;
+    if(cart_pose.read(p,q) == false){
+        std::cout<<"no control cycle yet, sine ignored"<<std::endl;
+        return false;
+    }
+    int slot = pool->acquire();
+    if(slot < 0)
+        return false;
+    if(traj->restart(p,q) == false){
+        std::cout<<"trajectory queue is full, sine ignored"<<std::endl;
+        return false;
+    }
+    stream_sine();
+    pool->task(slot)->mt = JOINTS;
+    pool->task(slot)->mft = TRAJECTORY;
+    pool->submit(slot);
+    rmt = NormalMode;
+    return true;
+}
+
 void psudog_cb(void){
     rmt = PsudoGravityCompensation;
 }
@@ -203,17 +280,24 @@ void switch_stiff_cb2(void){
         cp_damping[4] = 0.7;
         cp_damping[5] = 0.7;
 //        extft[1] = 20;
+        //the inline controller commands the robot from the callback meanwhile
+        com_okc->hold_inline();
         kuka_lwr->update_robot_cp_stiffness(cp_stiff,cp_damping);
+        com_okc->resume_inline();
     //    kuka_lwr->update_robot_cp_exttcpft(extft);
         std::cout<<"change stiffness"<<std::endl;
 
 }
 
 void switch_cpstiff_mode(){
+    //the brake waits for callback cycles, so the switch can not run in the control
+    //cycle. The inline controller is held and the measured position commanded instead.
+    com_okc->hold_inline();
     com_okc->start_brake();
     switch_stiff_cb1();
     kuka_lwr->switch2cpcontrol();
     com_okc->release_brake();
+    com_okc->resume_inline();
 }
 
 Timer tHello([]()
@@ -248,7 +332,6 @@ Timer tHello([]()
 //        pm->stiff_ctrlpara.axis_stiffness[i] = K_axis(i,i);
 //        pm->stiff_ctrlpara.axis_damping[i] = 0.7;
 //    }
-//    stiffness_data<<K_axis(0,0)<<","<<K_axis(1,1)<<","<<K_axis(2,2)<<","<<K_axis(3,3)<<","<<K_axis(4,4)<<","<<K_axis(5,5)<<std::endl;
 //    std::cout<<"change the stiffness"<<std::endl;
 //    std::cout<<"stiffness are "<<std::endl;std::cout<<K_axis<<std::endl;
 //    std::cout<<"Jacobian are "<<std::endl;std::cout<<J_eigen<<std::endl;
@@ -258,6 +341,35 @@ int counter = 0;
 int counter1 = 0;
 
 
+//!one control cycle on the latest measurement, on the main thread or inline in the callback
+void control_cycle(){
+    TRACE_SCOPE("control_cycle");
+    kuka_lwr->get_joint_position_act();
+    kuka_lwr->get_joint_position_mea();
+    kuka_lwr->update_robot_state();
+    cart_pose.publish(kuka_lwr->get_cur_cart_p(),Eigen::Quaterniond(kuka_lwr->get_cur_cart_o()));
+    //parameters retuned in the xml file are taken over at the cycle boundary
+    ParamSet np = param_watcher->poll();
+    if(np){
+        pool->set_params(np);
+        kuka_lwr->set_jnt_limits(np->jnt_limits);
+        kuka_lwr->set_cart_limits(np->cart_limits);
+    }
+    //take over a retargeted controller/task pair at the cycle boundary
+    if(pool->swap()){
+        ac = pool->active_controller();
+        task = pool->active_task();
+        pipeline->update_stage(PRO_STAGE,ac,task);
+        pipeline->reset();
+    }
+    //using all kinds of controllers to update the reference
+    if(task->mt == JOINTS)
+        pipeline->run(kuka_lwr);
+    //use CBF to compute the desired joint angle rate
+    kuka_lwr->update_cbf_controller();
+    kuka_lwr->set_joint_command(rmt.load());
+}
+
 void run(){
     //only call for this function, the ->jnt_position_act is updated
     if((com_okc->data_available == true)&&(com_okc->controller_update == false)){
@@ -304,20 +416,9 @@ void run(){
 //            pm->stiff_ctrlpara.axis_damping[i] = 0.7;
 //        }
 //        K_cart = (J_eigen*K_axis_diag.inverse()*J_eigen.transpose()).inverse();
-//        stiffness_data<<K_axis(0,0)<<","<<K_axis(1,1)<<","<<K_axis(2,2)<<","<<K_axis(3,3)<<","<<K_axis(4,4)<<","<<K_axis(5,5);
 
         //kuka_lwr->update_robot_stiffness(pm);
-        kuka_lwr->get_joint_position_act();
-        kuka_lwr->get_joint_position_mea();
-        kuka_lwr->update_robot_state();
-        //using all kinds of controllers to update the reference
-        if(task->mt == JOINTS)
-            ac->update_robot_reference(kuka_lwr,task);
-        ac->llv.setZero();
-        ac->lov.setZero();
-        //use CBF to compute the desired joint angle rate
-        kuka_lwr->update_cbf_controller();
-        kuka_lwr->set_joint_command(rmt);
+        control_cycle();
         com_okc->controller_update = true;
 //        counter++;
 //        if(counter >=25){
@@ -330,19 +431,30 @@ void run(){
 //        intervaltime = timeval_diff(NULL,&v_cur,&v_old);
 //        std::cout<<"stiffness are in J"<<std::endl;std::cout<<K_axis<<std::endl;
 //        std::cout<<"stiffness are in C"<<std::endl;std::cout<<K_cart<<std::endl;
-        //stiffness_data<<","<<intervaltime<<std::endl;
         //std::cout<<"interval is "<<intervaltime<<std::endl;
     }
 }
 
 void init(){
-    pm = new ParameterManager("right_arm_param.xml");
+    pm = load_param_set("right_arm_param.xml");
+    stiffness = pm->stiff_ctrlpara;
     kmt = JNT_IMP;
     com_okc = new ComOkc(kuka_right,OKC_HOST,OKC_PORT,JNT_IMP);
     com_okc->connect();
     kuka_lwr = new KukaLwr(kuka_right,*com_okc);
-    ac = new ProActController(*pm);
-    task = new KukaSelfCtrlTask(RP_NOCONTROL);
+    kuka_lwr->set_jnt_limits(pm->jnt_limits);
+    kuka_lwr->set_jnt_smoothing(pm->jnt_smoothing);
+    kuka_lwr->set_cart_limits(pm->cart_limits);
+    pool = new CtrlPool(pm);
+    param_watcher = new ParamWatcher("right_arm_param.xml");
+    param_watcher->start();
+    traj = new TrajQueue();
+    for(int i = 0; i < CTRL_POOL_SIZE; i++)
+        pool->controller(i)->attach_trajectory(traj);
+    ac = pool->active_controller();
+    task = pool->active_task();
+    pipeline = new CtrlPipeline();
+    pipeline->set_stage(PRO_STAGE,ac,task);
     Eigen::Vector3d p,o;
     p.setZero();
     o.setZero();
@@ -355,26 +467,31 @@ void init(){
     o(2) = newO_z;
     task->set_desired_p_eigen(p);
     task->set_desired_o_ax(o);
-    kuka_lwr->setAxisStiffnessDamping(ac->pm.stiff_ctrlpara.axis_stiffness, \
-                                           ac->pm.stiff_ctrlpara.axis_damping);
+    kuka_lwr->setAxisStiffnessDamping(stiffness.axis_stiffness, \
+                                           stiffness.axis_damping);
     rmt = NormalMode;
     tHello.setSingleShot(false);
-    tHello.setInterval(Timer::Interval(SAMPLEFREQUENCE));
+    tHello.setInterval(std::chrono::milliseconds(SAMPLEFREQUENCE));
     tHello.start(true);
 }
 
 int main(int argc, char* argv[])
 {
 
-    int sinCounter = 0;
-    float teta = 0;
     bool sinOn = false;
     double step = 0.1;
+    //-inline runs the controller in the FRI callback instead of this thread
+    bool inline_ctrl = (argc > 1) && (strcmp(argv[1],"-inline") == 0);
     std::thread t1(keypresscap);
-    stiffness_data.open("/tmp/stiff.txt");
     inp = 'f';
     init();
+    Tracer::register_thread("control");
+    if(inline_ctrl)
+        com_okc->set_inline_controller(control_cycle);
     while(inp != 'e' && inp != EOF){
+        int cmd;
+        if(cmds.pop(cmd))
+            inp = cmd;
         switch (inp){
 
         case 'g':
@@ -407,6 +524,10 @@ int main(int argc, char* argv[])
             break;
         case 'l':
             sinOn = !sinOn;
+            if(sinOn)
+                sinOn = start_sine();
+            else
+                movein_xyz(0.0, 0.0, 0.0);
             inp = '\n';
             break;
         case '\n':
@@ -415,20 +536,32 @@ int main(int argc, char* argv[])
 
             break;
         }
-        if(sinOn){
-            sinCounter = sinCounter + 1;
-            if (sinCounter == 250){
-                teta = teta + 0.01;
-                movein_xyz(-0.1 * sin(teta), 0.0, 0.0);
-                sinCounter = 0;
-                //std::cout<<"teta = "<< sin(teta)<<std::endl;
-            }
-        }
-        run();
-        usleep(20);
+        if(sinOn)
+            stream_sine();
+        //block until the callback publishes the next measurement
+        if(com_okc->is_inline())
+            usleep(1000*SAMPLEFREQUENCE);
+        else if(com_okc->wait_for_data(DATA_TIMEOUT_US))
+            run();
 }
     std::cout<<"main function is end "<<std::endl;
+    if(com_okc->is_inline()){
+        com_okc->clear_inline_controller();
+        const InlineStats& is = com_okc->inline_stats();
+        std::cout<<"inline controller: "<<is.cycles<<" cycles, "<<is.overruns<<" over budget, "\
+                 <<is.run_mean<<"/"<<is.run_max<<" us mean/max"<<std::endl;
+    }
     tHello.stop();
+    ParamWatchStats ps = param_watcher->stats();
+    std::cout<<"parameter reload: "<<ps.reloads<<" reloads, "<<ps.rejected<<" rejected"<<std::endl;
+    TimerStats ts = tHello.stats();
+    std::cout<<"timer: "<<ts.cycles<<" cycles, "<<ts.overruns<<" overruns, latency "<<ts.latency_mean<<"/"\
+             <<ts.latency_max<<" us mean/max, callback "<<ts.run_mean<<"/"<<ts.run_max<<" us mean/max"<<std::endl;
+    const DataWaitStats& ws = com_okc->wait_stats();
+    std::cout<<"control start after a measurement: "<<ws.wakeups<<" cycles, "<<ws.timeouts<<" timeouts, latency "\
+             <<ws.latency_mean<<"/"<<ws.latency_max<<" us mean/max"<<std::endl;
+    //flushes the cycle log
+    delete kuka_lwr;
     t1.join();
     std::cout<<"keypress thread is end "<<std::endl;
 }
@@ -0,0 +1,52 @@
+/*
+ ============================================================================
+ Name        : kukareplay.cpp
+ Author      : Qiang Li
+ Version     :
+ Copyright   : Copyright Qiang Li, Universität Bielefeld
+ Description : Replays a recorded cycle log through the controller stack as
+               fast as possible and compares the commands with the recording.
+               usage: kukareplay session.kslog [param.xml] [-o replay.kslog]
+ ============================================================================
+ */
+
+#include <iostream>
+#include <cstring>
+#include <string>
+
+#include "replay.h"
+
+int main(int argc, char* argv[])
+{
+    std::string param = "right_arm_param.xml";
+    std::string out;
+    if(argc < 2){
+        std::cout<<"usage: kukareplay session.kslog [param.xml] [-o replay.kslog]"<<std::endl;
+        return 1;
+    }
+    for(int i = 2; i < argc; i++){
+        if((strcmp(argv[i],"-o") == 0) && (i + 1 < argc))
+            out = argv[++i];
+        else
+            param = argv[i];
+    }
+    Replay replay(param);
+    if(replay.open(argv[1]) == false)
+        return 1;
+    if(out.empty() == false)
+        replay.log_to(out);
+    ReplayStats stats;
+    if(replay.run(stats) == false){
+        std::cout<<"replay of "<<argv[1]<<" failed"<<std::endl;
+        return 1;
+    }
+    std::cout<<"cycles "<<stats.cycles<<" at "<<replay.get_cycle_time()<<"s, task switches "<<stats.task_switches<<std::endl;
+    std::cout<<"max joint command difference "<<stats.max_jnt_diff<<", max cartesian reference difference "<<stats.max_cart_diff<<std::endl;
+    if(stats.first_divergent < 0)
+        std::cout<<"the replay matches the recording"<<std::endl;
+    else
+        std::cout<<stats.divergent<<" divergent cycles, the first is row "<<stats.first_divergent<<std::endl;
+    std::cout<<"wall time "<<stats.wall_time<<"s, "<<1e9*stats.wall_time/stats.cycles<<" ns per cycle, "\
+             <<stats.cycles*replay.get_cycle_time()/stats.wall_time<<"x real time"<<std::endl;
+    return (stats.first_divergent < 0) ? 0 : 2;
+}
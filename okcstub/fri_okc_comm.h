@@ -0,0 +1,38 @@
+#ifndef FRI_OKC_COMM_H
+#define FRI_OKC_COMM_H
+#include "fri_okc_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+okc_handle_t* okc_start_server(const char* hostname, const char* port, int cbmode);
+int okc_is_robot_avail(okc_handle_t* okc, int robot_id);
+int okc_get_robot_name(okc_handle_t* okc, int robot_id, char* name, int len);
+int okc_get_cycle_time(okc_handle_t* okc, int robot_id, float* cycle_time);
+int okc_get_connection_quality(okc_handle_t* okc, int robot_id, int* quality);
+int okc_sleep_cycletime(okc_handle_t* okc, int robot_id);
+
+int okc_is_robot_in_command_mode(okc_handle_t* okc, int robot_id);
+int okc_request_command_mode(okc_handle_t* okc, int robot_id);
+int okc_request_monitor_mode(okc_handle_t* okc, int robot_id);
+int okc_switch_to_axis_impedance(okc_handle_t* okc, int robot_id);
+int okc_switch_to_cp_impedance(okc_handle_t* okc, int robot_id);
+int okc_switch_to_position(okc_handle_t* okc, int robot_id);
+int okc_alter_cmdFlags(okc_handle_t* okc, int robot_id, int flags);
+int okc_alter_cbmode(okc_handle_t* okc, int robot_id, int cbmode);
+
+int okc_register_axis_set_absolute_callback(okc_handle_t* okc, int robot_id, okc_callback_axis_t cb, void* priv);
+int okc_register_cartpos_axis_set_absolute_callback(okc_handle_t* okc, int robot_id, okc_callback_cartpos_axis_t cb, void* priv);
+
+int okc_get_jntpos_act(okc_handle_t* okc, int robot_id, fri_float_t* pos);
+int okc_get_ft_tcp_est(okc_handle_t* okc, int robot_id, coords_t* ft);
+int okc_set_axis_stiffness_damping(okc_handle_t* okc, int robot_id, lbr_axis_t stiffness, lbr_axis_t damping);
+int okc_set_cp_stiffness_damping(okc_handle_t* okc, int robot_id, coords_t stiffness, coords_t damping);
+int okc_set_cp_addTcpFT(okc_handle_t* okc, int robot_id, coords_t ft);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // FRI_OKC_COMM_H
@@ -0,0 +1,19 @@
+#ifndef FRI_OKC_HELPER_H
+#define FRI_OKC_HELPER_H
+#include "fri_okc_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//!copy LBR_MNJ joint values
+void okc_cp_lbr_mnj(const fri_float_t* src, fri_float_t* dst);
+//!copy a FRI_CART_FRM_DIM frame
+void okc_cp_cart_frm_dim(const fri_float_t* src, fri_float_t* dst);
+void okc_print_lbr_mnj(const fri_float_t* v);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // FRI_OKC_HELPER_H
@@ -0,0 +1,40 @@
+#ifndef FRI_OKC_TYPES_H
+#define FRI_OKC_TYPES_H
+//!types of libopenkcfri as far as the controller uses them, see okcstub.h
+#include "fricomm.h"
+
+#define OKC_OK 0
+#define OKC_ERR -1
+//!robots one server can handle
+#define OKC_MAX_ROBOTS 4
+
+//!which callback the server calls every cycle
+enum{
+    OKC_MODE_CALLBACK_AXIS_ABS = 1,
+    OKC_MODE_CALLBACK_POS_AXIS_ABS = 2
+};
+
+//!command flags sent to the robot controller
+enum{
+    OKC_CMD_FLAGS_AXIS_IMPEDANCE_MODE = 1,
+    OKC_CMD_FLAGS_CP_AXIS_IMPEDANCE_MODE = 2,
+    OKC_CMD_FLAGS_POSITION_CONTROL_MODE = 3
+};
+
+typedef struct okc_handle okc_handle_t;
+
+typedef struct{
+    fri_float_t x,y,z,a,b,c;
+} coords_t;
+
+typedef struct{
+    fri_float_t a1,a2,e1,a3,a4,a5,a6;
+} lbr_axis_t;
+
+//!joint positions in, new joint positions out
+typedef int (*okc_callback_axis_t)(void* priv, const fri_float_t* pos_act, fri_float_t* new_pos);
+//!cartesian frame and joint positions in, new frame and joint positions out
+typedef int (*okc_callback_cartpos_axis_t)(void* priv, const fri_float_t* cartpos_act, fri_float_t* axispos_act,\
+                                           fri_float_t* new_cartpos, fri_float_t* new_axispos);
+
+#endif // FRI_OKC_TYPES_H
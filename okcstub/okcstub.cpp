@@ -0,0 +1,486 @@
+#include "okcstub.h"
+#include "fri_okc_helper.h"
+#include "ComInterface.h"
+#include <iostream>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <random>
+#include <string>
+#include <sstream>
+#include <cstdlib>
+#include <cstring>
+#include <stdint.h>
+#include <time.h>
+
+//!robot slots the arms of ComInterface.h are served in, the ids ComOkc expects
+#define OKC_STUB_LEFT_ID 1
+#define OKC_STUB_RIGHT_ID 2
+#define OKC_STUB_NAME_LEN 64
+
+struct OkcStubRobot{
+    char name[OKC_STUB_NAME_LEN];
+    bool avail;
+    int state;
+    int quality;
+    //!cycles left of a quality drop
+    long drop_left;
+    int cbmode;
+    int cmd_flags;
+    int ctrl;
+    //!commanded joints, the plant state and the measured joints
+    fri_float_t cmd[LBR_MNJ];
+    double q[LBR_MNJ];
+    fri_float_t mea[LBR_MNJ];
+    //!the stub has no kinematics, the frame is handed back unchanged
+    fri_float_t cart[FRI_CART_FRM_DIM];
+    coords_t ft;
+    coords_t add_ft;
+    lbr_axis_t stiffness;
+    lbr_axis_t damping;
+    coords_t cp_stiffness;
+    coords_t cp_damping;
+    okc_callback_axis_t axis_cb;
+    void *axis_priv;
+    okc_callback_cartpos_axis_t cart_cb;
+    void *cart_priv;
+};
+
+struct okc_handle{
+    okc_stub_config_t cfg;
+    OkcStubRobot robots[OKC_MAX_ROBOTS];
+    okc_stub_stats_t stats;
+    uint64_t tick;
+    std::mutex mutex;
+    std::condition_variable tick_cv;
+    std::atomic<bool> running;
+    std::thread clock;
+    //!faults and noise of the clock thread, command mode refusals
+    std::mt19937 rng;
+    std::mt19937 request_rng;
+};
+
+static bool configured = false;
+static okc_stub_config_t next_cfg;
+static okc_handle_t *server = NULL;
+
+static double env_double(const char *name, double def){
+    const char *v = getenv(name);
+    return (v != NULL) ? atof(v) : def;
+}
+
+static long env_long(const char *name, long def){
+    const char *v = getenv(name);
+    return (v != NULL) ? atol(v) : def;
+}
+
+static int64_t now_ns(){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC,&ts);
+    return (int64_t)ts.tv_sec*1000000000LL + ts.tv_nsec;
+}
+
+static void sleep_until(int64_t t_ns){
+    struct timespec ts;
+    ts.tv_sec = t_ns/1000000000LL;
+    ts.tv_nsec = t_ns%1000000000LL;
+    while(clock_nanosleep(CLOCK_MONOTONIC,TIMER_ABSTIME,&ts,NULL) != 0);
+}
+
+static OkcStubRobot* robot(okc_handle_t *okc, int robot_id){
+    if((okc == NULL) || (robot_id < 0) || (robot_id >= OKC_MAX_ROBOTS) || (okc->robots[robot_id].avail == false))
+        return NULL;
+    return &okc->robots[robot_id];
+}
+
+void okc_stub_default_config(okc_stub_config_t* cfg){
+    const fri_float_t q0[LBR_MNJ] = {0.0,0.5,0.0,-1.2,0.0,0.6,0.0};
+    cfg->cycle_time = env_double("OKC_STUB_CYCLE_TIME",0.004);
+    cfg->free_run = env_long("OKC_STUB_FREE_RUN",0);
+    const char *plant = getenv("OKC_STUB_PLANT");
+    cfg->plant = ((plant != NULL) && (strcmp(plant,"lag") == 0)) ? OKC_STUB_LAG : OKC_STUB_IDEAL;
+    cfg->tau = env_double("OKC_STUB_TAU",0.02);
+    cfg->noise = env_double("OKC_STUB_NOISE",0.0);
+    cfg->ft_noise = env_double("OKC_STUB_FT_NOISE",0.0);
+    cfg->late = env_double("OKC_STUB_LATE",0.0);
+    cfg->late_us = env_long("OKC_STUB_LATE_US",(long)(2e6*cfg->cycle_time));
+    cfg->drop = env_double("OKC_STUB_DROP",0.0);
+    cfg->drop_cycles = env_long("OKC_STUB_DROP_CYCLES",50);
+    cfg->drop_quality = env_long("OKC_STUB_DROP_QUALITY",FRI_QUALITY_BAD);
+    cfg->refuse = env_double("OKC_STUB_REFUSE",0.0);
+    cfg->seed = env_long("OKC_STUB_SEED",1);
+    for(int i = 0; i < LBR_MNJ; i++)
+        cfg->q0[i] = q0[i];
+    const char *v = getenv("OKC_STUB_Q0");
+    if(v != NULL){
+        std::stringstream ss(v);
+        std::string item;
+        for(int i = 0; (i < LBR_MNJ) && std::getline(ss,item,','); i++)
+            cfg->q0[i] = atof(item.c_str());
+    }
+}
+
+void okc_stub_configure(const okc_stub_config_t* cfg){
+    next_cfg = *cfg;
+    configured = true;
+}
+
+//!one KRC cycle: faults, callbacks, plant
+static void run_cycle(okc_handle_t *okc){
+    std::uniform_real_distribution<double> uniform(0.0,1.0);
+    std::normal_distribution<double> gauss(0.0,1.0);
+    fri_float_t pos_act[OKC_MAX_ROBOTS][LBR_MNJ];
+    fri_float_t new_pos[OKC_MAX_ROBOTS][LBR_MNJ];
+    fri_float_t cart_act[OKC_MAX_ROBOTS][FRI_CART_FRM_DIM];
+    fri_float_t new_cart[OKC_MAX_ROBOTS][FRI_CART_FRM_DIM];
+    OkcStubRobot cb[OKC_MAX_ROBOTS];
+    bool late;
+    {
+        std::lock_guard<std::mutex> lock(okc->mutex);
+        late = (okc->cfg.late > 0.0) && (uniform(okc->rng) < okc->cfg.late);
+        if(late)
+            okc->stats.late++;
+        for(int r = 0; r < OKC_MAX_ROBOTS; r++){
+            OkcStubRobot& rb = okc->robots[r];
+            if(rb.avail == false)
+                continue;
+            if((rb.drop_left == 0) && (okc->cfg.drop > 0.0) && (uniform(okc->rng) < okc->cfg.drop)){
+                rb.drop_left = okc->cfg.drop_cycles;
+                okc->stats.drops++;
+            }
+            if(rb.drop_left > 0){
+                rb.quality = okc->cfg.drop_quality;
+                if((rb.quality < FRI_QUALITY_BAD) && (rb.state == FRI_STATE_CMD))
+                    rb.state = FRI_STATE_MON;
+                if(--rb.drop_left == 0)
+                    rb.quality = FRI_QUALITY_PERFECT;
+            }
+            okc_cp_lbr_mnj(rb.cmd,pos_act[r]);
+            okc_cp_lbr_mnj(rb.cmd,new_pos[r]);
+            okc_cp_cart_frm_dim(rb.cart,cart_act[r]);
+            okc_cp_cart_frm_dim(rb.cart,new_cart[r]);
+            cb[r] = rb;
+        }
+    }
+    if(late)
+        sleep_until(now_ns() + 1000LL*okc->cfg.late_us);
+
+    //the callbacks read the robot state through the api, the lock is not held
+    for(int r = 0; r < OKC_MAX_ROBOTS; r++){
+        if(okc->robots[r].avail == false)
+            continue;
+        if((cb[r].cbmode == OKC_MODE_CALLBACK_AXIS_ABS) && (cb[r].axis_cb != NULL))
+            cb[r].axis_cb(cb[r].axis_priv,pos_act[r],new_pos[r]);
+        if((cb[r].cbmode == OKC_MODE_CALLBACK_POS_AXIS_ABS) && (cb[r].cart_cb != NULL))
+            cb[r].cart_cb(cb[r].cart_priv,cart_act[r],pos_act[r],new_cart[r],new_pos[r]);
+    }
+
+    std::lock_guard<std::mutex> lock(okc->mutex);
+    double dt = okc->cfg.cycle_time;
+    for(int r = 0; r < OKC_MAX_ROBOTS; r++){
+        OkcStubRobot& rb = okc->robots[r];
+        if(rb.avail == false)
+            continue;
+        if(rb.state == FRI_STATE_CMD){
+            okc_cp_lbr_mnj(new_pos[r],rb.cmd);
+            okc_cp_cart_frm_dim(new_cart[r],rb.cart);
+        }
+        for(int i = 0; i < LBR_MNJ; i++){
+            if(okc->cfg.plant == OKC_STUB_LAG)
+                rb.q[i] += dt/(okc->cfg.tau + dt)*(rb.cmd[i] - rb.q[i]);
+            else
+                rb.q[i] = rb.cmd[i];
+            rb.mea[i] = rb.q[i] + okc->cfg.noise*gauss(okc->rng);
+        }
+        //in monitor mode the command follows the robot
+        if(rb.state != FRI_STATE_CMD){
+            for(int i = 0; i < LBR_MNJ; i++)
+                rb.cmd[i] = rb.q[i];
+        }
+        fri_float_t *ft = &rb.ft.x;
+        for(int i = 0; i < FRI_CART_VEC; i++)
+            ft[i] = okc->cfg.ft_noise*gauss(okc->rng);
+    }
+    okc->stats.cycles++;
+    okc->tick++;
+    okc->tick_cv.notify_all();
+}
+
+static void clock_thread(okc_handle_t *okc){
+    int64_t period = (int64_t)(1e9*okc->cfg.cycle_time);
+    int64_t next = now_ns() + period;
+    while(okc->running.load()){
+        if(okc->cfg.free_run == 0)
+            sleep_until(next);
+        run_cycle(okc);
+        next += period;
+        int64_t now = now_ns();
+        if((okc->cfg.free_run == 0) && (now > next)){
+            //like the KRC the missed packets are gone, the next cycle is in phase again
+            std::lock_guard<std::mutex> lock(okc->mutex);
+            okc->stats.overruns++;
+            next += ((now - next)/period + 1)*period;
+        }
+    }
+}
+
+static void stop_at_exit(){
+    if(server != NULL)
+        okc_stub_stop_server(server);
+}
+
+okc_handle_t* okc_start_server(const char* hostname, const char* port, int cbmode){
+    if(server != NULL)
+        return NULL;
+    okc_handle_t *okc = new okc_handle_t;
+    if(configured)
+        okc->cfg = next_cfg;
+    else
+        okc_stub_default_config(&okc->cfg);
+    if(okc->cfg.cycle_time <= 0.0f)
+        okc->cfg.cycle_time = 0.004f;
+    memset(&okc->stats,0,sizeof(okc->stats));
+    memset(okc->robots,0,sizeof(okc->robots));
+    const char *left = getenv("OKC_STUB_LEFT");
+    const char *right = getenv("OKC_STUB_RIGHT");
+    strncpy(okc->robots[OKC_STUB_LEFT_ID].name,(left != NULL) ? left : LEFTARM_IP,OKC_STUB_NAME_LEN-1);
+    strncpy(okc->robots[OKC_STUB_RIGHT_ID].name,(right != NULL) ? right : RIGHTARM_IP,OKC_STUB_NAME_LEN-1);
+    for(int r = 0; r < OKC_MAX_ROBOTS; r++){
+        OkcStubRobot& rb = okc->robots[r];
+        rb.avail = (rb.name[0] != '\0');
+        rb.state = FRI_STATE_MON;
+        rb.quality = FRI_QUALITY_PERFECT;
+        rb.cbmode = cbmode;
+        rb.cmd_flags = OKC_CMD_FLAGS_POSITION_CONTROL_MODE;
+        rb.ctrl = FRI_CTRL_POSITION;
+        for(int i = 0; i < LBR_MNJ; i++){
+            rb.cmd[i] = okc->cfg.q0[i];
+            rb.q[i] = okc->cfg.q0[i];
+            rb.mea[i] = okc->cfg.q0[i];
+        }
+        //identity rotation, the frame is row major 3x4
+        rb.cart[0] = rb.cart[5] = rb.cart[10] = 1.0;
+    }
+    okc->tick = 0;
+    okc->rng.seed(okc->cfg.seed);
+    okc->request_rng.seed(okc->cfg.seed + 1);
+    okc->running.store(true);
+    okc->clock = std::thread(clock_thread,okc);
+    server = okc;
+    atexit(stop_at_exit);
+    std::cout<<"okc stub: serving "<<hostname<<":"<<port<<", cycle time "<<okc->cfg.cycle_time<<"s"<<std::endl;
+    return okc;
+}
+
+void okc_stub_stop_server(okc_handle_t* okc){
+    if(okc == NULL)
+        return;
+    okc->running.store(false);
+    if(okc->clock.joinable())
+        okc->clock.join();
+    okc_stub_stats_t s = okc->stats;
+    std::cout<<"okc stub: "<<s.cycles<<" cycles, "<<s.late<<" late, "<<s.drops<<" quality drops, "\
+             <<s.refusals<<" refusals, "<<s.overruns<<" overruns"<<std::endl;
+    if(server == okc)
+        server = NULL;
+    delete okc;
+}
+
+int okc_stub_get_stats(okc_handle_t* okc, okc_stub_stats_t* stats){
+    if(okc == NULL)
+        return OKC_ERR;
+    std::lock_guard<std::mutex> lock(okc->mutex);
+    *stats = okc->stats;
+    return OKC_OK;
+}
+
+int okc_is_robot_avail(okc_handle_t* okc, int robot_id){
+    return (robot(okc,robot_id) != NULL) ? OKC_OK : OKC_ERR;
+}
+
+int okc_get_robot_name(okc_handle_t* okc, int robot_id, char* name, int len){
+    OkcStubRobot *rb = robot(okc,robot_id);
+    if((rb == NULL) || (len < 1))
+        return OKC_ERR;
+    strncpy(name,rb->name,len-1);
+    name[len-1] = '\0';
+    return OKC_OK;
+}
+
+int okc_get_cycle_time(okc_handle_t* okc, int robot_id, float* cycle_time){
+    if(okc == NULL)
+        return OKC_ERR;
+    *cycle_time = okc->cfg.cycle_time;
+    return OKC_OK;
+}
+
+int okc_get_connection_quality(okc_handle_t* okc, int robot_id, int* quality){
+    OkcStubRobot *rb = robot(okc,robot_id);
+    if(rb == NULL)
+        return OKC_ERR;
+    std::lock_guard<std::mutex> lock(okc->mutex);
+    *quality = rb->quality;
+    return OKC_OK;
+}
+
+int okc_sleep_cycletime(okc_handle_t* okc, int robot_id){
+    if(okc == NULL)
+        return OKC_ERR;
+    std::unique_lock<std::mutex> lock(okc->mutex);
+    uint64_t t = okc->tick;
+    okc->tick_cv.wait(lock,[okc,t](){return (okc->tick != t) || (okc->running.load() == false);});
+    return OKC_OK;
+}
+
+int okc_is_robot_in_command_mode(okc_handle_t* okc, int robot_id){
+    OkcStubRobot *rb = robot(okc,robot_id);
+    if(rb == NULL)
+        return OKC_ERR;
+    std::lock_guard<std::mutex> lock(okc->mutex);
+    return (rb->state == FRI_STATE_CMD) ? OKC_OK : OKC_ERR;
+}
+
+int okc_request_command_mode(okc_handle_t* okc, int robot_id){
+    std::uniform_real_distribution<double> uniform(0.0,1.0);
+    OkcStubRobot *rb = robot(okc,robot_id);
+    if(rb == NULL)
+        return OKC_ERR;
+    std::lock_guard<std::mutex> lock(okc->mutex);
+    //a refused request is not an error, the robot just stays in monitor mode
+    if((rb->quality < FRI_QUALITY_BAD) || ((okc->cfg.refuse > 0.0) && (uniform(okc->request_rng) < okc->cfg.refuse))){
+        okc->stats.refusals++;
+        return OKC_OK;
+    }
+    rb->state = FRI_STATE_CMD;
+    return OKC_OK;
+}
+
+int okc_request_monitor_mode(okc_handle_t* okc, int robot_id){
+    OkcStubRobot *rb = robot(okc,robot_id);
+    if(rb == NULL)
+        return OKC_ERR;
+    std::lock_guard<std::mutex> lock(okc->mutex);
+    rb->state = FRI_STATE_MON;
+    return OKC_OK;
+}
+
+static int set_ctrl(okc_handle_t* okc, int robot_id, int ctrl){
+    OkcStubRobot *rb = robot(okc,robot_id);
+    if(rb == NULL)
+        return OKC_ERR;
+    std::lock_guard<std::mutex> lock(okc->mutex);
+    rb->ctrl = ctrl;
+    return OKC_OK;
+}
+
+int okc_switch_to_axis_impedance(okc_handle_t* okc, int robot_id){
+    return set_ctrl(okc,robot_id,FRI_CTRL_JNT_IMP);
+}
+
+int okc_switch_to_cp_impedance(okc_handle_t* okc, int robot_id){
+    return set_ctrl(okc,robot_id,FRI_CTRL_CART_IMP);
+}
+
+int okc_switch_to_position(okc_handle_t* okc, int robot_id){
+    return set_ctrl(okc,robot_id,FRI_CTRL_POSITION);
+}
+
+int okc_alter_cmdFlags(okc_handle_t* okc, int robot_id, int flags){
+    OkcStubRobot *rb = robot(okc,robot_id);
+    if(rb == NULL)
+        return OKC_ERR;
+    std::lock_guard<std::mutex> lock(okc->mutex);
+    rb->cmd_flags = flags;
+    return OKC_OK;
+}
+
+int okc_alter_cbmode(okc_handle_t* okc, int robot_id, int cbmode){
+    OkcStubRobot *rb = robot(okc,robot_id);
+    if(rb == NULL)
+        return OKC_ERR;
+    std::lock_guard<std::mutex> lock(okc->mutex);
+    rb->cbmode = cbmode;
+    return OKC_OK;
+}
+
+int okc_register_axis_set_absolute_callback(okc_handle_t* okc, int robot_id, okc_callback_axis_t cb, void* priv){
+    OkcStubRobot *rb = robot(okc,robot_id);
+    if(rb == NULL)
+        return OKC_ERR;
+    std::lock_guard<std::mutex> lock(okc->mutex);
+    rb->axis_cb = cb;
+    rb->axis_priv = priv;
+    return OKC_OK;
+}
+
+int okc_register_cartpos_axis_set_absolute_callback(okc_handle_t* okc, int robot_id, okc_callback_cartpos_axis_t cb, void* priv){
+    OkcStubRobot *rb = robot(okc,robot_id);
+    if(rb == NULL)
+        return OKC_ERR;
+    std::lock_guard<std::mutex> lock(okc->mutex);
+    rb->cart_cb = cb;
+    rb->cart_priv = priv;
+    return OKC_OK;
+}
+
+int okc_get_jntpos_act(okc_handle_t* okc, int robot_id, fri_float_t* pos){
+    OkcStubRobot *rb = robot(okc,robot_id);
+    if(rb == NULL)
+        return OKC_ERR;
+    std::lock_guard<std::mutex> lock(okc->mutex);
+    okc_cp_lbr_mnj(rb->mea,pos);
+    return OKC_OK;
+}
+
+int okc_get_ft_tcp_est(okc_handle_t* okc, int robot_id, coords_t* ft){
+    OkcStubRobot *rb = robot(okc,robot_id);
+    if(rb == NULL)
+        return OKC_ERR;
+    std::lock_guard<std::mutex> lock(okc->mutex);
+    *ft = rb->ft;
+    return OKC_OK;
+}
+
+int okc_set_axis_stiffness_damping(okc_handle_t* okc, int robot_id, lbr_axis_t stiffness, lbr_axis_t damping){
+    OkcStubRobot *rb = robot(okc,robot_id);
+    if(rb == NULL)
+        return OKC_ERR;
+    std::lock_guard<std::mutex> lock(okc->mutex);
+    rb->stiffness = stiffness;
+    rb->damping = damping;
+    return OKC_OK;
+}
+
+int okc_set_cp_stiffness_damping(okc_handle_t* okc, int robot_id, coords_t stiffness, coords_t damping){
+    OkcStubRobot *rb = robot(okc,robot_id);
+    if(rb == NULL)
+        return OKC_ERR;
+    std::lock_guard<std::mutex> lock(okc->mutex);
+    rb->cp_stiffness = stiffness;
+    rb->cp_damping = damping;
+    return OKC_OK;
+}
+
+int okc_set_cp_addTcpFT(okc_handle_t* okc, int robot_id, coords_t ft){
+    OkcStubRobot *rb = robot(okc,robot_id);
+    if(rb == NULL)
+        return OKC_ERR;
+    std::lock_guard<std::mutex> lock(okc->mutex);
+    rb->add_ft = ft;
+    return OKC_OK;
+}
+
+void okc_cp_lbr_mnj(const fri_float_t* src, fri_float_t* dst){
+    memcpy(dst,src,LBR_MNJ*sizeof(fri_float_t));
+}
+
+void okc_cp_cart_frm_dim(const fri_float_t* src, fri_float_t* dst){
+    memcpy(dst,src,FRI_CART_FRM_DIM*sizeof(fri_float_t));
+}
+
+void okc_print_lbr_mnj(const fri_float_t* v){
+    for(int i = 0; i < LBR_MNJ; i++)
+        std::cout<<v[i]<<((i < LBR_MNJ-1) ? " " : "\n");
+    std::cout.flush();
+}
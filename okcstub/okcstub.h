@@ -0,0 +1,74 @@
+#ifndef OKCSTUB_H
+#define OKCSTUB_H
+//!In-tree stand-in for libopenkcfri. A clock thread plays the KRC: it calls the
+//!registered callbacks every cycle, feeds the commanded joints through a plant
+//!model and injects faults. Faults come from a seeded generator, a run with the
+//!same configuration sees the same faults in the same cycles.
+//!
+//!The configuration is read from the environment when the server starts:
+//!  OKC_STUB_CYCLE_TIME    cycle time in s, 0.004
+//!  OKC_STUB_FREE_RUN      1 runs the cycles back to back instead of in real time
+//!  OKC_STUB_PLANT         ideal (measured = commanded) or lag (first order)
+//!  OKC_STUB_TAU           time constant of the lag plant in s, 0.02
+//!  OKC_STUB_NOISE         standard deviation of the measured joints in rad
+//!  OKC_STUB_FT_NOISE      standard deviation of the estimated tcp force/torque
+//!  OKC_STUB_LATE          probability of a late packet per cycle
+//!  OKC_STUB_LATE_US       delay of a late packet in us, 2 cycles
+//!  OKC_STUB_DROP          probability of a connection quality drop per cycle
+//!  OKC_STUB_DROP_CYCLES   length of a quality drop, 50
+//!  OKC_STUB_DROP_QUALITY  FRI_QUALITY during a drop, 1 (bad). Below bad the robot
+//!                         falls back to monitor mode, like the KRC does
+//!  OKC_STUB_REFUSE        probability that a command mode request is ignored
+//!  OKC_STUB_SEED          seed of the fault and noise generator, 1
+//!  OKC_STUB_LEFT, OKC_STUB_RIGHT  names of robot 1 and 2, the arm ips of ComInterface.h
+//!  OKC_STUB_Q0            7 comma separated start joints in rad
+#include "fri_okc_comm.h"
+
+enum OkcStubPlantT{
+    OKC_STUB_IDEAL = 0,
+    OKC_STUB_LAG = 1
+};
+
+typedef struct{
+    float cycle_time;
+    int free_run;
+    int plant;
+    double tau;
+    double noise;
+    double ft_noise;
+    double late;
+    long late_us;
+    double drop;
+    long drop_cycles;
+    int drop_quality;
+    double refuse;
+    unsigned int seed;
+    fri_float_t q0[LBR_MNJ];
+} okc_stub_config_t;
+
+typedef struct{
+    unsigned long cycles;
+    unsigned long late;
+    unsigned long drops;
+    unsigned long refusals;
+    //!cycles in which a callback did not return before the next one was due
+    unsigned long overruns;
+} okc_stub_stats_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//!defaults overridden by the environment
+void okc_stub_default_config(okc_stub_config_t* cfg);
+//!configuration for the next okc_start_server, the environment is not read then
+void okc_stub_configure(const okc_stub_config_t* cfg);
+int okc_stub_get_stats(okc_handle_t* okc, okc_stub_stats_t* stats);
+//!stop the clock thread, the handle is invalid afterwards
+void okc_stub_stop_server(okc_handle_t* okc);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // OKCSTUB_H
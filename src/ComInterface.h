@@ -21,6 +21,7 @@ class ComInterface
 {
 public:
     ComInterface();
+    virtual ~ComInterface(){}
     virtual void connect() = 0;
     virtual bool isConnected() = 0;
     virtual void waitForFinished() = 0;
@@ -1,11 +1,18 @@
 #include "ComOkc.h"
 #include "Util.h"
+#include "tracer.h"
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
 
 int ComOkc::instance_count = 0;
 okc_handle_t* ComOkc::okc = NULL;
 struct timeval v_last;
 
 int ComOkc::left_okcAxisAbsCallback (void* priv, const fri_float_t* pos_act, fri_float_t* new_pos){
+    //the first callbacks come before the command mode, the ring is allocated there
+    Tracer::register_thread("okc_callback");
+    TRACE_SCOPE("okc_callback");
     ComOkc *com_okc_ptr = (ComOkc*) priv;
     fri_float_t jnt_pos[7];
     struct timeval v_cur, v_old;
@@ -24,16 +31,21 @@ int ComOkc::left_okcAxisAbsCallback (void* priv, const fri_float_t* pos_act, fri
         }
         return (OKC_OK);
     }
+    if(com_okc_ptr->run_inline(pos_act,new_pos))
+        return (OKC_OK);
     intervaltime = 0;
     if(gettimeofday(&v_old,NULL)){
         std::cout<<"gettimeofday function error at the current time"<<std::endl;
     }
-    com_okc_ptr->data_available = true;
-    while((intervaltime < 1500)&&(com_okc_ptr->controller_update == false)){
-        if(gettimeofday(&v_cur,NULL)){
-            std::cout<<"gettimeofday function error at the current time"<<std::endl;
+    com_okc_ptr->publish_data();
+    {
+        TRACE_SCOPE("callback_wait");
+        while((intervaltime < 1500)&&(com_okc_ptr->controller_update == false)){
+            if(gettimeofday(&v_cur,NULL)){
+                std::cout<<"gettimeofday function error at the current time"<<std::endl;
+            }
+            intervaltime = timeval_diff(NULL,&v_cur,&v_old);
         }
-        intervaltime = timeval_diff(NULL,&v_cur,&v_old);
     }
     if(com_okc_ptr->controller_update == true){
         //Todo:use the updated control output
@@ -55,6 +67,9 @@ int ComOkc::left_okcAxisAbsCallback (void* priv, const fri_float_t* pos_act, fri
     return (OKC_OK);
 }
 int ComOkc::right_okcAxisAbsCallback (void* priv, const fri_float_t* pos_act, fri_float_t* new_pos){
+    //the first callbacks come before the command mode, the ring is allocated there
+    Tracer::register_thread("okc_callback");
+    TRACE_SCOPE("okc_callback");
     ComOkc *com_okc_ptr = (ComOkc*) priv;
     fri_float_t jnt_pos[7];
     struct timeval v_cur, v_old;
@@ -72,18 +87,23 @@ int ComOkc::right_okcAxisAbsCallback (void* priv, const fri_float_t* pos_act, fr
         }
         return (OKC_OK);
     }
+    if(com_okc_ptr->run_inline(pos_act,new_pos))
+        return (OKC_OK);
     intervaltime = 0;
     if(gettimeofday(&v_old,NULL)){
         std::cout<<"gettimeofday function error at the current time"<<std::endl;
     }
 //    std::cout<<"time difference for two sampling step is "<<timeval_diff(NULL,&v_old,&v_last)<<std::endl;
     v_last = v_old;
-    com_okc_ptr->data_available = true;
-    while((intervaltime < 1500)&&(com_okc_ptr->controller_update == false)){
-        if(gettimeofday(&v_cur,NULL)){
-            std::cout<<"gettimeofday function error at the current time"<<std::endl;
+    com_okc_ptr->publish_data();
+    {
+        TRACE_SCOPE("callback_wait");
+        while((intervaltime < 1500)&&(com_okc_ptr->controller_update == false)){
+            if(gettimeofday(&v_cur,NULL)){
+                std::cout<<"gettimeofday function error at the current time"<<std::endl;
+            }
+            intervaltime = timeval_diff(NULL,&v_cur,&v_old);
         }
-        intervaltime = timeval_diff(NULL,&v_cur,&v_old);
     }
 //    std::cout<<"out of the cycling and updata flag "<<intervaltime<<","<<com_okc_ptr->controller_update<<std::endl;
     if(com_okc_ptr->controller_update == true){
@@ -105,6 +125,9 @@ int ComOkc::right_okcAxisAbsCallback (void* priv, const fri_float_t* pos_act, fr
     return (OKC_OK);
 }
 int ComOkc::okcCartposAxisAbsCallback (void* priv, const fri_float_t* cartpos_act, fri_float_t* axispos_act,fri_float_t* new_cartpos, fri_float_t* new_axispos){
+    //the first callbacks come before the command mode, the ring is allocated there
+    Tracer::register_thread("okc_callback");
+    TRACE_SCOPE("okc_callback");
     struct timeval v_cur, v_old;
     long long intervaltime;
     fri_float_t jnt_pos[7];
@@ -136,12 +159,15 @@ int ComOkc::okcCartposAxisAbsCallback (void* priv, const fri_float_t* cartpos_ac
     }
 //    std::cout<<"time difference for two sampling step is "<<timeval_diff(NULL,&v_old,&v_last)<<std::endl;
     v_last = v_old;
-    com_okc_ptr->data_available = true;
-    while((intervaltime < 1500)&&(com_okc_ptr->controller_update == false)){
-        if(gettimeofday(&v_cur,NULL)){
-            std::cout<<"gettimeofday function error at the current time"<<std::endl;
+    com_okc_ptr->publish_data();
+    {
+        TRACE_SCOPE("callback_wait");
+        while((intervaltime < 1500)&&(com_okc_ptr->controller_update == false)){
+            if(gettimeofday(&v_cur,NULL)){
+                std::cout<<"gettimeofday function error at the current time"<<std::endl;
+            }
+            intervaltime = timeval_diff(NULL,&v_cur,&v_old);
         }
-        intervaltime = timeval_diff(NULL,&v_cur,&v_old);
     }
 //    std::cout<<"out of the cycling and updata flag "<<intervaltime<<","<<com_okc_ptr->controller_update<<std::endl;
     if(com_okc_ptr->controller_update == true){
@@ -166,11 +192,138 @@ int ComOkc::okcCartposAxisAbsCallback (void* priv, const fri_float_t* cartpos_ac
     return (OKC_OK);
 }
 
+static int64_t monotonic_ns(){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC,&ts);
+    return (int64_t)ts.tv_sec*1000000000ll + ts.tv_nsec;
+}
+
+void ComOkc::init_data_event(){
+    sem_init(&data_sem,0,0);
+    data_ns.store(0);
+    inline_mode = false;
+    inline_running = false;
+    inline_hold = false;
+    inline_budget_us = INLINE_BUDGET_US;
+    m_wait_stats.wakeups = 0;
+    m_wait_stats.timeouts = 0;
+    m_wait_stats.latency_mean = 0.0;
+    m_wait_stats.latency_max = 0.0;
+}
+
+void ComOkc::publish_data(){
+    data_ns.store(monotonic_ns(),std::memory_order_relaxed);
+    data_available = true;
+    sem_post(&data_sem);
+}
+
+bool ComOkc::wait_for_data(long timeout_us){
+    if(detached)
+        return data_available;
+    //the timeout runs on CLOCK_MONOTONIC, a step of the wall clock must not stretch or cut it
+#if defined(__GLIBC__) && __GLIBC_PREREQ(2,30)
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC,&ts);
+    ts.tv_sec += timeout_us/1000000;
+    ts.tv_nsec += (timeout_us%1000000)*1000;
+    if(ts.tv_nsec >= 1000000000){
+        ts.tv_sec++;
+        ts.tv_nsec -= 1000000000;
+    }
+    while(sem_clockwait(&data_sem,CLOCK_MONOTONIC,&ts) != 0){
+        if(errno == EINTR)
+            continue;
+        m_wait_stats.timeouts++;
+        return false;
+    }
+#else
+    //no sem_clockwait, poll against a monotonic deadline
+    int64_t deadline = monotonic_ns() + 1000ll*timeout_us;
+    while(sem_trywait(&data_sem) != 0){
+        if(monotonic_ns() >= deadline){
+            m_wait_stats.timeouts++;
+            return false;
+        }
+        usleep(DATA_POLL_US);
+    }
+#endif
+    double latency = 1e-3*(monotonic_ns() - data_ns.load(std::memory_order_relaxed));
+    //posts of cycles the control thread missed, the measurement is the latest one anyway
+    while(sem_trywait(&data_sem) == 0);
+    m_wait_stats.wakeups++;
+    m_wait_stats.latency_mean += (latency - m_wait_stats.latency_mean)/m_wait_stats.wakeups;
+    if(latency > m_wait_stats.latency_max)
+        m_wait_stats.latency_max = latency;
+    return true;
+}
+
+void ComOkc::set_inline_controller(const CycleFunction& f, long budget_us){
+    inline_budget_us = budget_us;
+    m_inline_stats.cycles = 0;
+    m_inline_stats.overruns = 0;
+    m_inline_stats.run_mean = 0.0;
+    m_inline_stats.run_max = 0.0;
+    inline_controller = f;
+    inline_mode = true;
+}
+
+void ComOkc::clear_inline_controller(){
+    inline_mode = false;
+    //the callback may be in the controller, its owner may free what it uses after this returns
+    while(inline_running.load())
+        usleep(100);
+}
+
+void ComOkc::hold_inline(){
+    inline_hold = true;
+    while(inline_running.load())
+        usleep(100);
+}
+
+void ComOkc::resume_inline(){
+    inline_hold = false;
+}
+
+bool ComOkc::run_inline(const fri_float_t* pos_act, fri_float_t* new_pos){
+    inline_running = true;
+    if(inline_mode == false){
+        inline_running = false;
+        return false;
+    }
+    if(inline_hold){
+        inline_running = false;
+        for(int i = 0; i < 7; i++)
+            new_pos[i] = pos_act[i];
+        return true;
+    }
+    TRACE_SCOPE("inline_controller");
+    int64_t t0 = monotonic_ns();
+    inline_controller();
+    double run = 1e-3*(monotonic_ns() - t0);
+    inline_running = false;
+    m_inline_stats.cycles++;
+    m_inline_stats.run_mean += (run - m_inline_stats.run_mean)/m_inline_stats.cycles;
+    if(run > m_inline_stats.run_max)
+        m_inline_stats.run_max = run;
+    if(run > inline_budget_us){
+        //a late command is stale, hold the current position as the handoff does on a timeout
+        m_inline_stats.overruns++;
+        for(int i = 0; i < 7; i++)
+            new_pos[i] = pos_act[i];
+        return true;
+    }
+    for(int i = 0; i < 7; i++)
+        new_pos[i] = jnt_command[i];
+    return true;
+}
+
 void ComOkc::waitForFinished(){
     usleep(10000*cycle_time);
 }
 
 void ComOkc::get_cycle_time(){
+    if(detached)
+        return;
     okc_get_cycle_time(okc, 0, &cycle_time);
 }
 
@@ -179,6 +332,8 @@ int ComOkc::getrobot_id(){
 }
 
 void ComOkc::start_brake(){
+    if(detached)
+        return;
     for (int i = 0; i < 5; i++)
     okc_sleep_cycletime(okc,robot_id);
     std::cout<<"start brake"<<std::endl;
@@ -186,6 +341,8 @@ void ComOkc::start_brake(){
 }
 
 void ComOkc::release_brake(){
+    if(detached)
+        return;
     for (int i = 0; i < 5; i++)
     okc_sleep_cycletime(okc,robot_id);
     std::cout<<"release brake"<<std::endl;
@@ -193,6 +350,8 @@ void ComOkc::release_brake(){
 }
 
 void ComOkc::connect(){
+    if(detached)
+        return;
     int quality = FRI_QUALITY_UNACCEPTABLE;
     std::cout << "waiting for robot to connect" << std::endl;
     while (OKC_OK != okc_is_robot_avail (okc,robot_id)){
@@ -241,6 +400,8 @@ void ComOkc::connect(){
 }
 
 bool ComOkc::isConnected(){
+    if(detached)
+        return true;
     std::cout<<"okc is available "<<okc_is_robot_avail(okc,robot_id)<<std::endl;
     if (OKC_OK == okc_is_robot_avail(okc,robot_id))
         return true;
@@ -313,6 +474,8 @@ void ComOkc::registerCallback(int index){
 }
 
 void ComOkc::set_stiffness(double *s, double *d){
+    if(detached)
+        return;
     adamping.a1 = d[0];
     adamping.a2 = d[1];
     adamping.e1 = d[2];
@@ -332,6 +495,8 @@ void ComOkc::set_stiffness(double *s, double *d){
 }
 
 void ComOkc::set_cp_stiffness(double *cps,double *cpd){
+    if(detached)
+        return;
     cpstiff.x = cps[0];
     cpstiff.y = cps[1];
     cpstiff.z = cps[2];
@@ -349,6 +514,8 @@ void ComOkc::set_cp_stiffness(double *cps,double *cpd){
 }
 
 void ComOkc::set_cp_ExtTcpFT(double *tcpft){
+    if(detached)
+        return;
     extft.x = tcpft[0];
     extft.y = tcpft[1];
     extft.z = tcpft[2];
@@ -359,18 +526,24 @@ void ComOkc::set_cp_ExtTcpFT(double *tcpft){
 }
 
 void ComOkc::switch_to_cp_impedance(){
+    if(detached)
+        return;
     okc_alter_cbmode(okc,robot_id,OKC_MODE_CALLBACK_POS_AXIS_ABS);
     okc_alter_cmdFlags (okc,robot_id,OKC_CMD_FLAGS_CP_AXIS_IMPEDANCE_MODE);
     okc_switch_to_cp_impedance(okc,robot_id);
 }
 
 void ComOkc::switch_to_jnt_impedance(){
+    if(detached)
+        return;
     okc_alter_cbmode(okc,robot_id,OKC_MODE_CALLBACK_AXIS_ABS);
     okc_alter_cmdFlags (okc,robot_id,OKC_CMD_FLAGS_AXIS_IMPEDANCE_MODE);
     okc_switch_to_axis_impedance(okc,robot_id);
 }
 
 void ComOkc::request_monitor_mode(){
+    if(detached)
+        return;
     okc_request_monitor_mode(okc,robot_id);
 }
 
@@ -384,6 +557,8 @@ ComOkc::ComOkc(RobotNameT connectToRobot=kuka_right, \
         legacy_axis_mode = false;
     }
     rn = connectToRobot;
+    detached = false;
+    init_data_event();
     controller_update = false;
     ft = new coords_t;
     if (0 == ComOkc::instance_count)
@@ -411,3 +586,24 @@ ComOkc::ComOkc(RobotNameT connectToRobot=kuka_right, \
     }
 }
 
+
+ComOkc::ComOkc(RobotNameT connectToRobot, float t)
+{
+    rn = connectToRobot;
+    detached = true;
+    legacy_axis_mode = true;
+    robot_id = (rn == kuka_left) ? LEFT_ROBOT_ID : RIGHT_ROBOT_ID;
+    cycle_time = t;
+    init_data_event();
+    controller_update = false;
+    data_available = false;
+    ft = new coords_t;
+    memset(ft,0,sizeof(coords_t));
+    for(int i = 0; i < 7; i++){
+        jnt_position_act[i] = 0.0;
+        jnt_position_mea[i] = 0.0;
+        jnt_command[i] = 0.0;
+    }
+    for(int i = 0; i < 12; i++)
+        new_cartpos[i] = 0.0;
+}
@@ -19,10 +19,36 @@
 #include <iostream>
 #include <stdexcept>
 #include <sys/time.h>//for program running test(realtime consuming test)
+#include <semaphore.h>
+#include <atomic>
+#include <stdint.h>
+#include <functional>
 
 #define LEFT_ROBOT_ID   1
 #define RIGHT_ROBOT_ID  2
 
+//!how fast the control thread started on a new measurement, latencies in us
+struct DataWaitStats{
+    uint64_t wakeups;
+    uint64_t timeouts;
+    double latency_mean;
+    double latency_max;
+};
+
+//!poll period of wait_for_data where the C library has no sem_clockwait (us)
+#define DATA_POLL_US 50
+
+//!time the inline controller may take before its command is replaced by the hold command (us)
+#define INLINE_BUDGET_US 1500
+
+//!inline controller runs, durations in us
+struct InlineStats{
+    uint64_t cycles;
+    uint64_t overruns;
+    double run_mean;
+    double run_max;
+};
+
 enum KUKACTRLMODET{
     JNT_IMP = 0,
     CART_IMP
@@ -32,14 +58,35 @@ class ComOkc : public ComInterface
 {
 public:
     ComOkc(RobotNameT connectToRobot, const char* hostname, const char* port,KUKACTRLMODET kmt);
+    //!detached node without a server, the owner writes the joint positions and ft
+    //!and reads jnt_command, e.g. to replay a recorded session
+    ComOkc(RobotNameT connectToRobot, float cycle_time);
+    bool is_detached(){return detached;}
     void connect();
     bool isConnected();
     void waitForFinished();
     int getrobot_id();
-    bool controller_update;
+    std::atomic<bool> controller_update;
     float jnt_position_act[7];
     float jnt_position_mea[7];
-    bool data_available;
+    std::atomic<bool> data_available;
+    //!block until the callback publishes a new measurement, false after timeout_us without one
+    bool wait_for_data(long timeout_us);
+    const DataWaitStats& wait_stats(){return m_wait_stats;}
+    typedef std::function<void(void)> CycleFunction;
+    //!run f inside the joint impedance callbacks instead of handing the measurement
+    //!to another thread. f reads the measurement and writes jnt_command, a command
+    //!that takes longer than budget_us is dropped and the position is held.
+    //!Set it once, the callback thread calls f without a lock.
+    void set_inline_controller(const CycleFunction& f, long budget_us = INLINE_BUDGET_US);
+    //!back to the handoff, returns when the callback has left f
+    void clear_inline_controller();
+    //!skip the inline controller and hold the measured position until resume_inline(),
+    //!returns when the callback has left f. For another thread that talks to the robot.
+    void hold_inline();
+    void resume_inline();
+    bool is_inline(){return inline_mode;}
+    const InlineStats& inline_stats(){return m_inline_stats;}
     fri_float_t jnt_command[7];
     fri_float_t new_cartpos[12];
     coords_t* ft;
@@ -56,6 +103,21 @@ private:
     char hostname[16];
     char port[6];
     bool legacy_axis_mode;
+    bool detached;
+    //!posted by the callbacks when a measurement is available
+    sem_t data_sem;
+    std::atomic<int64_t> data_ns;
+    DataWaitStats m_wait_stats;
+    void publish_data();
+    //!true if the inline controller computed new_pos
+    bool run_inline(const fri_float_t* pos_act, fri_float_t* new_pos);
+    std::atomic<bool> inline_mode;
+    std::atomic<bool> inline_running;
+    std::atomic<bool> inline_hold;
+    CycleFunction inline_controller;
+    long inline_budget_us;
+    InlineStats m_inline_stats;
+    void init_data_event();
     static okc_handle_t* okc;
     void initServer();
     void bindToName(const char* name);
@@ -9,26 +9,26 @@ public:
     double kd;
 };
 
+//!gains of one task, fixed size so a parameter set is one flat block that can be
+//!copied and cached as is
 class taskctrlpara{
 public:
-    ctrlpara p_ctrlpara_x;
-    ctrlpara p_ctrlpara_y;
-    ctrlpara p_ctrlpara_z;
-    ctrlpara p_ctrlpara_roll;
-    ctrlpara p_ctrlpara_pitch;
-    ctrlpara p_ctrlpara_yaw;
-    ctrlpara p_ctrlpara_roll2;
-    ctrlpara p_ctrlpara_pitch2;
-    ctrlpara p_ctrlpara_yaw2;
-    Eigen::MatrixXd kpp;
-    Eigen::MatrixXd kpi;
-    Eigen::MatrixXd kpd;
-    Eigen::MatrixXd kop;
-    Eigen::MatrixXd tsm;
-    Eigen::MatrixXd ttjkm;
-    Eigen::MatrixXd vsm;
-    Eigen::MatrixXd vtjkm;
-    Eigen::MatrixXd psm;
+    taskctrlpara(){
+        loaded = false;
+        kpp.setZero();kpi.setZero();kpd.setZero();kop.setZero();
+        tsm.setZero();ttjkm.setZero();vsm.setZero();vtjkm.setZero();psm.setZero();
+    }
+    //!false if the parameter file has no entry for the task
+    bool loaded;
+    Eigen::Matrix<double,6,6> kpp;
+    Eigen::Matrix<double,6,6> kpi;
+    Eigen::Matrix<double,6,6> kpd;
+    Eigen::Matrix3d kop;
+    Eigen::Matrix<double,6,6> tsm;
+    Eigen::Matrix<double,6,6> ttjkm;
+    Eigen::Matrix<double,6,6> vsm;
+    Eigen::Matrix<double,6,6> vtjkm;
+    Eigen::Matrix<double,6,6> psm;
 };
 
 class kukapara{
@@ -5,6 +5,7 @@
 #include "actcontroller.h"
 #include "CtrlParam.h"
 #include <fstream>
+#include "tracer.h"
 
 #define initP_x 0.28
 #define initP_y 0.3
@@ -48,6 +49,7 @@ void KukaLwr::setReference (CBF::Float x, CBF::Float y, CBF::Float z, CBF::Float
 
 
 void KukaLwr::update_robot_state(){
+    TRACE_SCOPE("update_robot_state");
     KDL::JntArray q = JntArray (7);
     KDL::JntArray q2 = JntArray (7);
     KDL::Frame position;
@@ -81,56 +83,97 @@ void KukaLwr::update_robot_state(){
     new_cartpos[9] = baseposition.M.data[7];
     new_cartpos[10] = baseposition.M.data[8];
     new_cartpos[11] = baseposition.p(2);
+
+    Eigen::Matrix<double,6,1> ft;
+    read_eef_ft(ft);
+    if(has_old_cartpos){
+        Eigen::Vector3d vel;
+        vel(0) = (new_cartpos[3] - old_cartpos[3])/gettimecycle();
+        vel(1) = (new_cartpos[7] - old_cartpos[7])/gettimecycle();
+        vel(2) = (new_cartpos[11] - old_cartpos[11])/gettimecycle();
+        vel_filter.add(vel);
+        ft_filter.add(ft);
+    }
+    else{
+        //first sample after the start or a mode switch: the filters begin at the
+        //measurement instead of ramping up from zero, the velocity follows next cycle
+        vel_filter.reset();
+        ft_filter.reset(ft);
+    }
+    for(int i = 0; i < 12; i++)
+        old_cartpos[i] = new_cartpos[i];
+    has_old_cartpos = true;
 }
 
 Eigen::Vector3d KukaLwr::get_cur_vel(){
-    Eigen::Vector3d vel;
-    vel.setZero();
-
-    vel(0) = (new_cartpos[3] - old_cartpos[3])/gettimecycle();
-    vel(1) = (new_cartpos[7] - old_cartpos[7])/gettimecycle();
-    vel(2) = (new_cartpos[11] - old_cartpos[11])/gettimecycle();
-    for(int i = 0; i < 12; i++){
-        old_cartpos[i] = new_cartpos[i];
-    }
-    return vel;
+    return vel_filter.value();
 }
 
 void KukaLwr::update_cbf_controller(){
-    setReference(cart_command);
+    TRACE_SCOPE("update_cbf_controller");
+    cart_limiter->set_cycle_time(gettimecycle());
+    if(cart_limiter->is_initialised() == false)
+        cart_limiter->reset(m_p_eigen,m_TM_eigen);
+    //the limiter works on the quaternion of the command, only the CBF reference is an axis angle
+    Eigen::Vector3d p(cart_command[0],cart_command[1],cart_command[2]);
+    Eigen::Quaterniond q;
+    cart_limiter->limit(p,cart_command_q,p,q);
+    Eigen::Vector3d o = quat2axisangle(q);
+    for(int i = 0; i < 3; i++){
+        cart_reference[i] = p(i);
+        cart_reference[i+3] = o(i);
+    }
+    setReference(cart_reference);
     CBF::FloatVector newResourceVector(7);
     for (int i=0; i < LBR_MNJ; i++){
         newResourceVector(i) = jnt_position_act[i];
     }
     kukaResourceP->set(newResourceVector);
-    primitiveControllerP->step();
+    {
+        TRACE_SCOPE("cbf_step");
+        primitiveControllerP->step();
+    }
     updates = kukaResourceP->get() - newResourceVector;
 }
 
 void KukaLwr::set_joint_command(RobotModeT m){
+    TRACE_SCOPE("set_joint_command");
     if(m == NormalMode){
         double d_updates[7],pupdates[7];
         for(int i = 0; i < 7; i++){
             d_updates[i] = updates(i);
         }
-        jlf->get_filtered_value(d_updates,pupdates);
-        for(int i = 0; i < 7; i++){
-            v_data<<d_updates[i]<<",";
+        if(jnt_smoothing == JNT_TRAJ_GENERATOR){
+            double q_act[7],q_target[7],q_out[7];
+            for(int i = 0; i < 7; i++){
+                q_act[i] = jnt_position_act[i];
+                q_target[i] = q_act[i] + d_updates[i];
+            }
+            if(jtg->is_initialised() == false)
+                jtg->reset(q_act);
+            jtg->step(q_target,q_out);
+            for(int i = 0; i < 7; i++)
+                pupdates[i] = q_out[i] - jnt_position_act[i];
         }
-        for(int i = 0; i < 7; i++){
-            v_data<<pupdates[i]<<",";
+        else{
+            jlf->get_filtered_value(d_updates,pupdates);
         }
-        v_data<<std::endl;
         for(int i = 0; i < 7; i++){
             jnt_command[i] = jnt_position_act[i] + pupdates[i];
             okc_node->jnt_command[i] = jnt_command[i];
         }
+        log_cycle(m,d_updates,pupdates);
     }
     if(m == PsudoGravityCompensation){
+        //the generator and the limiter restart from the robot pose when NormalMode resumes
+        jtg->invalidate();
+        cart_limiter->invalidate();
         for(int i = 0; i < 7; i++){
             jnt_command[i] = 0.5*(jnt_position_act[i] + okc_node->jnt_position_mea[i]);
             okc_node->jnt_command[i] = jnt_command[i];
         }
+        double zero[7] = {0.0,0.0,0.0,0.0,0.0,0.0,0.0};
+        log_cycle(m,zero,zero);
     }
 //    std::cout<<"new position is";
     for(int i = 0; i < 12; i++){
@@ -150,9 +193,47 @@ void KukaLwr::no_move(){
 
 
 void KukaLwr::setAxisStiffnessDamping (double* s, double* d){
+    for(int i = 0; i < 7; i++)
+        axis_stiffness[i] = s[i];
     okc_node->set_stiffness(s,d);
 }
 
+void KukaLwr::log_cycle(RobotModeT m, const double *d_updates, const double *pupdates){
+    struct timespec ts;
+    Eigen::Matrix<double,6,1> ft;
+    CycleRecord *r = cycle_log.reserve();
+    cycle_count++;
+    if(r == NULL)
+        return;
+    if(virtual_time < 0.0){
+        clock_gettime(CLOCK_MONOTONIC,&ts);
+        r->timestamp = ts.tv_sec + 1e-9*ts.tv_nsec;
+    }
+    else
+        r->timestamp = virtual_time;
+    r->cycle = cycle_count;
+    r->mode = m;
+    r->task_switches = log_task_switches;
+    for(int i = 0; i < 7; i++){
+        r->q_act[i] = jnt_position_act[i];
+        r->q_mea[i] = okc_node->jnt_position_mea[i];
+        r->jnt_command[i] = jnt_command[i];
+        r->updates[i] = d_updates[i];
+        r->filtered_updates[i] = pupdates[i];
+        r->axis_stiffness[i] = axis_stiffness[i];
+    }
+    //the raw estimate, a replay filters it again
+    read_eef_ft(ft);
+    for(int i = 0; i < 6; i++)
+        r->ft[i] = ft(i);
+    for(int i = 0; i < 6; i++){
+        r->cart_command[i] = cart_command[i];
+        r->cart_reference[i] = cart_reference[i];
+    }
+    cycle_record_set_task(*r,log_task,log_has_tacfb ? &log_tacfb : NULL);
+    cycle_log.commit();
+}
+
 
 void KukaLwr::update_robot_stiffness(){
     //before using this function, the stiffness parameter should be updated in the ActController
@@ -180,9 +261,12 @@ void KukaLwr::update_robot_cp_exttcpft(Eigen::VectorXd ft_kuka){
 
 void KukaLwr::switch2cpcontrol(){
     okc_node->switch_to_cp_impedance();
+    //the KRC estimates the force differently in the new mode
+    has_old_cartpos = false;
 }
 void KukaLwr::switch2jntcontrol(){
     okc_node->switch_to_jnt_impedance();
+    has_old_cartpos = false;
 }
 
 
@@ -216,29 +300,37 @@ void KukaLwr::waitForFinished(){
     while (!isFinished());
 }
 
+void KukaLwr::read_eef_ft(Eigen::Matrix<double,6,1>& ft){
+    ft(0) = okc_node->ft->x;
+    ft(1) = okc_node->ft->y;
+    ft(2) = okc_node->ft->z;
+    ft(3) = okc_node->ft->c;
+    ft(4) = okc_node->ft->b;
+    ft(5) = okc_node->ft->a;
+}
+
 void KukaLwr::get_eef_ft(Eigen::Vector3d& f,Eigen::Vector3d& t){
-    f[0] = okc_node->ft->x;
-    f[1] = okc_node->ft->y;
-    f[2] = okc_node->ft->z;
-    t[0] = okc_node->ft->c;
-    t[1] = okc_node->ft->b;
-    t[2] = okc_node->ft->a;
+    f = ft_filter.value().head<3>();
+    t = ft_filter.value().tail<3>();
 }
 
 
 void KukaLwr::get_joint_position_act(){
+    TRACE_SCOPE("get_joint_position_act");
     for (int i=0;i < 7; i++){
         jnt_position_act[i] = okc_node->jnt_position_act[i];
     }
 }
 
 void KukaLwr::get_joint_position_mea(){
+    TRACE_SCOPE("get_joint_position_mea");
     for (int i=0;i < 7; i++){
         jnt_position_mea[i] = okc_node->jnt_position_mea[i];
     }
 }
 
 void KukaLwr::get_joint_position_mea(double *jnt){
+    TRACE_SCOPE("get_joint_position_mea");
     for (int i=0;i < 7; i++){
         jnt_position_mea[i] = okc_node->jnt_position_mea[i];
         *(jnt+i) = okc_node->jnt_position_mea[i];
@@ -536,5 +628,20 @@ KukaLwr::KukaLwr(RobotNameT robotname, ComOkc& com)
         updates(i) = 0.0;
     }
     jlf = new JntLimitFilter(okc_node->cycle_time);
-    v_data.open("/tmp/vdata.txt");
+    jtg = new JntTrajGenerator(okc_node->cycle_time);
+    cart_limiter = new CartLimiter(okc_node->cycle_time);
+    //the generator is opt-in until it is validated on the robot
+    jnt_smoothing = JNT_LIMIT_FILTER;
+    cycle_count = 0;
+    for(int i = 0; i < 7; i++)
+        axis_stiffness[i] = 0.0;
+    for(int i = 0; i < 6; i++)
+        cart_reference[i] = 0.0;
+    virtual_time = -1.0;
+    ft_filter.set_lowpass(FT_FILTER_CUTOFF,okc_node->cycle_time);
+    vel_filter.set_params(VEL_FILTER_MIN_CUTOFF,VEL_FILTER_BETA,okc_node->cycle_time);
+    has_old_cartpos = false;
+    //a detached node replays a session, its owner decides where to log
+    if(okc_node->is_detached() == false)
+        cycle_log.open(CYCLE_LOG_FILE);
 }
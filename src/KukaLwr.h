@@ -12,10 +12,21 @@
 #include "ComOkc.h"
 #include "Util.h"
 #include "jntlimitfilter.h"
+#include "jnttrajgenerator.h"
+#include "cartlimiter.h"
+#include "cyclelog.h"
+#include "streamfilter.h"
 
 
 #include <string>
 
+#define CYCLE_LOG_FILE "/tmp/kukacycle.kslog"
+//!cutoff of the low pass on the estimated tcp force/torque (Hz)
+#define FT_FILTER_CUTOFF 10.0
+//!one euro filter of the eef velocity, cutoff at rest (Hz) and its rise with the acceleration (s/m)
+#define VEL_FILTER_MIN_CUTOFF 5.0
+#define VEL_FILTER_BETA 0.5
+
 using namespace KDL;
 using namespace CBF;
 
@@ -29,6 +40,7 @@ public:
     void get_joint_position_act();
     void get_joint_position_mea(double *);
     void get_joint_position_mea();
+    //!estimated tcp force/torque after the FT_FILTER_CUTOFF low pass
     void get_eef_ft(Eigen::Vector3d&,Eigen::Vector3d&);
     void set_joint_command(RobotModeT m);
     void update_cbf_controller();
@@ -51,10 +63,24 @@ public:
     void switch2jntcontrol();
     void request_monitor_mode();
     JntLimitFilter *jlf;
+    JntTrajGenerator *jtg;
+    //!JNT_LIMIT_FILTER by default, JNT_TRAJ_GENERATOR is not validated on the robot yet.
+    //!The apps take it from JointLimitParams.smoothing of the parameter file.
+    void set_jnt_smoothing(JntSmoothingT s){jnt_smoothing = s;}
+    JntSmoothingT get_jnt_smoothing(){return jnt_smoothing;}
+    //!limits of the filter and the generator, e.g. ParameterManager::jnt_limits
+    void set_jnt_limits(const JntLimits& l){jlf->set_limits(l); jtg->set_limits(l);}
+    CartLimiter *cart_limiter;
+    void set_cart_limits(const CartLimits& l){cart_limiter->set_limits(l);}
     RobotNameT get_robotname(){return rn;}
     Eigen::Matrix3d get_init_TM(){return m_init_tm;}
     void set_init_TM(Eigen::Matrix3d tm) {m_init_tm = tm;}
-    std::ofstream v_data;
+    //!binary record of every cycle, written in the background to CYCLE_LOG_FILE
+    CycleLog cycle_log;
+    //!timestamp of the logged cycles instead of CLOCK_MONOTONIC, negative to use the clock again
+    void set_virtual_time(double t){virtual_time = t;}
+    const double* get_cart_reference(){return cart_reference;}
+    //!filtered eef velocity in the base frame, updated by update_robot_state
     Eigen::Vector3d get_cur_vel();
     fri_float_t old_cartpos[12];
 private:
@@ -67,10 +93,23 @@ private:
     bool isFinished();
     bool isPseudoConverged();
     void GetCtrlPeriod(int& );
+    void log_cycle(RobotModeT m, const double *d_updates, const double *pupdates);
+    //!force/torque estimate of the KRC in the order of get_eef_ft
+    void read_eef_ft(Eigen::Matrix<double,6,1>& ft);
     RobotNameT rn;
     ComOkc* okc_node;
     CBF::FloatVector updates;
     int robot_id;
+    JntSmoothingT jnt_smoothing;
+    uint64_t cycle_count;
+    double axis_stiffness[7];
+    //!cartesian command after the limiter, the reference of the CBF step
+    double cart_reference[6];
+    double virtual_time;
+    Biquad<Eigen::Matrix<double,6,1> > ft_filter;
+    OneEuroFilter<Eigen::Vector3d> vel_filter;
+    //!false until old_cartpos holds a pose, the next sample restarts ft_filter and vel_filter
+    bool has_old_cartpos;
 };
 
 #endif // KUKALWR_H
@@ -49,6 +49,12 @@ enum RobotModeT{
     PsudoGravityCompensation = 1
 };
 
+//!how the joint updates of the CBF are limited in NormalMode
+enum JntSmoothingT{
+    JNT_LIMIT_FILTER,
+    JNT_TRAJ_GENERATOR
+};
+
 enum ContactPositionT{
     eff,
     ct,
@@ -1,4 +1,6 @@
 #include "Robot.h"
+#include "Util.h"
+#include <string.h>
 
 Robot::Robot()
 {
@@ -8,11 +10,36 @@ Robot::Robot()
     q.resize(7);
     eff_force.setZero();
     eff_torque.setZero();
+    for(int i = 0; i < 6; i++)
+        cart_command[i] = 0.0;
+    cart_command_q.setIdentity();
+    log_task.reset();
+    log_task_switches = 0;
+    log_has_tacfb = false;
+    memset(&log_tacfb,0,sizeof(log_tacfb));
+}
+
+void Robot::set_log_context(const TaskDesc& td, unsigned long task_switches, const myrmex_msg *tacfb){
+    log_task = td;
+    log_task_switches = task_switches;
+    log_has_tacfb = (tacfb != NULL);
+    if(tacfb != NULL)
+        log_tacfb = *tacfb;
 }
 
 void Robot::set_cart_command(double *c){
     for(int i = 0; i < 6; i++)
         cart_command[i] = *(c+i);
+    cart_command_q = axisangle2quat(Eigen::Vector3d(c[3],c[4],c[5]));
+}
+
+void Robot::set_cart_command(const Eigen::Vector3d& p, const Eigen::Quaterniond& q){
+    Eigen::Vector3d o = quat2axisangle(q);
+    for(int i = 0; i < 3; i++){
+        cart_command[i] = p(i);
+        cart_command[i+3] = o(i);
+    }
+    cart_command_q = q;
 }
 
 Eigen::Vector3d Robot::get_cur_cart_p(){
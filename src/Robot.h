@@ -15,6 +15,10 @@
 #include "CtrlParam.h"
 #include "actcontroller.h"
 #include "RebaType.h"
+#include "jntlimitfilter.h"
+#include "cartlimiter.h"
+#include "task.h"
+#include "msgcontenttype.h"
 
 #include <cbf/types.h>
 #include <cbf/primitive_controller.h>
@@ -34,13 +38,18 @@ class ActController;
 class Robot
 {
 public:
+    EIGEN_MAKE_ALIGNED_OPERATOR_NEW
     Robot();
+    virtual ~Robot(){}
     virtual void get_joint_position_act() = 0;
     virtual void get_joint_position_mea(double *) = 0;
     virtual void get_joint_position_mea() = 0;
     virtual void update_robot_state() = 0;
     virtual void update_cbf_controller() = 0;
     virtual void set_joint_command(RobotModeT m) = 0;
+    virtual void set_jnt_limits(const JntLimits&) = 0;
+    virtual void set_jnt_smoothing(JntSmoothingT) = 0;
+    virtual void set_cart_limits(const CartLimits&) = 0;
     virtual void update_robot_stiffness() = 0;
     virtual void update_robot_cp_stiffness(Eigen::VectorXd cps,Eigen::VectorXd cpd) = 0;
     virtual void update_robot_cp_exttcpft(Eigen::VectorXd ft) = 0;
@@ -52,7 +61,12 @@ public:
     virtual void waitForFinished() = 0;
     virtual RobotNameT get_robotname() = 0;
     virtual double gettimecycle() = 0;
+    //!position and axis angle
     void set_cart_command(double *);
+    //!position and orientation, the orientation is taken over without conversion
+    void set_cart_command(const Eigen::Vector3d& p, const Eigen::Quaterniond& q);
+    //!what the controllers worked on in this cycle, logged with the cycle. tacfb may be NULL.
+    void set_log_context(const TaskDesc& td, unsigned long task_switches, const myrmex_msg *tacfb);
     virtual void set_init_TM(Eigen::Matrix3d tm) = 0;
     virtual Eigen::Matrix3d get_init_TM() = 0;
     Eigen::Vector3d get_cur_cart_p();
@@ -82,7 +96,14 @@ protected:
     Eigen::Matrix3d m_init_tm;
     Eigen::Matrix3d m_TM_eigen;
     Eigen::Vector3d m_p_eigen;
+    //!position and axis angle, as logged and replayed
     double cart_command[6];
+    //!orientation of cart_command
+    Eigen::Quaterniond cart_command_q;
+    TaskDesc log_task;
+    unsigned long log_task_switches;
+    bool log_has_tacfb;
+    myrmex_msg log_tacfb;
 public:
     Eigen::Vector3d eff_force;
     Eigen::Vector3d eff_torque;
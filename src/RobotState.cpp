@@ -1,5 +1,6 @@
 #include "RobotState.h"
 #include "Util.h"
+#include "tracer.h"
 
 #define m_cog_cent 8.0
 RobotState::RobotState()
@@ -19,7 +20,7 @@ RobotState::RobotState()
         eef_position_lastT.setZero();
         eef_orientation_lastT.setZero();
         eef_vel_g.setZero();
-        eef_vel_g_lastT.setZero();
+        eef_vel_filter.set_one_pole(0.5);
         eef_acc_g.setZero();
         eef_acc_g_lastT.setZero();
         theta_old = 0.0;
@@ -40,7 +41,7 @@ RobotState::RobotState(Robot *r){
     eef_position_lastT.setZero();
     eef_orientation_lastT.setZero();
     eef_vel_g.setZero();
-    eef_vel_g_lastT.setZero();
+    eef_vel_filter.set_one_pole(0.5);
     eef_acc_g.setZero();
     eef_acc_g_lastT.setZero();
 
@@ -58,6 +59,7 @@ RobotState::RobotState(Robot *r){
 }
 
 void RobotState::updated(Robot *r){
+    TRACE_SCOPE("robot_state_updated");
     for(int i = 0; i < 7; i++){
         r->get_joint_position_mea(JntPosition_mea);
         r->q(i) = JntPosition_mea[i];
@@ -176,16 +178,16 @@ Eigen::Vector3d RobotState::EstRobotEefLVel_Ref(Robot *r){
     if((eef_position_lastT(0)==0)&&(eef_position_lastT(1)==0))
     {
         eef_vel_g.setZero();
+        eef_vel_filter.reset();
         eef_position_lastT = robot_position["eef"];
         eef_orientation_lastT = robot_orien["eef"];
     }
     else
     {
         tmp_v = (robot_position["eef"] - eef_position_lastT)/r->gettimecycle();
-        eef_vel_g = 0.5*(tmp_v + eef_vel_g_lastT);
+        eef_vel_g = eef_vel_filter.add(tmp_v);
         eef_position_lastT = robot_position["eef"];
         eef_orientation_lastT = robot_orien["eef"];
-        eef_vel_g_lastT = eef_vel_g;
     }
     return eef_vel_g;
 }
@@ -5,6 +5,7 @@
 #include "msgcontenttype.h"
 #include <map>
 #include "Util.h"
+#include "streamfilter.h"
 #include <utility> //for std::pair
 
 class RobotState{
@@ -37,8 +38,9 @@ public:
     Eigen::Vector3d eef_vel_g;
     Eigen::Vector3d eef_acc_g;
     Eigen::Vector3d eef_position_lastT;
-    Eigen::Vector3d eef_vel_g_lastT;
     Eigen::Vector3d eef_acc_g_lastT;
+    //!smooths the finite difference of the eef position, y = 0.5*(v + y_last)
+    Biquad<Eigen::Vector3d> eef_vel_filter;
     Eigen::Matrix3d eef_orientation_lastT;
     Eigen::VectorXd JntPosition_act;
     double JntPosition_mea[7];
@@ -1,14 +1,76 @@
 #include "Timer.h"
+#include <errno.h>
+
+TimerStats::TimerStats()
+    : cycles(0), overruns(0), latency_max(0), latency_mean(0), run_max(0), run_mean(0)
+{
+}
+
+int64_t PeriodicDeadline::now_ns()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC,&ts);
+    return (int64_t)ts.tv_sec*1000000000ll + ts.tv_nsec;
+}
+
+void PeriodicDeadline::sleep_until(int64_t t_ns)
+{
+    struct timespec ts;
+    ts.tv_sec = t_ns/1000000000ll;
+    ts.tv_nsec = t_ns%1000000000ll;
+    while (clock_nanosleep(CLOCK_MONOTONIC,TIMER_ABSTIME,&ts,NULL) == EINTR);
+}
+
+void PeriodicDeadline::start(int64_t period)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    period_ns = (period > 0) ? period : 1;
+    next_ns = now_ns() + period_ns;
+    m_stats = TimerStats();
+}
+
+void PeriodicDeadline::run(const std::function<void(void)>& f, int64_t woke_ns)
+{
+    int64_t deadline = next_ns;
+    f();
+    int64_t done = now_ns();
+    next_ns = deadline + period_ns;
+    uint64_t missed = 0;
+    if (done >= next_ns) {
+        //skip the periods the callback ran into instead of running them back to back
+        missed = (done - next_ns)/period_ns + 1;
+        next_ns += missed*period_ns;
+    }
+    std::lock_guard<std::mutex> lock(m_mutex);
+    double latency = 1e-3*(woke_ns - deadline);
+    double duration = 1e-3*(done - woke_ns);
+    m_stats.cycles++;
+    m_stats.overruns += missed;
+    if (latency > m_stats.latency_max)
+        m_stats.latency_max = latency;
+    if (duration > m_stats.run_max)
+        m_stats.run_max = duration;
+    m_stats.latency_mean += (latency - m_stats.latency_mean)/m_stats.cycles;
+    m_stats.run_mean += (duration - m_stats.run_mean)/m_stats.cycles;
+}
+
+TimerStats PeriodicDeadline::stats()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_stats;
+}
 
 Timer::Timer(const Timeout &timeout)
-    : _timeout(timeout)
+    : _running(false),
+      _timeout(timeout)
 {
 }
 
 Timer::Timer(const Timer::Timeout &timeout,
              const Timer::Interval &interval,
              bool singleShot)
-    : _isSingleShot(singleShot),
+    : _running(false),
+      _isSingleShot(singleShot),
       _interval(interval),
       _timeout(timeout)
 {
@@ -20,6 +82,7 @@ void Timer::start(bool multiThread)
         return;
 
     _running = true;
+    _deadline.start(std::chrono::duration_cast<std::chrono::nanoseconds>(_interval).count());
 
     if (multiThread == true) {
         _thread = std::thread(
@@ -33,7 +96,8 @@ void Timer::start(bool multiThread)
 void Timer::stop()
 {
     _running = false;
-    _thread.join();
+    if (_thread.joinable())
+        _thread.join();
 }
 
 bool Timer::running() const
@@ -94,8 +158,66 @@ void Timer::_temporize()
 
 void Timer::_sleepThenTimeout()
 {
-    std::this_thread::sleep_for(_interval);
+    PeriodicDeadline::sleep_until(_deadline.next());
 
     if (this->running() == true)
-        this->timeout()();
+        _deadline.run(this->timeout(),PeriodicDeadline::now_ns());
+}
+
+TimerWheel::TimerWheel()
+    : _running(false), _num(0)
+{
+}
+
+TimerWheel::~TimerWheel()
+{
+    stop();
+}
+
+int TimerWheel::add(const Timer::Timeout &timeout, const Timer::Interval &interval)
+{
+    if ((this->running() == true) || (_num >= TIMER_WHEEL_SLOTS))
+        return -1;
+    _timeouts[_num] = timeout;
+    _intervals[_num] = interval;
+    return _num++;
+}
+
+void TimerWheel::start()
+{
+    if (this->running() == true)
+        return;
+    for (int i = 0; i < _num; i++)
+        _deadlines[i].start(std::chrono::duration_cast<std::chrono::nanoseconds>(_intervals[i]).count());
+    _running = true;
+    _thread = std::thread(&TimerWheel::_run, this);
+}
+
+void TimerWheel::stop()
+{
+    _running = false;
+    if (_thread.joinable())
+        _thread.join();
+}
+
+TimerStats TimerWheel::stats(int id)
+{
+    if ((id < 0) || (id >= _num))
+        return TimerStats();
+    return _deadlines[id].stats();
+}
+
+void TimerWheel::_run()
+{
+    while ((this->running() == true) && (_num > 0)) {
+        int first = 0;
+        for (int i = 1; i < _num; i++) {
+            if (_deadlines[i].next() < _deadlines[first].next())
+                first = i;
+        }
+        PeriodicDeadline::sleep_until(_deadlines[first].next());
+        if (this->running() == false)
+            break;
+        _deadlines[first].run(_timeouts[first],PeriodicDeadline::now_ns());
+    }
 }
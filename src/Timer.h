@@ -3,11 +3,57 @@
 
 #include <thread>
 #include <chrono>
+#include <atomic>
+#include <mutex>
+#include <functional>
+#include <stdint.h>
+#include <time.h>
+
+//!timers one TimerWheel thread can host
+#define TIMER_WHEEL_SLOTS 8
+
+//!timing of a periodic callback, latencies in us
+struct TimerStats{
+    TimerStats();
+    //!callbacks run
+    uint64_t cycles;
+    //!periods missed because a callback ran past the next deadline, they are skipped
+    uint64_t overruns;
+    //!wakeup after the deadline
+    double latency_max;
+    double latency_mean;
+    //!duration of the callback
+    double run_max;
+    double run_mean;
+};
 
+//!deadline bookkeeping of one periodic callback on CLOCK_MONOTONIC
+class PeriodicDeadline
+{
+public:
+    PeriodicDeadline() : period_ns(0), next_ns(0){}
+    //!first deadline one period from now
+    void start(int64_t period);
+    int64_t next(){return next_ns;}
+    //!call the callback for the deadline that passed at woke_ns and advance it
+    void run(const std::function<void(void)>& f, int64_t woke_ns);
+    TimerStats stats();
+    static int64_t now_ns();
+    //!sleep until t_ns, EINTR does not wake early
+    static void sleep_until(int64_t t_ns);
+private:
+    int64_t period_ns;
+    int64_t next_ns;
+    TimerStats m_stats;
+    std::mutex m_mutex;
+};
+
+//!periodic or single shot callback on its own thread or the calling one. Deadlines
+//!are absolute, so the period does not drift with the callback duration.
 class Timer
 {
 public:
-    typedef std::chrono::milliseconds Interval;
+    typedef std::chrono::microseconds Interval;
     typedef std::function<void(void)> Timeout;
 
     Timer(const Timeout &timeout);
@@ -29,20 +75,44 @@ public:
     void setTimeout(const Timeout &timeout);
     const Timeout &timeout() const;
 
+    TimerStats stats(){return _deadline.stats();}
+
 private:
     std::thread _thread;
 
-    bool _running = false;
+    std::atomic<bool> _running;
     bool _isSingleShot = true;
 
     Interval _interval = Interval(0);
     Timeout _timeout = nullptr;
+    PeriodicDeadline _deadline;
 
     void _temporize();
     void _sleepThenTimeout();
 };
 
-
+//!one thread running up to TIMER_WHEEL_SLOTS periodic callbacks of different
+//!rates, always the one with the earliest deadline next
+class TimerWheel
+{
+public:
+    TimerWheel();
+    ~TimerWheel();
+    //!add a periodic callback before start, -1 if the wheel is full
+    int add(const Timer::Timeout &timeout, const Timer::Interval &interval);
+    void start();
+    void stop();
+    bool running() const {return _running.load();}
+    TimerStats stats(int id);
+private:
+    void _run();
+    std::thread _thread;
+    std::atomic<bool> _running;
+    int _num;
+    Timer::Timeout _timeouts[TIMER_WHEEL_SLOTS];
+    Timer::Interval _intervals[TIMER_WHEEL_SLOTS];
+    PeriodicDeadline _deadlines[TIMER_WHEEL_SLOTS];
+};
 
 
 #endif // TIMER_H
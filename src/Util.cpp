@@ -1,140 +1,90 @@
 #include "Util.h"
 
-Eigen::Vector3d euler2axisangle(Eigen::Vector3d la,Eigen::Matrix3d tm){
-	Eigen::Vector3d CtrlAxisAngle;
-	Eigen::Matrix3d DesiredMatrix;
-	DesiredMatrix = euler2tm(la,tm);
-	CtrlAxisAngle = tm2axisangle(DesiredMatrix);
-	return CtrlAxisAngle;
+#include <cmath>
+
+//!sin and cos of one angle in one call
+static inline void sin_cos(double a, double& s, double& c){
+#ifdef __GLIBC__
+	sincos(a,&s,&c);
+#else
+	s = sin(a);
+	c = cos(a);
+#endif
 }
 
-Eigen::Vector3d g_euler2axisangle(Eigen::Vector3d la,Eigen::Matrix3d tm){
-	Eigen::Vector3d CtrlAxisAngle;
-	Eigen::Matrix3d DesiredMatrix;
-// 	std::cout<<"la are "<<la(0)<<","<<la(1)<<","<<la(2)<<std::endl;
-	DesiredMatrix = g_euler2tm(la,tm);
-	CtrlAxisAngle = tm2axisangle(DesiredMatrix);
-	return CtrlAxisAngle;
-}
-
-Eigen::Matrix3d euler2tm(Eigen::Vector3d la,Eigen::Matrix3d tm){
-	Eigen::Matrix3d DeltaMatrix_z;
-	Eigen::Matrix3d DeltaMatrix_x;
-	Eigen::Matrix3d DeltaMatrix_y;
-	Eigen::Matrix3d DesiredMatrix;
-	double DeltaAlfa,DeltaBeta,DeltaGama;
-	
-	
-	DeltaMatrix_z.setIdentity();
-	DeltaMatrix_x.setIdentity();
-	DeltaMatrix_y.setIdentity();
-	
-	DeltaAlfa = la(0);
-	DeltaBeta = la(1);
-	DeltaGama = la(2);
-	
-	DeltaMatrix_z(0,0) = cos(DeltaGama);
-	DeltaMatrix_z(0,1) = (-1)*sin(DeltaGama);
-	DeltaMatrix_z(1,0) = sin(DeltaGama);
-	DeltaMatrix_z(1,1) = cos(DeltaGama);
-	
-	DeltaMatrix_x(1,1) = cos(DeltaAlfa);
-	DeltaMatrix_x(1,2) = (-1)*sin(DeltaAlfa);
-	DeltaMatrix_x(2,1) = sin(DeltaAlfa);
-	DeltaMatrix_x(2,2) = cos(DeltaAlfa);
-	
-	DeltaMatrix_y(0,0) = cos(DeltaBeta);
-	DeltaMatrix_y(0,2) = sin(DeltaBeta);
-	DeltaMatrix_y(2,0) = (-1)*sin(DeltaBeta);
-	DeltaMatrix_y(2,2) = cos(DeltaBeta);
-	
-	DesiredMatrix = tm * DeltaMatrix_z * DeltaMatrix_y * DeltaMatrix_x;
-	return DesiredMatrix;
-}
-
-Eigen::Matrix3d g_euler2tm(Eigen::Vector3d la,Eigen::Matrix3d tm){
-	Eigen::Matrix3d DeltaMatrix_z;
-	Eigen::Matrix3d DeltaMatrix_x;
-	Eigen::Matrix3d DeltaMatrix_y;
-	Eigen::Matrix3d DesiredMatrix;
-	double DeltaAlfa,DeltaBeta,DeltaGama;
-	
-	DeltaMatrix_z.setIdentity();
-	DeltaMatrix_x.setIdentity();
-	DeltaMatrix_y.setIdentity();
-	
-	DeltaAlfa = la(0);
-	DeltaBeta = la(1);
-	DeltaGama = la(2);
-	
-	DeltaMatrix_z(0,0) = cos(DeltaGama);
-	DeltaMatrix_z(0,1) = (-1)*sin(DeltaGama);
-	DeltaMatrix_z(1,0) = sin(DeltaGama);
-	DeltaMatrix_z(1,1) = cos(DeltaGama);
-	
-	DeltaMatrix_x(1,1) = cos(DeltaAlfa);
-	DeltaMatrix_x(1,2) = (-1)*sin(DeltaAlfa);
-	DeltaMatrix_x(2,1) = sin(DeltaAlfa);
-	DeltaMatrix_x(2,2) = cos(DeltaAlfa);
-	
-	DeltaMatrix_y(0,0) = cos(DeltaBeta);
-	DeltaMatrix_y(0,2) = sin(DeltaBeta);
-	DeltaMatrix_y(2,0) = (-1)*sin(DeltaBeta);
-	DeltaMatrix_y(2,2) = cos(DeltaBeta);
-	
-	DesiredMatrix = DeltaMatrix_x * DeltaMatrix_y * DeltaMatrix_z * tm;
-	return DesiredMatrix;
-}
-
-
-Eigen::Vector3d tm2axisangle(Eigen::Matrix3d tm){
-	Eigen::Vector3d CtrlAxisAngle;
-	Eigen::Matrix3d DesiredMatrix;
-	Eigen::Vector3d Desiredomega;
-	double mtrace;
-	double Desiredtheta;
-	
-	DesiredMatrix = tm;
-	mtrace = DesiredMatrix.trace();
-	if(mtrace < -1){
-		mtrace = -1;
-	}
-	if(mtrace > 3){
-		mtrace = 3;
+//!angle in [0,pi] and unit axis of tm, the axis is z for the identity
+static double rotation_angle_axis(const Eigen::Matrix3d& tm, Eigen::Vector3d& axis){
+	//2*sin(theta)*axis and 2*cos(theta)
+	Eigen::Vector3d w(tm(2,1) - tm(1,2),tm(0,2) - tm(2,0),tm(1,0) - tm(0,1));
+	double s2 = w.norm();
+	double c2 = tm.trace() - 1.0;
+	double theta = atan2(s2,c2);
+	if(c2 >= 0.0){
+		if(s2 > 0.0)
+			axis = w / s2;
+		else
+			axis = Eigen::Vector3d::UnitZ();
+		return theta;
 	}
-	Desiredtheta = acos((mtrace-1)/2);
-	Desiredomega(0) = (DesiredMatrix(2,1) - DesiredMatrix(1,2));
-	Desiredomega(1) = (DesiredMatrix(0,2) - DesiredMatrix(2,0));
-	Desiredomega(2) = (DesiredMatrix(1,0) - DesiredMatrix(0,1));
-	Desiredomega *= (1.0/(2*sin(Desiredtheta)));
-	CtrlAxisAngle = Desiredomega.normalized()*Desiredtheta; 
-	return CtrlAxisAngle;
-}
-
-std::pair<Eigen::Vector3d,double> tm2axisangle_4(Eigen::Matrix3d tm,bool& b){
-    Eigen::Vector3d CtrlAxisAngle;
-    Eigen::Matrix3d DesiredMatrix;
-    Eigen::Vector3d Desiredomega;
-    std::pair<Eigen::Vector3d,double> ax;
-    double mtrace;
-    double Desiredtheta;
+	//w vanishes towards pi, there the symmetric part tm+tm^T-2cos*I = 2(1-cos)*axis*axis^T
+	//gives the axis and w only its sign
+	Eigen::Matrix3d b = tm + tm.transpose();
+	b.diagonal().array() -= c2;
+	int k;
+	b.diagonal().maxCoeff(&k);
+	axis = b.col(k).normalized();
+	if(axis.dot(w) < 0.0)
+		axis = -axis;
+	return theta;
+}
 
-    DesiredMatrix = tm;
-    mtrace = DesiredMatrix.trace();
-    if(mtrace < -1){
-        mtrace = -1;
-    }
-    if(mtrace > 3){
-        mtrace = 3;
-    }
-    if(fabs(mtrace-3) >= 0.00001){
-        Desiredtheta = acos((mtrace-1)/2);
-        Desiredomega(0) = (DesiredMatrix(2,1) - DesiredMatrix(1,2));
-        Desiredomega(1) = (DesiredMatrix(0,2) - DesiredMatrix(2,0));
-        Desiredomega(2) = (DesiredMatrix(1,0) - DesiredMatrix(0,1));
-        Desiredomega *= (1.0/(2*sin(Desiredtheta)));
-        ax.first = Desiredomega.normalized();
-        ax.second = Desiredtheta;
+Eigen::Vector3d euler2axisangle(const Eigen::Vector3d& la,const Eigen::Matrix3d& tm){
+	return tm2axisangle(euler2tm(la,tm));
+}
+
+Eigen::Vector3d g_euler2axisangle(const Eigen::Vector3d& la,const Eigen::Matrix3d& tm){
+// 	std::cout<<"la are "<<la(0)<<","<<la(1)<<","<<la(2)<<std::endl;
+	return tm2axisangle(g_euler2tm(la,tm));
+}
+
+//!tm * Rz(la(2)) * Ry(la(1)) * Rx(la(0))
+Eigen::Matrix3d euler2tm(const Eigen::Vector3d& la,const Eigen::Matrix3d& tm){
+	double sa,ca,sb,cb,sg,cg;
+	sin_cos(la(0),sa,ca);
+	sin_cos(la(1),sb,cb);
+	sin_cos(la(2),sg,cg);
+	Eigen::Matrix3d DeltaMatrix;
+	DeltaMatrix << cg*cb, cg*sb*sa - sg*ca, cg*sb*ca + sg*sa,
+	               sg*cb, sg*sb*sa + cg*ca, sg*sb*ca - cg*sa,
+	               -sb,   cb*sa,            cb*ca;
+	return tm * DeltaMatrix;
+}
+
+//!Rx(la(0)) * Ry(la(1)) * Rz(la(2)) * tm
+Eigen::Matrix3d g_euler2tm(const Eigen::Vector3d& la,const Eigen::Matrix3d& tm){
+	double sa,ca,sb,cb,sg,cg;
+	sin_cos(la(0),sa,ca);
+	sin_cos(la(1),sb,cb);
+	sin_cos(la(2),sg,cg);
+	Eigen::Matrix3d DeltaMatrix;
+	DeltaMatrix << cb*cg,                -cb*sg,                sb,
+	               ca*sg + sa*sb*cg,     ca*cg - sa*sb*sg,      -sa*cb,
+	               sa*sg - ca*sb*cg,     sa*cg + ca*sb*sg,      ca*cb;
+	return DeltaMatrix * tm;
+}
+
+
+Eigen::Vector3d tm2axisangle(const Eigen::Matrix3d& tm){
+	Eigen::Vector3d axis;
+	double theta = rotation_angle_axis(tm,axis);
+	return axis * theta;
+}
+
+std::pair<Eigen::Vector3d,double> tm2axisangle_4(const Eigen::Matrix3d& tm,bool& b){
+    std::pair<Eigen::Vector3d,double> ax;
+    //no usable axis for (almost) no rotation
+    if(fabs(tm.trace()-3) >= 0.00001){
+        ax.second = rotation_angle_axis(tm,ax.first);
         b = true;
     }
     else{
@@ -147,21 +97,45 @@ std::pair<Eigen::Vector3d,double> tm2axisangle_4(Eigen::Matrix3d tm,bool& b){
     return ax;
 }
 
+Eigen::Vector3d quat2axisangle(const Eigen::Quaterniond& q){
+	double n = q.vec().norm();
+	if(n == 0.0)
+		return Eigen::Vector3d::Zero();
+	//the sign of w picks the rotation of at most pi
+	double w = q.w();
+	double theta = 2.0*atan2(n,fabs(w));
+	return q.vec() * ((w < 0.0 ? -theta : theta) / n);
+}
+
+Eigen::Quaterniond axisangle2quat(const Eigen::Vector3d& ax){
+	double theta = ax.norm();
+	double s,c;
+	sin_cos(0.5*theta,s,c);
+	//sin(theta/2)/theta without the division for tiny angles
+	double k = (theta > 1e-8) ? s/theta : 0.5;
+	return Eigen::Quaterniond(c,k*ax(0),k*ax(1),k*ax(2));
+}
+
+void quat_integrate(Eigen::Quaterniond& q, const Eigen::Vector3d& w, double dt){
+	q = q * axisangle2quat(dt*w);
+	q.normalize();
+}
 
-double _smooth_filter(std::deque<double> t){
-  /* #include <numeric>
-      double sum = std::accumulate(t.begin(),e.end(), 0.0);
-      return sum/t.size();
-      */
-	double sum;
-	sum = 0;
-	for (std::deque<double>::iterator it = t.begin(); it!=t.end(); ++it)
-		sum+= *it;
-	return sum/t.size();
+bool quat_cone_limit(Eigen::Quaterniond& q, double min_w){
+	//|w| = cos(angle/2), inside the cone this is all there is to check
+	if(fabs(q.w()) >= min_w)
+		return false;
+	double n = q.vec().norm();
+	double s = sqrt(1.0 - min_w*min_w);
+	double sign = (q.w() < 0.0) ? -1.0 : 1.0;
+	q.w() = sign*min_w;
+	if(n > 0.0)
+		q.vec() *= s/n;
+	return true;
 }
 
 
-Eigen::Matrix3d GetSkrewFromVector(Eigen::Vector3d vec){
+Eigen::Matrix3d GetSkrewFromVector(const Eigen::Vector3d& vec){
 	Eigen::Matrix3d SkrewM = Eigen::Matrix3d::Zero();
 	SkrewM(0,0) = 0;
 	SkrewM(0,1) = -vec(2);
@@ -175,7 +149,7 @@ Eigen::Matrix3d GetSkrewFromVector(Eigen::Vector3d vec){
 	return SkrewM;
 }
 
-Eigen::Matrix3d makeSkewSymmetric(Eigen::Vector3d vec){
+static Eigen::Matrix3d makeSkewSymmetric(const Eigen::Vector3d& vec){
 	Eigen::Matrix3d v;
 	v.setZero();
 	v(0,1) = -vec(2);
@@ -187,7 +161,7 @@ Eigen::Matrix3d makeSkewSymmetric(Eigen::Vector3d vec){
 	return v;
 }
 
-Eigen::Matrix3d AlignVec(Eigen::Vector3d cur, Eigen::Vector3d des){
+Eigen::Matrix3d AlignVec(const Eigen::Vector3d& cur, const Eigen::Vector3d& des){
 	Eigen::Vector3d vec;
 	Eigen::Matrix3d E,tm,v;
 	double s,c;
@@ -238,11 +212,11 @@ Eigen::Matrix3d kdl2eigen_orien(const KDL::Frame& f){
     return m;
 }
 
-void global2local(Eigen::Vector3d g, Eigen::Matrix3d M, Eigen::Vector3d &l){
+void global2local(const Eigen::Vector3d& g, const Eigen::Matrix3d& M, Eigen::Vector3d &l){
     l = M.transpose() *g;
 }
 
-std::pair<Eigen::Vector3d,double> omega_transform(std::pair<Eigen::Vector3d,Eigen::Vector3d> r_ax,Eigen::Matrix3d R_rinit_linit){
+std::pair<Eigen::Vector3d,double> omega_transform(const std::pair<Eigen::Vector3d,Eigen::Vector3d>& r_ax,const Eigen::Matrix3d& R_rinit_linit){
     std::pair<Eigen::Vector3d,double> l_ax;
     l_ax.first = R_rinit_linit * r_ax.first;
     l_ax.second = r_ax.second(0);
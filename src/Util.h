@@ -1,24 +1,30 @@
 #pragma once
 
 #include <iostream>
-#include <deque>
 #include <time.h> //for program running test(cpu consuming time)
 #include <sys/time.h>//for program running test(realtime consuming test)
 #include <Eigen/Dense>
 #include <kdl/frames.hpp>
 #include <utility>
 
-extern Eigen::Vector3d euler2axisangle(Eigen::Vector3d la,Eigen::Matrix3d tm);
-extern Eigen::Vector3d g_euler2axisangle(Eigen::Vector3d la,Eigen::Matrix3d tm);
-extern Eigen::Vector3d tm2axisangle(Eigen::Matrix3d tm);
-extern std::pair<Eigen::Vector3d,double>  tm2axisangle_4(Eigen::Matrix3d,bool&);
-extern Eigen::Matrix3d g_euler2tm(Eigen::Vector3d la,Eigen::Matrix3d tm);
-extern Eigen::Matrix3d euler2tm(Eigen::Vector3d la,Eigen::Matrix3d tm);
-extern double _smooth_filter(std::deque<double> t);
-extern Eigen::Matrix3d GetSkrewFromVector(Eigen::Vector3d vec);
+extern Eigen::Vector3d euler2axisangle(const Eigen::Vector3d& la,const Eigen::Matrix3d& tm);
+extern Eigen::Vector3d g_euler2axisangle(const Eigen::Vector3d& la,const Eigen::Matrix3d& tm);
+//!rotation vector (axis*angle, angle in [0,pi]) of tm, accurate near 0 and pi
+extern Eigen::Vector3d tm2axisangle(const Eigen::Matrix3d& tm);
+extern std::pair<Eigen::Vector3d,double>  tm2axisangle_4(const Eigen::Matrix3d&,bool&);
+//!rotation vector of q, the shorter of the two rotations q and -q describe
+extern Eigen::Vector3d quat2axisangle(const Eigen::Quaterniond& q);
+extern Eigen::Quaterniond axisangle2quat(const Eigen::Vector3d& ax);
+//!q turned by the body rate w (rad/s) over dt, kept unit length
+extern void quat_integrate(Eigen::Quaterniond& q, const Eigen::Vector3d& w, double dt);
+//!limits the rotation of q to a cone, min_w = cos(max angle/2). True if q was limited
+extern bool quat_cone_limit(Eigen::Quaterniond& q, double min_w);
+extern Eigen::Matrix3d g_euler2tm(const Eigen::Vector3d& la,const Eigen::Matrix3d& tm);
+extern Eigen::Matrix3d euler2tm(const Eigen::Vector3d& la,const Eigen::Matrix3d& tm);
+extern Eigen::Matrix3d GetSkrewFromVector(const Eigen::Vector3d& vec);
 extern long long timeval_diff(struct timeval *difference, struct timeval *end_time, struct timeval *start_time);
-extern Eigen::Matrix3d AlignVec(Eigen::Vector3d cur, Eigen::Vector3d des);
+extern Eigen::Matrix3d AlignVec(const Eigen::Vector3d& cur, const Eigen::Vector3d& des);
 extern Eigen::Vector3d kdl2eigen_position(const KDL::Frame& f);
 extern Eigen::Matrix3d kdl2eigen_orien(const KDL::Frame& f);
-extern void global2local(Eigen::Vector3d, Eigen::Matrix3d, Eigen::Vector3d &);
-extern std::pair<Eigen::Vector3d,double> omega_transform(std::pair<Eigen::Vector3d,Eigen::Vector3d>,Eigen::Matrix3d);
+extern void global2local(const Eigen::Vector3d&, const Eigen::Matrix3d&, Eigen::Vector3d &);
+extern std::pair<Eigen::Vector3d,double> omega_transform(const std::pair<Eigen::Vector3d,Eigen::Vector3d>&,const Eigen::Matrix3d&);
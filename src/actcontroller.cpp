@@ -11,39 +11,50 @@
 //taskctrlpara ActController::task_ctrl_param[COVER_OBJECT_SURFACE];
 //taskctrlpara ActController::task_ctrl_param[OBJECT_SURFACE_EXPLORING];
 
-Eigen::Vector3d ActController::llv;
-Eigen::Vector3d ActController::lov;
-
-ActController::ActController(ParameterManager& p)
+ActController::ActController(const ParamSet& p) : pm(p)
 {
+    ActController::reset();
+}
+
+void ActController::reset(){
     glv.setZero();
     gov.setZero();
     eff_p_command.setZero();
     eff_o_command_vec.setZero();
     eff_o_command_mat.setZero();
     m_init_tm.setIdentity();
+    m_init_q.setIdentity();
 
 
     m_llv_limit.setZero();
     m_llv_limit(0) = 0.05;
     m_llv_limit(1) = 0.05;
     m_llv_limit(2) = 0.05;
-    m_euler_limit(0) = 0.2;
-    m_euler_limit(1) = 0.2;
-    m_euler_limit(2) = 0.2;
-    pose_o_eigen_l.setZero();
-    pm = p;
+    set_orien_limit(DEFAULT_ORIEN_LIMIT);
+    pose_o_q_l.setIdentity();
+    m_cycle_time = DEFAULT_CYCLE_TIME;
 }
 
+void ActController::set_init_TM(const Eigen::Matrix3d& tm){
+    m_init_tm = tm;
+    m_init_q = Eigen::Quaterniond(tm);
+    m_init_q.normalize();
+}
+
+void ActController::set_orien_limit(double angle){
+    m_orien_limit = angle;
+    m_orien_limit_w = cos(0.5*angle);
+}
 
 
-void ActController::local_to_global(const Eigen::Vector3d p_in, const Eigen::Matrix3d o_in,\
-                                    const Eigen::Vector3d lv, const Eigen::Vector3d ov,\
-                                    Eigen::Vector3d& p_out, Eigen::Vector3d& o_out)
+
+void ActController::local_to_global(const Eigen::Vector3d& p_in, const Eigen::Matrix3d& o_in,\
+                                    const Eigen::Vector3d& lv, const Eigen::Vector3d& ov,\
+                                    Eigen::Vector3d& p_out, Eigen::Quaterniond& o_out)
 {
     p_out = p_in + o_in * lv;
-    pose_o_eigen_l += 0.004*ov;
-    o_out = euler2axisangle(pose_o_eigen_l,m_init_tm);
+    quat_integrate(pose_o_q_l,ov,m_cycle_time);
+    o_out = m_init_q * pose_o_q_l;
 }
 
 
@@ -60,15 +71,8 @@ void ActController::limit_vel(Eigen::Vector3d lim,\
     }
 }
 
-void ActController::limit_eef_euler(Eigen::Vector3d lim){
-    for(int i = 0; i < 3; i++){
-        if(pose_o_eigen_l(i) > lim(i)){
-            pose_o_eigen_l(i) = lim(i);
-        }
-        if(pose_o_eigen_l(i) < -lim(i)){
-            pose_o_eigen_l(i) = -lim(i);
-        }
-    }
+void ActController::limit_eef_orien(){
+    quat_cone_limit(pose_o_q_l,m_orien_limit_w);
 }
 
 
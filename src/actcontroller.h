@@ -8,12 +8,18 @@
 #include "msgcontenttype.h"
 #include "parametermanager.h"
 
+//!used until the robot reports its cycle time (seconds)
+#define DEFAULT_CYCLE_TIME 0.004
+//!largest rotation of the integrated orientation away from the initial one (rad)
+#define DEFAULT_ORIEN_LIMIT 0.2
 
 class Robot;
 class ActController
 {
 public:
-    ActController(ParameterManager& );
+    EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+    ActController(const ParamSet& p);
+    virtual ~ActController(){}
     virtual void update_robot_reference(Robot *) = 0;
     virtual void update_robot_reference(Robot *, Task *) = 0;
     virtual void update_robot_reference(Robot *, Task *,myrmex_msg *) = 0;
@@ -22,34 +28,48 @@ public:
     virtual void update_controller_para_stiffness() = 0;
     virtual void updateTacServoCtrlParam(TACTaskNameT) = 0;
     virtual void updateProServoCtrlParam(PROTaskNameT tnt) = 0;
-    virtual void set_init_TM(Eigen::Matrix3d tm) = 0;
+    //!orientation the local orientation is integrated from
+    virtual void set_init_TM(const Eigen::Matrix3d& tm);
     virtual void get_desired_lv(Robot *, Task *) = 0;
     virtual void get_desired_lv(Robot *, Task *, myrmex_msg *) = 0;
     virtual void get_lv(Eigen::Vector3d& lv, Eigen::Vector3d& ov) = 0;
-    virtual void set_pm(ParameterManager &p) = 0;
-    void local_to_global(const Eigen::Vector3d p_in, const Eigen::Matrix3d o_in,\
-                         const Eigen::Vector3d lv, const Eigen::Vector3d ov,\
-                        Eigen::Vector3d& p_out, Eigen::Vector3d& o_out);
+    //!take over a new parameter set, gains changed at run time are dropped
+    virtual void set_pm(const ParamSet& p) = 0;
+    //!back to the state after construction, without allocating
+    virtual void reset();
+    //!p_out is p_in moved by lv in the frame o_in, o_out the initial orientation
+    //!turned by the integrated body rate ov
+    void local_to_global(const Eigen::Vector3d& p_in, const Eigen::Matrix3d& o_in,\
+                         const Eigen::Vector3d& lv, const Eigen::Vector3d& ov,\
+                         Eigen::Vector3d& p_out, Eigen::Quaterniond& o_out);
 
     Eigen::Matrix3d m_init_tm;
     void set_llv_limit(Eigen::Vector3d lv){m_llv_limit = lv;}
     Eigen::Vector3d get_llv_limit(){return m_llv_limit;}
-    void set_euler_limit(Eigen::Vector3d euler){m_euler_limit = euler;}
-    Eigen::Vector3d get_euler_limit(){return m_euler_limit;}
-    Eigen::Vector3d pose_o_eigen_l;
+    //!cone around the initial orientation the integrated orientation stays in (rad)
+    void set_orien_limit(double angle);
+    double get_orien_limit(){return m_orien_limit;}
+    //!integrated orientation relative to m_init_tm
+    Eigen::Quaterniond pose_o_q_l;
     void limit_vel(Eigen::Vector3d,\
                    Eigen::Vector3d&, Eigen::Vector3d&);
-    void limit_eef_euler(Eigen::Vector3d lim);
-    static Eigen::Vector3d llv,lov;
-    ParameterManager pm;
+    void limit_eef_orien();
+    //!integration step of local_to_global, non-positive values are ignored
+    void set_cycle_time(double t){if(t > 0) m_cycle_time = t;}
+    double get_cycle_time(){return m_cycle_time;}
+    //!shared with the other controllers, not copied
+    ParamSet pm;
 protected:
     double cart_command[6];
     Eigen::Vector3d glv,gov;
     Eigen::Vector3d eff_p_command, eff_o_command_vec;
     Eigen::Matrix3d eff_o_command_mat;
     Eigen::Vector3d m_llv_limit;
-    Eigen::Vector3d m_euler_limit;
-
+    Eigen::Quaterniond m_init_q;
+    double m_orien_limit;
+    //!cos(m_orien_limit/2), see quat_cone_limit
+    double m_orien_limit_w;
+    double m_cycle_time;
 
 };
 
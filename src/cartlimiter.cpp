@@ -0,0 +1,128 @@
+#include "cartlimiter.h"
+#include "Util.h"
+#include <math.h>
+#include <algorithm>
+
+//!a step that ends closer than this to the target is put on the target
+#define CART_SETTLE_EPS 1e-9
+//!velocity loop gain relative to the position loop, whose gain near the target is 1/ramp
+#define CART_VEL_GAIN 4.0
+//!fraction of the acceleration limit the approach to a target is planned with
+#define CART_BRAKE 0.5
+//!used until a positive cycle time is set (seconds)
+#define CART_DEFAULT_CYCLE_TIME 0.004
+
+CartLimits::CartLimits()
+{
+    lin_vel = 0.25;
+    lin_acc = 1.0;
+    lin_jerk = 20.0;
+    rot_vel = 1.0;
+    rot_acc = 4.0;
+    rot_jerk = 80.0;
+}
+
+static Eigen::Vector3d clamp_norm(const Eigen::Vector3d& x, double lim){
+    double n = x.norm();
+    if(n > lim)
+        return x * (lim/n);
+    return x;
+}
+
+CartLimiter::CartLimiter(double t, const CartLimits& l)
+{
+    limits = l;
+    cycle_time = CART_DEFAULT_CYCLE_TIME;
+    set_cycle_time(t);
+    initialised = false;
+    has_target = false;
+    last_p_target.setZero();
+    last_q_target.setIdentity();
+    pos.setZero();
+    orien.setIdentity();
+    lin_v.setZero();
+    lin_a.setZero();
+    rot_v.setZero();
+    rot_a.setZero();
+}
+
+void CartLimiter::reset(const Eigen::Vector3d& p, const Eigen::Matrix3d& o){
+    pos = p;
+    orien = Eigen::Quaterniond(o);
+    orien.normalize();
+    lin_v.setZero();
+    lin_a.setZero();
+    rot_v.setZero();
+    rot_a.setZero();
+    has_target = false;
+    initialised = true;
+}
+
+void CartLimiter::shape(const Eigen::Vector3d& e, const Eigen::Vector3d& vt, Eigen::Vector3d& v,\
+                        Eigen::Vector3d& a, double v_max, double a_max, double j_max){
+    double dt = cycle_time;
+    //displacement relative to the moving target after this cycle
+    Eigen::Vector3d e_rel = e - vt*dt;
+    double d = e_rel.norm();
+    //fastest approach that still stops within d: braking at a fraction of a_max after
+    //the jerk ramp, the rest is left for the lag of the velocity loop
+    double a_b = CART_BRAKE*a_max;
+    double ramp = a_b/(2*j_max);
+    double v_stop = a_b*(sqrt(ramp*ramp + 2*d/a_b) - ramp);
+    Eigen::Vector3d v_d = clamp_norm(vt + clamp_norm(e_rel/dt,v_stop),v_max);
+    //the acceleration is ramped down in time to reach v_d without overshooting it
+    Eigen::Vector3d dv = v_d - v;
+    Eigen::Vector3d a_d = clamp_norm(CART_VEL_GAIN*dv/ramp,std::min(a_max,sqrt(j_max*dv.norm())));
+    Eigen::Vector3d j = clamp_norm((a_d - a)/dt,j_max);
+    a += j*dt;
+    v = clamp_norm(v + a*dt,v_max);
+}
+
+void CartLimiter::limit(const Eigen::Vector3d& p_target, const Eigen::Quaterniond& q_target,\
+                        Eigen::Vector3d& p_out, Eigen::Quaterniond& q_out){
+    if(initialised == false)
+        reset(p_target,q_target.toRotationMatrix());
+    double dt = cycle_time;
+    if(has_target == false){
+        last_p_target = p_target;
+        last_q_target = q_target;
+        has_target = true;
+    }
+    //velocity of the target, estimated from its last step
+    Eigen::Vector3d vt_p = (p_target - last_p_target)/dt;
+    //rotations as the log map of the quaternion, accurate for small steps
+    Eigen::Vector3d vt_o = quat2axisangle(q_target * last_q_target.conjugate())/dt;
+    last_p_target = p_target;
+    last_q_target = q_target;
+    //remaining displacement, the rotation as rotation vector in the base frame
+    Eigen::Vector3d e_p = p_target - pos;
+    Eigen::Vector3d e_o = quat2axisangle(q_target * orien.conjugate());
+    shape(e_p,vt_p,lin_v,lin_a,limits.lin_vel,limits.lin_acc,limits.lin_jerk);
+    shape(e_o,vt_o,rot_v,rot_a,limits.rot_vel,limits.rot_acc,limits.rot_jerk);
+    //a step that lands on the target is taken exactly, this keeps commands within the limits unchanged
+    if((lin_v*dt - e_p).norm() < CART_SETTLE_EPS)
+        pos = p_target;
+    else
+        pos += lin_v*dt;
+    if((rot_v*dt - e_o).norm() < CART_SETTLE_EPS){
+        orien = q_target;
+    }
+    else{
+        orien = axisangle2quat(rot_v*dt) * orien;
+    }
+    orien.normalize();
+    p_out = pos;
+    q_out = orien;
+}
+
+void CartLimiter::limit(const double *c_in, double *c_out){
+    Eigen::Vector3d p(c_in[0],c_in[1],c_in[2]);
+    Eigen::Vector3d o(c_in[3],c_in[4],c_in[5]);
+    Eigen::Quaterniond q = axisangle2quat(o);
+    limit(p,q,p,q);
+    o = quat2axisangle(q);
+    for(int i = 0; i < 3; i++){
+        c_out[i] = p(i);
+        c_out[i+3] = o(i);
+    }
+}
@@ -0,0 +1,62 @@
+#ifndef CARTLIMITER_H
+#define CARTLIMITER_H
+#include <Eigen/Dense>
+#include <Eigen/Geometry>
+
+//!norm limits of the tcp twist, translation in m/s, m/s^2, m/s^3 and
+//!rotation in rad/s, rad/s^2, rad/s^3
+struct CartLimits{
+    CartLimits();
+    double lin_vel;
+    double lin_acc;
+    double lin_jerk;
+    double rot_vel;
+    double rot_acc;
+    double rot_jerk;
+};
+
+//!limits the cartesian pose command before it becomes the CBF reference. The
+//!command is tracked by a twist whose velocity, acceleration and jerk norms are
+//!bounded for translation and rotation separately, so the direction of the
+//!motion is kept. Approaching a target the speed is capped so that the tcp can
+//!still stop there. A moving target is followed with its velocity estimated from
+//!the last command. Commands within the limits pass unchanged.
+class CartLimiter
+{
+public:
+    EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+    CartLimiter(double t, const CartLimits& l = CartLimits());
+    void set_limits(const CartLimits& l){limits = l;}
+    const CartLimits& get_limits(){return limits;}
+    void set_cycle_time(double t){if(t > 0) cycle_time = t;}
+    //!start at rest at the pose p,o
+    void reset(const Eigen::Vector3d& p, const Eigen::Matrix3d& o);
+    bool is_initialised(){return initialised;}
+    //!the next command has to be preceded by a reset
+    void invalidate(){initialised = false;}
+    //!one cycle towards the target pose, returns the limited pose
+    void limit(const Eigen::Vector3d& p_target, const Eigen::Quaterniond& q_target,\
+               Eigen::Vector3d& p_out, Eigen::Quaterniond& q_out);
+    //!limit a cartesian command (position, axis angle) into c_out, c_in and c_out may be the same
+    void limit(const double *c_in, double *c_out);
+    void get_twist(Eigen::Vector3d& v, Eigen::Vector3d& w){v = lin_v; w = rot_v;}
+private:
+    //!one cycle of the twist state v,a towards the remaining displacement e of
+    //!a target moving with vt
+    void shape(const Eigen::Vector3d& e, const Eigen::Vector3d& vt, Eigen::Vector3d& v,\
+               Eigen::Vector3d& a, double v_max, double a_max, double j_max);
+    CartLimits limits;
+    double cycle_time;
+    bool initialised;
+    //!target of the last cycle, its change estimates the target velocity
+    bool has_target;
+    Eigen::Vector3d last_p_target;
+    Eigen::Quaterniond last_q_target;
+    Eigen::Vector3d pos;
+    Eigen::Quaterniond orien;
+    Eigen::Vector3d lin_v,lin_a;
+    //!angular velocity and acceleration in the base frame
+    Eigen::Vector3d rot_v,rot_a;
+};
+
+#endif // CARTLIMITER_H
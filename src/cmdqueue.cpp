@@ -0,0 +1,25 @@
+#include "cmdqueue.h"
+
+CmdQueue::CmdQueue() : m_head(0), m_tail(0)
+{
+    for(int i = 0; i < CMD_QUEUE_SIZE; i++)
+        cmds[i] = 0;
+}
+
+bool CmdQueue::push(int cmd){
+    uint64_t head = m_head.load(std::memory_order_relaxed);
+    if(head - m_tail.load(std::memory_order_acquire) >= CMD_QUEUE_SIZE)
+        return false;
+    cmds[head % CMD_QUEUE_SIZE] = cmd;
+    m_head.store(head + 1,std::memory_order_release);
+    return true;
+}
+
+bool CmdQueue::pop(int& cmd){
+    uint64_t tail = m_tail.load(std::memory_order_relaxed);
+    if(tail == m_head.load(std::memory_order_acquire))
+        return false;
+    cmd = cmds[tail % CMD_QUEUE_SIZE];
+    m_tail.store(tail + 1,std::memory_order_release);
+    return true;
+}
@@ -0,0 +1,25 @@
+#ifndef CMDQUEUE_H
+#define CMDQUEUE_H
+#include <atomic>
+#include <stdint.h>
+
+//!commands in flight, a power of two
+#define CMD_QUEUE_SIZE 64
+
+//!single producer single consumer queue of commands, e.g. key presses, so the
+//!control loop picks them up between cycles without waiting on the producer
+class CmdQueue
+{
+public:
+    CmdQueue();
+    //!producer: false if the queue is full and the command is dropped
+    bool push(int cmd);
+    //!consumer: false if there is no command
+    bool pop(int& cmd);
+private:
+    int cmds[CMD_QUEUE_SIZE];
+    std::atomic<uint64_t> m_head;
+    std::atomic<uint64_t> m_tail;
+};
+
+#endif // CMDQUEUE_H
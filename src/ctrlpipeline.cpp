@@ -0,0 +1,175 @@
+#include "ctrlpipeline.h"
+#include "tracer.h"
+
+CtrlStage::CtrlStage()
+{
+    ac = NULL;
+    t = NULL;
+    enabled = false;
+    weight = 1.0;
+    priority = 0;
+    lv.setZero();
+    ov.setZero();
+}
+
+CtrlPipeline::CtrlPipeline()
+{
+    for(int i = 0; i < CTRL_STAGE_NUM; i++)
+        order[i] = i;
+    m_rule = COMBINE_ADD;
+    llv.setZero();
+    lov.setZero();
+    pose_o_q_l.setIdentity();
+    m_init_q.setIdentity();
+    set_orien_limit(DEFAULT_ORIEN_LIMIT);
+    m_switches = 0;
+}
+
+void CtrlPipeline::set_stage(CtrlStageT s, ActController *ac, Task *t, double weight, int priority){
+    stages[s].ac = ac;
+    stages[s].t = t;
+    stages[s].weight = weight;
+    stages[s].priority = priority;
+    stages[s].enabled = true;
+    m_switches++;
+    sort_stages();
+}
+
+void CtrlPipeline::update_stage(CtrlStageT s, ActController *ac, Task *t){
+    stages[s].ac = ac;
+    stages[s].t = t;
+    m_switches++;
+}
+
+void CtrlPipeline::enable_stage(CtrlStageT s, bool b){
+    stages[s].enabled = b;
+    if(b == false){
+        stages[s].lv.setZero();
+        stages[s].ov.setZero();
+    }
+}
+
+void CtrlPipeline::set_init_TM(const Eigen::Matrix3d& tm){
+    m_init_q = Eigen::Quaterniond(tm);
+    m_init_q.normalize();
+}
+
+void CtrlPipeline::set_orien_limit(double angle){
+    m_orien_limit_w = cos(0.5*angle);
+}
+
+void CtrlPipeline::reset(){
+    pose_o_q_l.setIdentity();
+    llv.setZero();
+    lov.setZero();
+}
+
+void CtrlPipeline::sort_stages(){
+    //insertion sort, stable for equal priorities so the stage index breaks ties
+    for(int i = 0; i < CTRL_STAGE_NUM; i++)
+        order[i] = i;
+    for(int i = 1; i < CTRL_STAGE_NUM; i++){
+        int k = order[i];
+        int j = i - 1;
+        while((j >= 0) && (stages[order[j]].priority < stages[k].priority)){
+            order[j+1] = order[j];
+            j--;
+        }
+        order[j+1] = k;
+    }
+}
+
+void CtrlPipeline::combine(){
+    llv.setZero();
+    lov.setZero();
+    if(m_rule == COMBINE_ADD){
+        for(int i = 0; i < CTRL_STAGE_NUM; i++){
+            if(stages[i].enabled == false) continue;
+            llv += stages[i].weight * stages[i].lv;
+            lov += stages[i].weight * stages[i].ov;
+        }
+    }
+    if(m_rule == COMBINE_OVERRIDE){
+        for(int i = 0; i < CTRL_STAGE_NUM; i++){
+            const CtrlStage& s = stages[order[i]];
+            if(s.enabled == false) continue;
+            llv = s.weight * s.lv;
+            lov = s.weight * s.ov;
+            break;
+        }
+    }
+    if(m_rule == COMBINE_AXIS_PRIORITY){
+        bool lset[3] = {false,false,false};
+        bool oset[3] = {false,false,false};
+        for(int i = 0; i < CTRL_STAGE_NUM; i++){
+            const CtrlStage& s = stages[order[i]];
+            if(s.enabled == false) continue;
+            for(int k = 0; k < 3; k++){
+                if((lset[k] == false) && (s.lv(k) != 0.0)){
+                    llv(k) = s.weight * s.lv(k);
+                    lset[k] = true;
+                }
+                if((oset[k] == false) && (s.ov(k) != 0.0)){
+                    lov(k) = s.weight * s.ov(k);
+                    oset[k] = true;
+                }
+            }
+        }
+    }
+}
+
+void CtrlPipeline::run(Robot *robot, myrmex_msg *tacfb){
+    TRACE_SCOPE("pipeline_run");
+    Eigen::Vector3d p_target;
+    TaskDesc td;
+    double dt;
+    int primary = -1;
+    for(int i = 0; i < CTRL_STAGE_NUM; i++){
+        const CtrlStage& s = stages[order[i]];
+        if((s.enabled == true) && (s.ac != NULL) && (s.t != NULL)){
+            primary = order[i];
+            break;
+        }
+    }
+    if(primary < 0){
+        //no controller, hold the current pose
+        robot->set_cart_command(robot->get_cur_cart_p(),Eigen::Quaterniond(robot->get_cur_cart_o()));
+    }
+    else{
+        stages[primary].t->read_desc(td);
+        robot->set_log_context(td,m_switches,(primary == TAC_STAGE) ? tacfb : NULL);
+        if(td.mft != LOCAL){
+            //absolute references are not combined, the primary stage commands the robot alone
+            if((primary == TAC_STAGE) && (tacfb != NULL))
+                stages[primary].ac->update_robot_reference(robot,stages[primary].t,tacfb);
+            else
+                stages[primary].ac->update_robot_reference(robot,stages[primary].t);
+            return;
+        }
+        for(int i = 0; i < CTRL_STAGE_NUM; i++){
+            CtrlStage& s = stages[i];
+            if((s.enabled == false) || (s.ac == NULL) || (s.t == NULL))
+                continue;
+            if(i == TAC_STAGE){
+                if(tacfb == NULL){
+                    s.lv.setZero();
+                    s.ov.setZero();
+                    continue;
+                }
+                s.ac->get_desired_lv(robot,s.t,tacfb);
+            }
+            else{
+                s.ac->get_desired_lv(robot,s.t);
+            }
+            s.ac->get_lv(s.lv,s.ov);
+        }
+        combine();
+        dt = robot->gettimecycle();
+        if(dt <= 0)
+            dt = DEFAULT_CYCLE_TIME;
+        p_target = robot->get_cur_cart_p() + robot->get_cur_cart_o() * llv;
+        quat_integrate(pose_o_q_l,lov,dt);
+        quat_cone_limit(pose_o_q_l,m_orien_limit_w);
+        robot->set_cart_command(p_target,m_init_q * pose_o_q_l);
+    }
+}
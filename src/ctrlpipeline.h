@@ -0,0 +1,79 @@
+#ifndef CTRLPIPELINE_H
+#define CTRLPIPELINE_H
+
+#include "actcontroller.h"
+#include "Robot.h"
+#include "task.h"
+#include "msgcontenttype.h"
+
+enum CtrlStageT{
+    PRO_STAGE = 0,
+    TAC_STAGE = 1,
+    FORCE_STAGE = 2,
+    VIS_STAGE = 3
+};
+
+#define CTRL_STAGE_NUM 4
+
+enum CombineRuleT{
+    //!weighted sum of all enabled stages
+    COMBINE_ADD,
+    //!only the enabled stage with the highest priority is used
+    COMBINE_OVERRIDE,
+    //!per axis the highest priority stage with a non zero output is used
+    COMBINE_AXIS_PRIORITY
+};
+
+class CtrlStage{
+public:
+    CtrlStage();
+    ActController *ac;
+    Task *t;
+    bool enabled;
+    double weight;
+    int priority;
+    //!output of the last cycle, local frame
+    Eigen::Vector3d lv,ov;
+};
+
+//!per cycle chain of controller stages, combines the local velocities of the
+//!stages and integrates them to the cartesian command of one robot. All state
+//!is owned by the pipeline, so every arm can run its own pipeline.
+class CtrlPipeline
+{
+public:
+    EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+    CtrlPipeline();
+    void set_stage(CtrlStageT, ActController *, Task *, double weight = 1.0, int priority = 0);
+    //!replace controller and task of a stage, keeps weight and priority
+    void update_stage(CtrlStageT, ActController *, Task *);
+    void enable_stage(CtrlStageT, bool);
+    void set_combine_rule(CombineRuleT r){m_rule = r;}
+    void set_init_TM(const Eigen::Matrix3d& tm);
+    //!cone around the initial orientation the integrated orientation stays in (rad)
+    void set_orien_limit(double angle);
+    //!restart the orientation integration from the initial orientation
+    void reset();
+    //!evaluate the enabled stages, combine them and set the cartesian command of the robot
+    void run(Robot *, myrmex_msg *tacfb = NULL);
+    void get_lv(Eigen::Vector3d& lv, Eigen::Vector3d& ov){lv = llv; ov = lov;}
+    const CtrlStage& stage(CtrlStageT s){return stages[s];}
+    //!number of controller/task changes of the stages so far
+    unsigned long task_switches(){return m_switches;}
+private:
+    void sort_stages();
+    void combine();
+    CtrlStage stages[CTRL_STAGE_NUM];
+    //!stage indices ordered by descending priority
+    int order[CTRL_STAGE_NUM];
+    CombineRuleT m_rule;
+    Eigen::Vector3d llv,lov;
+    //!integrated orientation relative to m_init_q
+    Eigen::Quaterniond pose_o_q_l;
+    Eigen::Quaterniond m_init_q;
+    //!cos of half the orientation limit, see quat_cone_limit
+    double m_orien_limit_w;
+    unsigned long m_switches;
+};
+
+#endif // CTRLPIPELINE_H
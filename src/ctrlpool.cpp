@@ -0,0 +1,70 @@
+#include "ctrlpool.h"
+
+CtrlPool::CtrlPool(const ParamSet& p) : m_state(pack(0,-1)), m_params(p)
+{
+    for(int i = 0; i < CTRL_POOL_SIZE; i++){
+        ac[i] = new ProActController(p);
+        t[i] = new KukaSelfCtrlTask(RP_NOCONTROL);
+        m_has_params[i] = true;
+    }
+}
+
+CtrlPool::~CtrlPool()
+{
+    for(int i = 0; i < CTRL_POOL_SIZE; i++){
+        delete ac[i];
+        delete t[i];
+    }
+}
+
+int CtrlPool::acquire(){
+    //one snapshot of both: only the producer makes a slot pending, so a slot
+    //that is neither active nor pending here can not become active behind our back
+    int s = m_state.load(std::memory_order_acquire);
+    int active = active_of(s);
+    int pending = pending_of(s);
+    for(int i = 0; i < CTRL_POOL_SIZE; i++){
+        if((i == active) || (i == pending))
+            continue;
+        ac[i]->reset();
+        t[i]->reset();
+        return i;
+    }
+    return -1;
+}
+
+void CtrlPool::submit(int slot){
+    if((slot < 0) || (slot >= CTRL_POOL_SIZE))
+        return;
+    //publish the fields set directly, e.g. mft and velocity_p2p
+    t[slot]->commit();
+    int s = m_state.load(std::memory_order_relaxed);
+    while(m_state.compare_exchange_weak(s,pack(active_of(s),slot),std::memory_order_acq_rel,\
+                                        std::memory_order_relaxed) == false);
+}
+
+bool CtrlPool::swap(){
+    int s = m_state.load(std::memory_order_acquire);
+    int pending;
+    //a submit in the meantime fails the CAS, the newest pending slot is taken then
+    do{
+        pending = pending_of(s);
+        if(pending < 0)
+            return false;
+    }while(m_state.compare_exchange_weak(s,pack(pending,-1),std::memory_order_acq_rel,\
+                                         std::memory_order_acquire) == false);
+    //the producer is done with the slot, it is safe to update it here
+    if(m_has_params[pending] == false){
+        ac[pending]->set_pm(m_params);
+        m_has_params[pending] = true;
+    }
+    return true;
+}
+
+void CtrlPool::set_params(const ParamSet& p){
+    int active = active_of(m_state.load(std::memory_order_relaxed));
+    m_params = p;
+    for(int i = 0; i < CTRL_POOL_SIZE; i++)
+        m_has_params[i] = (i == active);
+    ac[active]->set_pm(p);
+}
@@ -0,0 +1,47 @@
+#ifndef CTRLPOOL_H
+#define CTRLPOOL_H
+#include <atomic>
+#include "proactcontroller.h"
+#include "kukaselfctrltask.h"
+#include "parametermanager.h"
+
+//!active, pending, one being prepared and a spare
+#define CTRL_POOL_SIZE 4
+
+//!preallocated proprioceptive controller/task pairs. One producer thread prepares
+//!a free slot and submits it, the control thread takes it over with swap() at the
+//!start of a cycle, so retargeting does not allocate or delete anything in use.
+class CtrlPool
+{
+public:
+    //!all controllers share p
+    CtrlPool(const ParamSet& p);
+    ~CtrlPool();
+    //!producer: reset and return a slot that is neither active nor pending, -1 if none is free
+    int acquire();
+    //!producer: publish the prepared slot, replaces a pending slot the control thread has not taken yet
+    void submit(int slot);
+    //!control thread: switch to the pending slot, true if the active pair changed
+    bool swap();
+    ProActController* controller(int slot){return ac[slot];}
+    KukaSelfCtrlTask* task(int slot){return t[slot];}
+    ProActController* active_controller(){return ac[active_of(m_state.load(std::memory_order_acquire))];}
+    KukaSelfCtrlTask* active_task(){return t[active_of(m_state.load(std::memory_order_acquire))];}
+    //!control thread: new parameters for the active controller, the others take
+    //!them over when swap() activates them
+    void set_params(const ParamSet& p);
+private:
+    //!active and pending slot in one word, both change with a single CAS
+    static int pack(int active, int pending){return (active << 8) | (pending + 1);}
+    static int active_of(int s){return s >> 8;}
+    //!-1 if nothing is pending
+    static int pending_of(int s){return (s & 0xff) - 1;}
+    ProActController *ac[CTRL_POOL_SIZE];
+    KukaSelfCtrlTask *t[CTRL_POOL_SIZE];
+    std::atomic<int> m_state;
+    //!control thread only: the newest parameters and which controllers have them
+    ParamSet m_params;
+    bool m_has_params[CTRL_POOL_SIZE];
+};
+
+#endif // CTRLPOOL_H
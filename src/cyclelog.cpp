@@ -0,0 +1,206 @@
+#include "cyclelog.h"
+#include <iostream>
+#include <sstream>
+#include <cstddef>
+#include <unistd.h>
+
+//!arrays of a CycleRecord in channel order
+#define CYCLE_ARRAY_NUM 11
+
+static const char *array_names[CYCLE_ARRAY_NUM] = {"q_act","q_mea","jnt_command","updates",\
+                                                   "filtered_updates","axis_stiffness","ft",\
+                                                   "cart_command","cart_reference","task","tac"};
+static const int array_sizes[CYCLE_ARRAY_NUM] = {7,7,7,7,7,7,6,6,6,CYCLE_TASK_FIELDS,CYCLE_TACTILE_FIELDS};
+
+//!element names of the arrays that are not indexed
+static const char *task_names[CYCLE_TASK_FIELDS] = {"prot","tact","mt","mft","p_x","p_y","p_z",\
+                                                    "o_x","o_y","o_z","cp_x","cp_y","cf",\
+                                                    "v_x","v_y","v_z","p0_x","p0_y","p0_z"};
+static const char *tactile_names[CYCLE_TACTILE_FIELDS] = {"valid","cogx","cogy","contactnum",\
+                                                          "contactflag","cf","lineorien"};
+static const char **array_elements[CYCLE_ARRAY_NUM] = {NULL,NULL,NULL,NULL,NULL,NULL,NULL,NULL,NULL,\
+                                                       task_names,tactile_names};
+
+static const size_t array_offsets[CYCLE_ARRAY_NUM] = {offsetof(CycleRecord,q_act),offsetof(CycleRecord,q_mea),\
+                                                     offsetof(CycleRecord,jnt_command),offsetof(CycleRecord,updates),\
+                                                     offsetof(CycleRecord,filtered_updates),offsetof(CycleRecord,axis_stiffness),\
+                                                     offsetof(CycleRecord,ft),offsetof(CycleRecord,cart_command),\
+                                                     offsetof(CycleRecord,cart_reference),offsetof(CycleRecord,task),\
+                                                     offsetof(CycleRecord,tactile)};
+
+void cycle_record_channels(std::vector<std::string>& names){
+    names.clear();
+    names.push_back("cycle");
+    names.push_back("mode");
+    names.push_back("task_switches");
+    for(int a = 0; a < CYCLE_ARRAY_NUM; a++){
+        for(int i = 0; i < array_sizes[a]; i++){
+            std::ostringstream n;
+            if(array_elements[a] != NULL)
+                n<<array_names[a]<<"_"<<array_elements[a][i];
+            else
+                n<<array_names[a]<<i;
+            names.push_back(n.str());
+        }
+    }
+}
+
+void cycle_record_values(const CycleRecord& r, double *values){
+    int k = 0;
+    values[k++] = r.cycle;
+    values[k++] = r.mode;
+    values[k++] = r.task_switches;
+    for(int a = 0; a < CYCLE_ARRAY_NUM; a++){
+        const double *src = (const double*)((const char*)&r + array_offsets[a]);
+        for(int i = 0; i < array_sizes[a]; i++)
+            values[k++] = src[i];
+    }
+}
+
+void cycle_record_from_values(const double *values, CycleRecord& r){
+    int k = 0;
+    r.cycle = values[k++];
+    r.mode = values[k++];
+    r.task_switches = values[k++];
+    for(int a = 0; a < CYCLE_ARRAY_NUM; a++){
+        double *dst = (double*)((char*)&r + array_offsets[a]);
+        for(int i = 0; i < array_sizes[a]; i++)
+            dst[i] = values[k++];
+    }
+}
+
+void cycle_record_set_task(CycleRecord& r, const TaskDesc& td, const myrmex_msg *tacfb){
+    double *t = r.task;
+    t[0] = td.curtaskname.prot;
+    t[1] = td.curtaskname.tact;
+    t[2] = td.mt;
+    t[3] = td.mft;
+    for(int i = 0; i < 3; i++){
+        t[4+i] = td.desired_p_eigen(i);
+        t[7+i] = td.desired_o_ax(i);
+        t[13+i] = td.velocity_p2p(i);
+        t[16+i] = td.initial_p_eigen(i);
+    }
+    t[10] = td.desired_cp_myrmex[0];
+    t[11] = td.desired_cp_myrmex[1];
+    t[12] = td.desired_cf_myrmex;
+    double *c = r.tactile;
+    c[0] = (tacfb != NULL) ? 1.0 : 0.0;
+    if(tacfb == NULL){
+        for(int i = 1; i < CYCLE_TACTILE_FIELDS; i++)
+            c[i] = 0.0;
+        return;
+    }
+    c[1] = tacfb->cogx;
+    c[2] = tacfb->cogy;
+    c[3] = tacfb->contactnum;
+    c[4] = tacfb->contactflag;
+    c[5] = tacfb->cf;
+    c[6] = tacfb->lineorien;
+}
+
+bool cycle_record_get_task(const CycleRecord& r, TaskDesc& td, myrmex_msg& tacfb){
+    const double *t = r.task;
+    td.curtaskname.prot = (PROTaskNameT)(int)t[0];
+    td.curtaskname.tact = (TACTaskNameT)(int)t[1];
+    td.mt = (ModalityT)(int)t[2];
+    td.mft = (MoveFrameT)(int)t[3];
+    for(int i = 0; i < 3; i++){
+        td.desired_p_eigen(i) = t[4+i];
+        td.desired_o_ax(i) = t[7+i];
+        td.velocity_p2p(i) = t[13+i];
+        td.initial_p_eigen(i) = t[16+i];
+    }
+    td.desired_cp_myrmex[0] = t[10];
+    td.desired_cp_myrmex[1] = t[11];
+    td.desired_cf_myrmex = t[12];
+    const double *c = r.tactile;
+    tacfb.cogx = c[1];
+    tacfb.cogy = c[2];
+    tacfb.contactnum = c[3];
+    tacfb.contactflag = c[4];
+    tacfb.cf = c[5];
+    tacfb.lineorien = c[6];
+    return c[0] != 0.0;
+}
+
+CycleLog::CycleLog() : m_head(0), m_tail(0), m_written(0), m_dropped(0), m_running(false)
+{
+    //zeroed so the pages are touched before the control loop runs
+    ring = new CycleRecord[CYCLE_LOG_SIZE]();
+}
+
+CycleLog::~CycleLog(){
+    close();
+    delete [] ring;
+}
+
+bool CycleLog::open(const std::string& path){
+    std::vector<std::string> names;
+    close();
+    cycle_record_channels(names);
+    if(m_session.open(path,names) == false)
+        return false;
+    m_path = path;
+    m_head.store(0);
+    m_tail.store(0);
+    m_written.store(0);
+    m_dropped.store(0);
+    m_running.store(true);
+    m_writer = std::thread(&CycleLog::writer,this);
+    return true;
+}
+
+void CycleLog::close(){
+    if(m_session.is_open() == false)
+        return;
+    m_running.store(false);
+    if(m_writer.joinable())
+        m_writer.join();
+    drain();
+    m_session.close();
+    std::cout<<"cycle log: "<<written()<<" records written to "<<m_path<<", "<<dropped()<<" dropped"<<std::endl;
+}
+
+CycleRecord* CycleLog::reserve(){
+    if(m_running.load(std::memory_order_relaxed) == false)
+        return NULL;
+    uint64_t head = m_head.load(std::memory_order_relaxed);
+    if(head - m_tail.load(std::memory_order_acquire) >= CYCLE_LOG_SIZE){
+        m_dropped.fetch_add(1,std::memory_order_relaxed);
+        return NULL;
+    }
+    return &ring[head % CYCLE_LOG_SIZE];
+}
+
+void CycleLog::commit(){
+    m_head.store(m_head.load(std::memory_order_relaxed) + 1,std::memory_order_release);
+}
+
+bool CycleLog::drain(){
+    double values[CYCLE_LOG_CHANNELS];
+    uint64_t tail = m_tail.load(std::memory_order_relaxed);
+    uint64_t head = m_head.load(std::memory_order_acquire);
+    while(tail != head){
+        const CycleRecord& r = ring[tail % CYCLE_LOG_SIZE];
+        cycle_record_values(r,values);
+        if(m_session.append(r.timestamp,values) == false){
+            std::cout<<"cycle log: write error on "<<m_path<<std::endl;
+            return false;
+        }
+        tail++;
+        m_tail.store(tail,std::memory_order_release);
+        m_written.fetch_add(1,std::memory_order_relaxed);
+    }
+    return true;
+}
+
+void CycleLog::writer(){
+    while(m_running.load()){
+        if(drain() == false){
+            m_running.store(false);
+            break;
+        }
+        usleep(1000*CYCLE_LOG_FLUSH_MS);
+    }
+}
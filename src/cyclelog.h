@@ -0,0 +1,96 @@
+#ifndef CYCLELOG_H
+#define CYCLELOG_H
+#include <atomic>
+#include <thread>
+#include <string>
+#include <stdint.h>
+#include <vector>
+#include "sessionlog.h"
+#include "task.h"
+#include "msgcontenttype.h"
+
+//!records in the ring, a power of two. 4096 cycles are 16s at 250Hz
+#define CYCLE_LOG_SIZE 4096
+//!the writer drains the ring this often (ms)
+#define CYCLE_LOG_FLUSH_MS 100
+//!channels of a CycleRecord in the session log, the timestamp is the time column
+#define CYCLE_LOG_CHANNELS 89
+//!TaskDesc and tactile feedback fields of a CycleRecord
+#define CYCLE_TASK_FIELDS 19
+#define CYCLE_TACTILE_FIELDS 7
+
+//!one control cycle, written to disk as is
+struct CycleRecord{
+    //!CLOCK_MONOTONIC in seconds
+    double timestamp;
+    uint64_t cycle;
+    //!RobotModeT of the cycle
+    double mode;
+    //!CtrlPipeline::task_switches(), changes whenever the active task changes
+    double task_switches;
+    double q_act[7];
+    double q_mea[7];
+    double jnt_command[7];
+    //!joint increment of the CBF step and after the joint smoothing
+    double updates[7];
+    double filtered_updates[7];
+    double axis_stiffness[7];
+    //!force and torque at the tcp
+    double ft[6];
+    //!cartesian command of the controllers and the limited CBF reference (position, axis angle)
+    double cart_command[6];
+    double cart_reference[6];
+    //!task the controllers worked on and the tactile feedback they got, see cycle_record_set_task
+    double task[CYCLE_TASK_FIELDS];
+    double tactile[CYCLE_TACTILE_FIELDS];
+};
+
+//!session log channel names of a CycleRecord, e.g. cycle, q_act0..q_act6, ft0..ft5
+void cycle_record_channels(std::vector<std::string>& names);
+//!the CYCLE_LOG_CHANNELS values of r in the order of cycle_record_channels
+void cycle_record_values(const CycleRecord& r, double *values);
+//!inverse of cycle_record_values, the timestamp is not part of the values
+void cycle_record_from_values(const double *values, CycleRecord& r);
+//!store td and tacfb (NULL if there was none) in r
+void cycle_record_set_task(CycleRecord& r, const TaskDesc& td, const myrmex_msg *tacfb);
+//!task and tactile feedback of r, false if the cycle had no tactile feedback
+bool cycle_record_get_task(const CycleRecord& r, TaskDesc& td, myrmex_msg& tacfb);
+
+//!single producer single consumer log of cycle records. The control thread
+//!fills preallocated records, a background thread appends them to a columnar
+//!session log. A full ring drops the record and counts it.
+class CycleLog
+{
+public:
+    CycleLog();
+    ~CycleLog();
+    //!create the session log and start the writer, false if the file can not be created
+    bool open(const std::string& path);
+    //!write the remaining records, stop the writer and report the dropped records.
+    //!Records reserved after the writer stopped are lost.
+    void close();
+    bool is_open(){return m_session.is_open();}
+    //!control thread: record to fill, NULL if the ring is full or the log is closed
+    CycleRecord* reserve();
+    //!control thread: publish the record returned by reserve
+    void commit();
+    uint64_t written(){return m_written.load(std::memory_order_relaxed);}
+    uint64_t dropped(){return m_dropped.load(std::memory_order_relaxed);}
+    //!records committed but not written yet, a producer faster than real time waits on it
+    uint64_t pending(){return m_head.load(std::memory_order_relaxed) - m_tail.load(std::memory_order_acquire);}
+private:
+    void writer();
+    //!append all published records, false on a write error
+    bool drain();
+    CycleRecord *ring;
+    std::atomic<uint64_t> m_head;
+    std::atomic<uint64_t> m_tail;
+    std::atomic<uint64_t> m_written;
+    std::atomic<uint64_t> m_dropped;
+    std::atomic<bool> m_running;
+    std::thread m_writer;
+    SessionLogWriter m_session;
+    std::string m_path;
+};
+
+#endif // CYCLELOG_H
@@ -1,13 +1,13 @@
 #include "jntlimitfilter.h"
 #include <limits>
-#include <math.h>
+#include <algorithm>
 
 #define OVERALL_DAMP 0.9
 #define JERK_DAMP OVERALL_DAMP*0.0015
 #define ACCEL_DAMP OVERALL_DAMP*0.9
 #define VELOCITY_DAMP OVERALL_DAMP
 
-JntLimitFilter::JntLimitFilter(double t)
+JntLimits::JntLimits()
 {
     jerk_limits[0] = JERK_DAMP*20.944;
     jerk_limits[1] = JERK_DAMP*20.944;
@@ -32,52 +32,65 @@ JntLimitFilter::JntLimitFilter(double t)
     velocity_limits[4] = VELOCITY_DAMP* 4.3633;
     velocity_limits[5] = VELOCITY_DAMP* 3.8397;
     velocity_limits[6] = VELOCITY_DAMP*3.8397;
+    speedlimit = 0.5;
+}
 
+JntLimitFilter::JntLimitFilter(double t, const JntLimits& l)
+{
     cycle_time = t;
-    speedlimit = 0.5;
-    for (int i=0; i < 7; i++){
-        lastJerk[i] = 0;
-        lastAccel[i] = 0;
-        lastCorr[i] = 0;
+    set_limits(l);
+    lastJerk.setZero();
+    lastAccel.setZero();
+    lastCorr.setZero();
+}
+
+void JntLimitFilter::set_limits(const JntLimits& l){
+    limits = l;
+    update_bounds();
+}
+
+void JntLimitFilter::set_speedlimit(double s){
+    limits.speedlimit = s;
+    update_bounds();
+}
+
+void JntLimitFilter::update_bounds(){
+    double scale = limits.speedlimit*cycle_time;
+    for(int i = 0; i < 7; i++){
+        jerk_bound(i) = scale*limits.jerk_limits[i];
+        accel_bound(i) = scale*limits.accel_limits[i];
+        velocity_bound(i) = scale*limits.velocity_limits[i];
     }
+    jerk_bound(7) = 1.0;
+    accel_bound(7) = 1.0;
+    velocity_bound(7) = 1.0;
+    //a zero limit stops the joint instead of producing 0/0
+    jerk_bound = jerk_bound.max(std::numeric_limits<double>::min());
+    accel_bound = accel_bound.max(std::numeric_limits<double>::min());
+    velocity_bound = velocity_bound.max(std::numeric_limits<double>::min());
 }
 
 void JntLimitFilter::get_filtered_value(double *v_in, double* v_out){
-    double factor = 1.0;
-    double temp;
-    double min_factor = 1.0;
-    for (int i = 0; i < 7; i++){
-        if (fabs(factor*v_in[i]-lastCorr[i]) > std::numeric_limits<double>::epsilon()){
-            if ( (temp = (speedlimit*accel_limits[i]*cycle_time / fabs(factor*v_in[i]-lastCorr[i])))  < factor){
-                factor = temp;
-            }
-        }
-        if (fabs (factor*v_in[i]) > std::numeric_limits<double>::epsilon()){
-            if ((temp = (speedlimit*velocity_limits[i]*cycle_time / fabs (factor*v_in[i])))  < factor){
-                factor = temp;
-            }
-        }
-    }
-    for (int i=0; i < 7; i++){
-        v_out[i] = v_in[i]*factor;
-    }
-    {
-        double f;
-        double f_min=1.0;
-        int j;
-        for (j=0; j < 7; j++){
-            f = (speedlimit*jerk_limits[j]*cycle_time) / fabsf ( v_out[j] - lastCorr[j] - lastAccel[j]);
-            if (f < f_min)
-                f_min = f;
-        }
-        min_factor = f_min;
-    }
-    for (int i=0; i < 7; i++){
-        v_out[i] = min_factor*v_out[i] + ((1.0-min_factor)*lastCorr[i]);
-    }
-    for (int i = 0; i < 7; i++){
-        lastJerk[i] = lastAccel[i] - (lastCorr[i] - v_out[i]);
-        lastAccel[i] = lastCorr[i] - v_out[i];
-        lastCorr[i] = v_out[i];
-    }
+    typedef Eigen::Map<Eigen::Array<double,7,1> > JntMap;
+    JntLane v,out,d;
+    v.head<7>() = JntMap(v_in);
+    v(7) = 0.0;
+    //largest factor with |factor*v-lastCorr| <= accel_bound and |factor*v| <= velocity_bound,
+    //a joint that does not move gives +inf and drops out of the min
+    d = v.abs();
+    double factor = ((v.sign()*lastCorr + accel_bound)/d).min(velocity_bound/d).minCoeff();
+    factor = std::max(0.0,std::min(1.0,factor));
+    out = factor*v;
+    //blend towards the zero jerk continuation lastCorr + lastAccel until the change
+    //of the acceleration is within the limit
+    d = (out - lastCorr - lastAccel).abs();
+    double min_factor = std::min(1.0,(jerk_bound/d).minCoeff());
+    out = min_factor*out + (1.0-min_factor)*(lastCorr + lastAccel);
+    //the continuation can run past the velocity bound, the velocity takes precedence
+    out *= std::min(1.0,(velocity_bound/out.abs()).minCoeff());
+    lastJerk = out - lastCorr - lastAccel;
+    lastAccel = out - lastCorr;
+    lastCorr = out;
+    JntMap out_map(v_out);
+    out_map = out.head<7>();
 }
@@ -1,24 +1,51 @@
 #ifndef JNTLIMITFILTER_H
 #define JNTLIMITFILTER_H
+#include <Eigen/Dense>
 
+//!the 7 joints are padded to 8 lanes so the per joint math maps onto full vector registers
+#define JNT_LANES 8
 
+typedef Eigen::Array<double,JNT_LANES,1> JntLane;
 
+//!joint limits in the units of the filter: the per cycle increment may change by
+//!at most speed*limit*cycle_time per cycle (velocity, accel and jerk of the increment)
+struct JntLimits{
+    //!the damped limits of the LWR
+    JntLimits();
+    double jerk_limits[7];
+    double accel_limits[7];
+    double velocity_limits[7];
+    double speedlimit;
+};
+
+//!limits the velocity, acceleration and jerk of the per cycle joint increment.
+//!The velocity and acceleration limits scale all joints by one factor and keep
+//!the direction of the increment. The jerk limit then blends the increment
+//!towards the zero jerk continuation (last increment plus last change), so the
+//!output can point away from the input while the jerk limit is active. Where that
+//!carries the increment past the velocity bound, the velocity bound wins.
 class JntLimitFilter
 {
 public:
-    JntLimitFilter(double t);
+    EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+    JntLimitFilter(double t, const JntLimits& l = JntLimits());
+    //!change the limits, takes effect with the next cycle
+    void set_limits(const JntLimits& l);
+    void set_speedlimit(double s);
+    const JntLimits& get_limits(){return limits;}
     void get_filtered_value(double *v_in, double *v_out);
 private:
-    double jerk_limits[7];
-    double accel_limits[7];
-    double velocity_limits[7];
-    double vel_out[7];
-    double lastCorr[7];
-    double lastAccel[7];
-    double lastJerk[7];
+    //!the per cycle bounds speed*limit*cycle_time, the pad lane is 1
+    void update_bounds();
+    JntLimits limits;
     double cycle_time;
-    double speedlimit;
-
+    JntLane jerk_bound;
+    JntLane accel_bound;
+    JntLane velocity_bound;
+    //!last increment, its change and the change of that
+    JntLane lastCorr;
+    JntLane lastAccel;
+    JntLane lastJerk;
 };
 
 #endif // JNTLIMITFILTER_H
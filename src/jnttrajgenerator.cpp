@@ -0,0 +1,186 @@
+#include "jnttrajgenerator.h"
+#include <math.h>
+#include <algorithm>
+
+//!joints closer than this and nearly at rest are put on the target
+#define JTG_SETTLE_EPS 1e-9
+//!iterations of the jerk search, resolves the jerk to 2*J/2^n
+#define JTG_BISECTIONS 12
+//!lower bound of the synchronisation scaling, keeps short moves from stalling
+#define JTG_MIN_SCALE 0.05
+
+JntTrajGenerator::JntTrajGenerator(double t, const JntLimits& l)
+{
+    cycle_time = t;
+    set_limits(l);
+    for(int i = 0; i < 7; i++){
+        pos[i] = 0.0;
+        vel[i] = 0.0;
+        acc[i] = 0.0;
+    }
+    sync_time = 0.0;
+    has_target = false;
+    initialised = false;
+}
+
+void JntTrajGenerator::set_limits(const JntLimits& l){
+    //the filter bounds the change of the increment per cycle by speed*limit*dt
+    for(int i = 0; i < 7; i++){
+        vel_max[i] = l.speedlimit * l.velocity_limits[i];
+        acc_max[i] = l.speedlimit * l.accel_limits[i] / cycle_time;
+        jerk_max[i] = l.speedlimit * l.jerk_limits[i] / (cycle_time * cycle_time);
+    }
+}
+
+void JntTrajGenerator::reset(const double *q){
+    for(int i = 0; i < 7; i++){
+        pos[i] = q[i];
+        vel[i] = 0.0;
+        acc[i] = 0.0;
+    }
+    has_target = false;
+    initialised = true;
+}
+
+double JntTrajGenerator::rest_to_rest_time(double d, int i){
+    double V = vel_max[i];
+    double A = acc_max[i];
+    double J = jerk_max[i];
+    double vp,d_v,t_v;
+    if(d <= 0)
+        return 0.0;
+    //distance and time to accelerate to V and back to rest
+    if(V >= A*A/J){
+        d_v = V*V/A + V*A/J;
+        t_v = V/A + A/J;
+    }
+    else{
+        d_v = 2*V*sqrt(V/J);
+        t_v = 2*sqrt(V/J);
+    }
+    if(d >= d_v)
+        return d/V + t_v;
+    //peak velocity below V, first with the acceleration reaching A
+    vp = 0.5 * (-A*A/J + sqrt(A*A*A*A/(J*J) + 4*A*d));
+    if(vp >= A*A/J)
+        return 2 * (vp/A + A/J);
+    vp = cbrt(d*d*J/4);
+    return 4 * sqrt(vp/J);
+}
+
+double JntTrajGenerator::stop_distance(double v, double a, int i){
+    double A = acc_max[i];
+    double J = jerk_max[i];
+    //velocity left after ramping the acceleration to zero, braking is the other way round
+    if(v + a*fabs(a)/(2*J) < 0)
+        return -stop_distance(-v,-a,i);
+    //jerk -J down to -ap, optionally hold -A, then jerk +J until rest
+    double ap = std::min(A,sqrt(J*v + a*a/2));
+    double t1 = (a + ap)/J;
+    double x = v*t1 + a*t1*t1/2 - J*t1*t1*t1/6;
+    double v1 = v + a*t1 - J*t1*t1/2;
+    double v2 = ap*ap/(2*J);
+    if(v1 > v2){
+        double t2 = (v1 - v2)/ap;
+        x += v1*t2 - ap*t2*t2/2;
+    }
+    double t3 = ap/J;
+    x += v2*t3 - ap*t3*t3/2 + J*t3*t3*t3/6;
+    return x;
+}
+
+bool JntTrajGenerator::admissible(double d, double v, double a, double j, double v_lim, int i){
+    double dt = cycle_time;
+    double a1 = a + j*dt;
+    double v1 = v + a*dt + j*dt*dt/2;
+    double x1 = v*dt + a*dt*dt/2 + j*dt*dt*dt/6;
+    //the velocity must stay below v_lim once the acceleration is ramped down
+    if(v1 + a1*fabs(a1)/(2*jerk_max[i]) > v_lim)
+        return false;
+    //and the joint must still be able to stop at the target
+    return stop_distance(v1,a1,i) <= d - x1;
+}
+
+bool JntTrajGenerator::deadbeat(double d, double v, double a, int i, double& j){
+    double dt = cycle_time;
+    double e = -d;
+    double jk;
+    //jerk feedback with all poles at zero, the joint is at rest on the target after three cycles
+    for(int k = 0; k < 3; k++){
+        jk = -e/(dt*dt*dt) - 2*v/(dt*dt) - 11*a/(6*dt);
+        if((fabs(jk) > jerk_max[i]) || (fabs(a + jk*dt) > acc_max[i]))
+            return false;
+        if(k == 0)
+            j = jk;
+        e += v*dt + a*dt*dt/2 + jk*dt*dt*dt/6;
+        v += a*dt + jk*dt*dt/2;
+        a += jk*dt;
+    }
+    return true;
+}
+
+void JntTrajGenerator::step(const double *q_target, double *q_out){
+    double d[7],t[7],vt[7];
+    double dt = cycle_time;
+    sync_time = 0.0;
+    for(int i = 0; i < 7; i++){
+        //q_target is where the joint should be at the end of the cycle. It is assumed
+        //to move on with its last velocity, the joints plan relative to it.
+        vt[i] = has_target ? (q_target[i] - last_target[i])/dt : 0.0;
+        vt[i] = std::max(-vel_max[i],std::min(vel_max[i],vt[i]));
+        last_target[i] = q_target[i];
+        d[i] = q_target[i] - vt[i]*dt - pos[i];
+        t[i] = rest_to_rest_time(fabs(d[i]),i);
+        sync_time = std::max(sync_time,t[i]);
+    }
+    has_target = true;
+    for(int i = 0; i < 7; i++){
+        //time scaling f = T_i/T, the slowest joint keeps its full velocity
+        double f = (sync_time > 0) ? std::max(t[i]/sync_time,JTG_MIN_SCALE) : 1.0;
+        //mirror the joint so that the target lies ahead
+        double sgn = (d[i] < 0) ? -1.0 : 1.0;
+        double dd = sgn*d[i];
+        double v = sgn*(vel[i] - vt[i]);
+        double a = sgn*acc[i];
+        double v_lim = std::min(f*vel_max[i],vel_max[i] - sgn*vt[i]);
+        double j_lo = std::max(-jerk_max[i],(-acc_max[i] - a)/dt);
+        double j_hi = std::min(jerk_max[i],(acc_max[i] - a)/dt);
+        double j;
+        if(deadbeat(dd,v,a,i,j) == false){
+            //otherwise the largest admissible jerk, the constraints are monotonic in the jerk
+            if(admissible(dd,v,a,j_hi,v_lim,i)){
+                j = j_hi;
+            }
+            else{
+                double lo = j_lo, hi = j_hi;
+                for(int k = 0; k < JTG_BISECTIONS; k++){
+                    double mid = 0.5*(lo + hi);
+                    if(admissible(dd,v,a,mid,v_lim,i))
+                        lo = mid;
+                    else
+                        hi = mid;
+                }
+                j = lo;
+            }
+        }
+        //the search works on the continuous braking curve, the velocity limit is
+        //enforced exactly on what is commanded: the mean velocity of the cycle
+        //(the position increment) and the velocity at its end
+        double v_hard = vel_max[i] - sgn*vt[i];
+        double v_soft = -vel_max[i] - sgn*vt[i];
+        j = std::min(j,std::min(2*(v_hard - v - a*dt)/(dt*dt),6*(v_hard - v - a*dt/2)/(dt*dt)));
+        j = std::max(j,std::max(2*(v_soft - v - a*dt)/(dt*dt),6*(v_soft - v - a*dt/2)/(dt*dt)));
+        //exact integration of constant jerk over one cycle
+        pos[i] += sgn*(v*dt + a*dt*dt/2 + j*dt*dt*dt/6) + vt[i]*dt;
+        vel[i] = sgn*(v + a*dt + j*dt*dt/2) + vt[i];
+        acc[i] = sgn*(a + j*dt);
+        //remove the rounding left by the three cycle approach
+        if((fabs(q_target[i] - pos[i]) < JTG_SETTLE_EPS) && \
+                (fabs(vel[i] - vt[i]) < JTG_SETTLE_EPS) && (fabs(acc[i]) < JTG_SETTLE_EPS)){
+            pos[i] = q_target[i];
+            vel[i] = vt[i];
+            acc[i] = 0.0;
+        }
+        q_out[i] = pos[i];
+    }
+}
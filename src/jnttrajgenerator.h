@@ -0,0 +1,46 @@
+#ifndef JNTTRAJGENERATOR_H
+#define JNTTRAJGENERATOR_H
+#include "jntlimitfilter.h"
+
+//!online jerk limited joint trajectory generator. Every cycle each joint takes the
+//!largest jerk that still lets it stop at its target (braking curve), the velocity
+//!limits are scaled by T_i/T so that all joints arrive together with the slowest one.
+//!A moving target is followed with its velocity estimated from the last step.
+class JntTrajGenerator
+{
+public:
+    JntTrajGenerator(double t, const JntLimits& l = JntLimits());
+    //!convert the per cycle filter limits to rad/s, rad/s^2 and rad/s^3
+    void set_limits(const JntLimits& l);
+    //!start at rest at the position q
+    void reset(const double *q);
+    bool is_initialised(){return initialised;}
+    //!the next step has to be preceded by a reset
+    void invalidate(){initialised = false;}
+    //!one cycle towards q_target, q_out is the next position command
+    void step(const double *q_target, double *q_out);
+    //!time the slowest joint needs to reach the target of the last step from rest
+    double get_sync_time(){return sync_time;}
+private:
+    double rest_to_rest_time(double d, int i);
+    //!displacement until rest when braking from v,a with the jerk and accel limits
+    double stop_distance(double v, double a, int i);
+    //!true if the jerk j for one cycle keeps the joint within v_lim and able to stop within d
+    bool admissible(double d, double v, double a, double j, double v_lim, int i);
+    //!jerk of the three cycle approach to the target, false if it breaks a limit
+    bool deadbeat(double d, double v, double a, int i, double& j);
+    double cycle_time;
+    double vel_max[7];
+    double acc_max[7];
+    double jerk_max[7];
+    double pos[7];
+    double vel[7];
+    double acc[7];
+    //!target of the last step, its change estimates the target velocity
+    double last_target[7];
+    bool has_target;
+    double sync_time;
+    bool initialised;
+};
+
+#endif // JNTTRAJGENERATOR_H
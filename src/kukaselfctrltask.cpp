@@ -2,18 +2,22 @@
 
 void KukaSelfCtrlTask::switchtotask(PROTaskNameT tn){
     curtaskname.prot = tn;
+    commit();
 }
 
 void KukaSelfCtrlTask::switchtoglobalframe(){
     mft = GLOBAL;
+    commit();
 }
 void KukaSelfCtrlTask::switchtolocalframe(){
     mft = LOCAL;
+    commit();
 }
 
 KukaSelfCtrlTask::KukaSelfCtrlTask(PROTaskNameT tn)
 {
     curtaskname.prot = tn;
+    commit();
 }
 
 
@@ -1,116 +1,312 @@
 #include "parametermanager.h"
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
-ParameterManager::ParameterManager(){
+#define FNV_OFFSET 0xcbf29ce484222325ULL
+#define FNV_PRIME 0x100000001b3ULL
+//!members of the parameter cache
+#define PARAM_CACHE_BLOCKS 6
 
+//!FNV-1a over 64 bit words, the bytes of a short tail one by one
+static uint64_t fnv1a(uint64_t h, const char *d, size_t n){
+    size_t i = 0;
+    for(; i + 8 <= n; i += 8){
+        uint64_t w;
+        memcpy(&w,d + i,8);
+        h ^= w;
+        h *= FNV_PRIME;
+    }
+    for(; i < n; i++){
+        h ^= (unsigned char)d[i];
+        h *= FNV_PRIME;
+    }
+    return h;
+}
+
+static bool read_file(const std::string& path, std::string& content){
+    struct stat st;
+    int fd = open(path.c_str(),O_RDONLY);
+    if(fd < 0)
+        return false;
+    bool ok = (fstat(fd,&st) == 0);
+    if(ok){
+        content.resize(st.st_size);
+        ok = (read(fd,&content[0],st.st_size) == st.st_size);
+    }
+    close(fd);
+    return ok;
+}
+
+//!element names in the xml file
+static const char *name_dim[6] = {"x","y","z","roll","pitch","yaw"};
+static const char *name_dim2[3] = {"roll2","pitch2","yaw2"};
+static const char *name_dim3[6] = {".e00",".e11",".e22",".e33",".e44",".e55"};
+static const char *name_axis[7] = {"a1","a2","e1","a3","a4","a5","a6"};
+
+//!section of a task in the xml file, NULL for tasks without parameters
+static const char *tac_task_name(int t){
+    switch(t){
+    case CONTACT_POINT_TRACKING: return "ContactPointTracking";
+    case CONTACT_FORCE_TRACKING: return "ContactForceTracking";
+    case CONTACT_POINT_FORCE_TRACKING: return "ContactPointForceTracking";
+    case SENSING_POLE_TRACKING: return "SensingPoleTracking";
+    case Z_ORIEN_TRACKING: return "ZOrienTracking";
+    case LINEAR_TRACKING: return "LineTracking";
+    case COVER_OBJECT_SURFACE: return "CoverObjectSurface";
+    case OBJECT_SURFACE_EXPLORING: return "ObjectSurfaceExploring";
+    default: return NULL;
+    }
+}
+
+static const char *pro_task_name(int t){
+    switch(t){
+    case RLXP: return "Rlxp";
+    case RLYP: return "Rlyp";
+    case RLZP: return "Rlzp";
+    case RRXP: return "Rrxp";
+    case RRYP: return "Rryp";
+    case RRZP: return "Rrzp";
+    case RLXN: return "Rlxn";
+    case RLYN: return "Rlyn";
+    case RLZN: return "Rlzn";
+    case RRXN: return "Rrxn";
+    case RRYN: return "Rryn";
+    case RRZN: return "Rrzn";
+    case RP_NOCONTROL: return "Rno";
+    case RP_LINEFOLLOW: return "Rlf";
+    case RP_ROTATEFOLLOW: return "Rrf";
+    default: return NULL;
+    }
 }
 
-ParameterManager::ParameterManager(const std::string s = "left_arm_param.xml")
+//!address and size of the cached members in cache order
+static void cache_blocks(ParameterManager& pm, char **ptr, size_t *size){
+    ptr[0] = (char*)pm.tac_task_ctrl_param;
+    size[0] = sizeof(pm.tac_task_ctrl_param);
+    ptr[1] = (char*)pm.pro_task_ctrl_param;
+    size[1] = sizeof(pm.pro_task_ctrl_param);
+    ptr[2] = (char*)&pm.stiff_ctrlpara;
+    size[2] = sizeof(pm.stiff_ctrlpara);
+    ptr[3] = (char*)&pm.jnt_limits;
+    size[3] = sizeof(pm.jnt_limits);
+    ptr[4] = (char*)&pm.cart_limits;
+    size[4] = sizeof(pm.cart_limits);
+    ptr[5] = (char*)&pm.jnt_smoothing;
+    size[5] = sizeof(pm.jnt_smoothing);
+}
+
+ParameterManager::ParameterManager(){
+    cache_hit = false;
+    jnt_smoothing = JNT_LIMIT_FILTER;
+    resolve_views();
+}
+
+ParameterManager::ParameterManager(const std::string s = "left_arm_param.xml", bool use_cache)
 {
-    map_name_dim[0] = "x";
-    map_name_dim[1] = "y";
-    map_name_dim[2] = "z";
-    map_name_dim[3] = "roll";
-    map_name_dim[4] = "pitch";
-    map_name_dim[5] = "yaw";
-
-    map_name_dim2[0] = "roll2";
-    map_name_dim2[1] = "pitch2";
-    map_name_dim2[2] = "yaw2";
-
-    map_name_dim3[0] = ".e00";
-    map_name_dim3[1] = ".e11";
-    map_name_dim3[2] = ".e22";
-    map_name_dim3[3] = ".e33";
-    map_name_dim3[4] = ".e44";
-    map_name_dim3[5] = ".e55";
-
-    tac_map_task_name[CONTACT_POINT_TRACKING] = "ContactPointTracking";
-    tac_map_task_name[CONTACT_FORCE_TRACKING] = "ContactForceTracking";
-    tac_map_task_name[CONTACT_POINT_FORCE_TRACKING] = "ContactPointForceTracking";
-    tac_map_task_name[SENSING_POLE_TRACKING] = "SensingPoleTracking";
-    tac_map_task_name[Z_ORIEN_TRACKING] = "ZOrienTracking";
-    tac_map_task_name[LINEAR_TRACKING] = "LineTracking";
-    tac_map_task_name[COVER_OBJECT_SURFACE] = "CoverObjectSurface";
-    tac_map_task_name[OBJECT_SURFACE_EXPLORING] = "ObjectSurfaceExploring";
-
-    pro_map_task_name[RLXP] = "Rlxp";
-    pro_map_task_name[RLYP] = "Rlyp";
-    pro_map_task_name[RLZP] = "Rlzp";
-    pro_map_task_name[RRXP] = "Rrxp";
-    pro_map_task_name[RRYP] = "Rryp";
-    pro_map_task_name[RRZP] = "Rrzp";
-    pro_map_task_name[RLXN] = "Rlxn";
-    pro_map_task_name[RLYN] = "Rlyn";
-    pro_map_task_name[RLZN] = "Rlzn";
-    pro_map_task_name[RRXN] = "Rrxn";
-    pro_map_task_name[RRYN] = "Rryn";
-    pro_map_task_name[RRZN] = "Rrzn";
-    pro_map_task_name[RP_NOCONTROL] = "Rno";
-    pro_map_task_name[RP_LINEFOLLOW] = "Rlf";
-    pro_map_task_name[RP_ROTATEFOLLOW] = "Rrf";
-    loadCtrlParam(s);
-}
-
-void ParameterManager::load(TACTaskNameT tnt,ptree pt){
-    tac_task_ctrl_param[tnt].kpp.setZero(6,6);
-    tac_task_ctrl_param[tnt].kpi.setZero(6,6);
-    tac_task_ctrl_param[tnt].kpd.setZero(6,6);
-    tac_task_ctrl_param[tnt].kop.setZero(3,3);
-    tac_task_ctrl_param[tnt].tsm.setZero(6,6);
-    tac_task_ctrl_param[tnt].ttjkm.setZero(6,6);
-    tac_task_ctrl_param[tnt].vsm.setZero(6,6);
-    tac_task_ctrl_param[tnt].vtjkm.setZero(6,6);
+    cache_hit = false;
+    jnt_smoothing = JNT_LIMIT_FILTER;
+    std::string xml;
+    if(read_file(s,xml) == false)
+        throw boost::property_tree::xml_parser_error("cannot open file",s,0);
+    uint64_t xml_hash = fnv1a(FNV_OFFSET,xml.data(),xml.size());
+    std::string cache = s + PARAM_CACHE_SUFFIX;
+    if(use_cache && load_cache(cache,xml_hash)){
+        cache_hit = true;
+    }
+    else{
+        loadCtrlParam(xml);
+        if(use_cache)
+            save_cache(cache,xml_hash);
+    }
+    resolve_views();
+}
+
+void ParameterManager::resolve_views(){
+    //tasks without entry in the parameter file keep zero gains
+    for(int i = 0; i < PRO_TASK_NUM; i++){
+        const taskctrlpara& tp = pro_task_ctrl_param[i];
+        pro_view[i].kpp = tp.kpp;
+        pro_view[i].psm = tp.psm;
+        pro_view[i].lv = tp.kpp * tp.psm * Eigen::Matrix<double,6,1>::Ones();
+    }
+    for(int i = 0; i < TAC_TASK_NUM; i++){
+        const taskctrlpara& tp = tac_task_ctrl_param[i];
+        if(tp.loaded == false){
+            tac_view[i].gp.setZero();
+            tac_view[i].gi.setZero();
+            tac_view[i].gd.setZero();
+            continue;
+        }
+        //the selection matrix is diagonal, so it only scales the columns of tjkm
+        Eigen::Matrix<double,6,1> sm_diag = tp.tsm.diagonal();
+        Eigen::Matrix<double,6,6> tjkm_sm = tp.ttjkm * sm_diag.asDiagonal();
+        tac_view[i].gp = tp.kpp * tjkm_sm;
+        tac_view[i].gi = tp.kpi * tjkm_sm;
+        tac_view[i].gd = tp.kpd * tjkm_sm;
+        tac_view[i].gp.bottomRows<3>() = tp.kop * tac_view[i].gp.bottomRows<3>();
+        tac_view[i].gi.bottomRows<3>() = tp.kop * tac_view[i].gi.bottomRows<3>();
+        tac_view[i].gd.bottomRows<3>() = tp.kop * tac_view[i].gd.bottomRows<3>();
+    }
+}
+
+ParamSet load_param_set(const std::string s, bool use_cache){
+    //one allocation for the parameters and the reference count
+    return std::allocate_shared<ParameterManager>(Eigen::aligned_allocator<ParameterManager>(),s,use_cache);
+}
+
+ParamSet make_param_set(const ParameterManager& p){
+    return std::allocate_shared<ParameterManager>(Eigen::aligned_allocator<ParameterManager>(),p);
+}
+
+uint32_t ParameterManager::cache_size(){
+    ParameterManager *pm = NULL;
+    return sizeof(pm->tac_task_ctrl_param) + sizeof(pm->pro_task_ctrl_param) + sizeof(pm->stiff_ctrlpara)\
+            + sizeof(pm->jnt_limits) + sizeof(pm->cart_limits) + sizeof(pm->jnt_smoothing);
+}
+
+bool ParameterManager::load_cache(const std::string& path, uint64_t xml_hash){
+    struct stat st;
+    int fd = open(path.c_str(),O_RDONLY);
+    if(fd < 0)
+        return false;
+    size_t n = sizeof(ParamCacheHeader) + cache_size();
+    if((fstat(fd,&st) != 0) || ((size_t)st.st_size != n)){
+        close(fd);
+        return false;
+    }
+    void *m = mmap(NULL,n,PROT_READ,MAP_PRIVATE,fd,0);
+    close(fd);
+    if(m == MAP_FAILED)
+        return false;
+    const ParamCacheHeader *h = (const ParamCacheHeader*)m;
+    const char *data = (const char*)m + sizeof(ParamCacheHeader);
+    char *ptr[PARAM_CACHE_BLOCKS];
+    size_t size[PARAM_CACHE_BLOCKS];
+    cache_blocks(*this,ptr,size);
+    bool ok = (h->magic == PARAM_CACHE_MAGIC) && (h->version == PARAM_CACHE_VERSION) && (h->size == cache_size())\
+            && (h->xml_hash == xml_hash);
+    if(ok){
+        //hashed block by block like save_cache does
+        uint64_t data_hash = FNV_OFFSET;
+        const char *d = data;
+        for(int i = 0; i < PARAM_CACHE_BLOCKS; i++){
+            data_hash = fnv1a(data_hash,d,size[i]);
+            d += size[i];
+        }
+        ok = (h->data_hash == data_hash);
+    }
+    if(ok){
+        for(int i = 0; i < PARAM_CACHE_BLOCKS; i++){
+            memcpy(ptr[i],data,size[i]);
+            data += size[i];
+        }
+    }
+    munmap(m,n);
+    return ok;
+}
+
+void ParameterManager::save_cache(const std::string& path, uint64_t xml_hash){
+    char *ptr[PARAM_CACHE_BLOCKS];
+    size_t size[PARAM_CACHE_BLOCKS];
+    ParamCacheHeader h;
+    memset(&h,0,sizeof(h));
+    cache_blocks(*this,ptr,size);
+    h.magic = PARAM_CACHE_MAGIC;
+    h.version = PARAM_CACHE_VERSION;
+    h.size = cache_size();
+    h.xml_hash = xml_hash;
+    h.data_hash = FNV_OFFSET;
+    for(int i = 0; i < PARAM_CACHE_BLOCKS; i++)
+        h.data_hash = fnv1a(h.data_hash,ptr[i],size[i]);
+    //written aside and renamed, a concurrent start never sees half a cache
+    std::string tmp = path + ".tmp";
+    std::ofstream f(tmp.c_str(),std::ios::binary | std::ios::trunc);
+    f.write((const char*)&h,sizeof(h));
+    for(int i = 0; i < PARAM_CACHE_BLOCKS; i++)
+        f.write(ptr[i],size[i]);
+    f.close();
+    if(!f || (rename(tmp.c_str(),path.c_str()) != 0)){
+        std::cout<<"parameter cache: can not write "<<path<<std::endl;
+        unlink(tmp.c_str());
+    }
+}
+
+void ParameterManager::load(TACTaskNameT tnt,const ptree& pt){
+    std::string sec = std::string("AdmittanceParams.") + tac_task_name(tnt);
+    tac_task_ctrl_param[tnt] = taskctrlpara();
+    tac_task_ctrl_param[tnt].loaded = true;
     for(int i = 0; i < 6; i++){
-        tac_task_ctrl_param[tnt].kpp(i,i) = pt.get<double>("AdmittanceParams."+tac_map_task_name[tnt]+"."+map_name_dim[i]+".kp");
-        tac_task_ctrl_param[tnt].kpi(i,i) = pt.get<double>("AdmittanceParams."+tac_map_task_name[tnt]+"."+map_name_dim[i]+".ki");
-        tac_task_ctrl_param[tnt].kpd(i,i) = pt.get<double>("AdmittanceParams."+tac_map_task_name[tnt]+"."+map_name_dim[i]+".kd");
-        tac_task_ctrl_param[tnt].tsm(i,i) = pt.get<double>("AdmittanceParams."+tac_map_task_name[tnt]+".tsm"+map_name_dim3[i]);
-        tac_task_ctrl_param[tnt].vsm(i,i) = pt.get<double>("AdmittanceParams."+tac_map_task_name[tnt]+".vsm"+map_name_dim3[i]);
-        tac_task_ctrl_param[tnt].vtjkm(i,i) = pt.get<double>("AdmittanceParams."+tac_map_task_name[tnt]+".vtjkm"+map_name_dim3[i]);
+        tac_task_ctrl_param[tnt].kpp(i,i) = pt.get<double>(sec+"."+name_dim[i]+".kp");
+        tac_task_ctrl_param[tnt].kpi(i,i) = pt.get<double>(sec+"."+name_dim[i]+".ki");
+        tac_task_ctrl_param[tnt].kpd(i,i) = pt.get<double>(sec+"."+name_dim[i]+".kd");
+        tac_task_ctrl_param[tnt].tsm(i,i) = pt.get<double>(sec+".tsm"+name_dim3[i]);
+        tac_task_ctrl_param[tnt].vsm(i,i) = pt.get<double>(sec+".vsm"+name_dim3[i]);
+        tac_task_ctrl_param[tnt].vtjkm(i,i) = pt.get<double>(sec+".vtjkm"+name_dim3[i]);
     }
     for(int i = 0; i < 3; i++){
-        tac_task_ctrl_param[tnt].kop(i,i) =pt.get<double>("AdmittanceParams."+tac_map_task_name[tnt]+"."+map_name_dim2[i]+".kp");
-        tac_task_ctrl_param[tnt].ttjkm(i,i) = pt.get<double>("AdmittanceParams."+tac_map_task_name[tnt]+".ttjkm"+map_name_dim3[i]);
+        tac_task_ctrl_param[tnt].kop(i,i) =pt.get<double>(sec+"."+name_dim2[i]+".kp");
+        tac_task_ctrl_param[tnt].ttjkm(i,i) = pt.get<double>(sec+".ttjkm"+name_dim3[i]);
     }
-    tac_task_ctrl_param[tnt].ttjkm(3,1) = pt.get<double>("AdmittanceParams."+tac_map_task_name[tnt]+".ttjkm.e33");
-    tac_task_ctrl_param[tnt].ttjkm(4,0) = pt.get<double>("AdmittanceParams."+tac_map_task_name[tnt]+".ttjkm.e44");
-    tac_task_ctrl_param[tnt].ttjkm(5,5) = pt.get<double>("AdmittanceParams."+tac_map_task_name[tnt]+".ttjkm.e55");
+    tac_task_ctrl_param[tnt].ttjkm(3,1) = pt.get<double>(sec+".ttjkm.e33");
+    tac_task_ctrl_param[tnt].ttjkm(4,0) = pt.get<double>(sec+".ttjkm.e44");
+    tac_task_ctrl_param[tnt].ttjkm(5,5) = pt.get<double>(sec+".ttjkm.e55");
 }
 
-void ParameterManager::load(PROTaskNameT tnt,ptree pt){
-    pro_task_ctrl_param[tnt].kpp.setZero(6,6);
-    pro_task_ctrl_param[tnt].psm.setZero(6,6);
+void ParameterManager::load(PROTaskNameT tnt,const ptree& pt){
+    std::string sec = std::string("SelfCtrlParams.") + pro_task_name(tnt);
+    pro_task_ctrl_param[tnt] = taskctrlpara();
+    pro_task_ctrl_param[tnt].loaded = true;
     for(int i = 0; i < 6; i++){
-        pro_task_ctrl_param[tnt].kpp(i,i) = pt.get<double>("SelfCtrlParams."+pro_map_task_name[tnt]+".kp");
-        pro_task_ctrl_param[tnt].psm(i,i) = pt.get<double>("SelfCtrlParams."+pro_map_task_name[tnt]+".psm"+map_name_dim3[i]);
+        pro_task_ctrl_param[tnt].kpp(i,i) = pt.get<double>(sec+".kp");
+        pro_task_ctrl_param[tnt].psm(i,i) = pt.get<double>(sec+".psm"+name_dim3[i]);
+    }
+}
+void ParameterManager::load_jnt_limits(const ptree& pt){
+    jnt_limits.speedlimit = pt.get<double>("JointLimitParams.speedlimit",jnt_limits.speedlimit);
+    for(int i = 0; i < 7; i++){
+        jnt_limits.velocity_limits[i] = pt.get<double>(std::string("JointLimitParams.velocity.")+name_axis[i],jnt_limits.velocity_limits[i]);
+        jnt_limits.accel_limits[i] = pt.get<double>(std::string("JointLimitParams.accel.")+name_axis[i],jnt_limits.accel_limits[i]);
+        jnt_limits.jerk_limits[i] = pt.get<double>(std::string("JointLimitParams.jerk.")+name_axis[i],jnt_limits.jerk_limits[i]);
+    }
+    std::string smoothing = pt.get<std::string>("JointLimitParams.smoothing","filter");
+    if(smoothing == "generator")
+        jnt_smoothing = JNT_TRAJ_GENERATOR;
+    else if(smoothing == "filter")
+        jnt_smoothing = JNT_LIMIT_FILTER;
+    else{
+        std::cout<<"unknown JointLimitParams.smoothing "<<smoothing<<", the limit filter is used"<<std::endl;
+        jnt_smoothing = JNT_LIMIT_FILTER;
     }
 }
-void ParameterManager::loadCtrlParam(std::string s){
+
+void ParameterManager::load_cart_limits(const ptree& pt){
+    cart_limits.lin_vel = pt.get<double>("CartLimitParams.linear.velocity",cart_limits.lin_vel);
+    cart_limits.lin_acc = pt.get<double>("CartLimitParams.linear.accel",cart_limits.lin_acc);
+    cart_limits.lin_jerk = pt.get<double>("CartLimitParams.linear.jerk",cart_limits.lin_jerk);
+    cart_limits.rot_vel = pt.get<double>("CartLimitParams.rotation.velocity",cart_limits.rot_vel);
+    cart_limits.rot_acc = pt.get<double>("CartLimitParams.rotation.accel",cart_limits.rot_acc);
+    cart_limits.rot_jerk = pt.get<double>("CartLimitParams.rotation.jerk",cart_limits.rot_jerk);
+}
+
+void ParameterManager::loadCtrlParam(const std::string& xml){
     ptree pt;
-    read_xml(s, pt);
-    load(CONTACT_POINT_TRACKING,pt);
-    load(CONTACT_FORCE_TRACKING,pt);
-    load(CONTACT_POINT_FORCE_TRACKING,pt);
-    load(SENSING_POLE_TRACKING,pt);
-    load(Z_ORIEN_TRACKING,pt);
-    load(LINEAR_TRACKING,pt);
-    load(COVER_OBJECT_SURFACE,pt);
-    load(OBJECT_SURFACE_EXPLORING,pt);
-    load(RLXP,pt);
-    load(RLYP,pt);
-    load(RLZP,pt);
-    load(RRXP,pt);
-    load(RRYP,pt);
-    load(RRZP,pt);
-    load(RLXN,pt);
-    load(RLYN,pt);
-    load(RLZN,pt);
-    load(RRXN,pt);
-    load(RRYN,pt);
-    load(RRZN,pt);
-    load(RP_NOCONTROL,pt);
-    load(RP_LINEFOLLOW,pt);
-    load(RP_ROTATEFOLLOW,pt);
+    std::istringstream is(xml);
+    read_xml(is, pt);
+    for(int i = 0; i < TAC_TASK_NUM; i++){
+        if(tac_task_name(i) != NULL)
+            load((TACTaskNameT)i,pt);
+    }
+    for(int i = 0; i < PRO_TASK_NUM; i++){
+        if(pro_task_name(i) != NULL)
+            load((PROTaskNameT)i,pt);
+    }
 
     stiff_ctrlpara.axis_stiffness[0] = pt.get<double>("StiffnessParams.stiffness.a1");
     stiff_ctrlpara.axis_stiffness[1] = pt.get<double>("StiffnessParams.stiffness.a2");
@@ -127,6 +323,9 @@ void ParameterManager::loadCtrlParam(std::string s){
     stiff_ctrlpara.axis_damping[4] = pt.get<double>("StiffnessParams.damping.a4");
     stiff_ctrlpara.axis_damping[5] = pt.get<double>("StiffnessParams.damping.a5");
     stiff_ctrlpara.axis_damping[6] = pt.get<double>("StiffnessParams.damping.a6");
+
+    load_jnt_limits(pt);
+    load_cart_limits(pt);
 }
 //void ActController::update_controller_para(){
 //    loadCtrlParam();
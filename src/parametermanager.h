@@ -3,33 +3,98 @@
 
 #include "CtrlParam.h"
 #include "task.h"
+#include "jntlimitfilter.h"
+#include "cartlimiter.h"
+#include "RebaType.h"
 #include <map>
+#include <memory>
+#include <stdint.h>
 //load the parameter which are stored in xml file
 #include "boost/property_tree/ptree.hpp"
 #include "boost/property_tree/xml_parser.hpp"
 #include "boost/foreach.hpp"
 using boost::property_tree::ptree;
 
+//!the compiled parameters are cached next to the xml file with this suffix
+#define PARAM_CACHE_SUFFIX ".cache"
+#define PARAM_CACHE_MAGIC 0x4b50434855b1c001ULL
+//!bump on any change of the parser or of the meaning of a cached member, not only
+//!of their layout: the cache is only checked against the xml hash and the block
+//!size, so a parser fix with the same layout would otherwise load stale values
+#define PARAM_CACHE_VERSION 2
+
+//!header of the parameter cache, followed by the members in declaration order
+struct ParamCacheHeader{
+    uint64_t magic;
+    uint32_t version;
+    //!size of the cached block, catches layout changes of the members
+    uint32_t size;
+    //!hash of the xml file the cache was compiled from and of the block
+    uint64_t xml_hash;
+    uint64_t data_hash;
+};
+
+//!gains of a proprioceptive task as ProActController uses them
+struct ProTaskView{
+    EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+    Eigen::Matrix<double,6,6> kpp;
+    Eigen::Matrix<double,6,6> psm;
+    //!kpp*psm*1, the desired local velocity of the task
+    Eigen::Matrix<double,6,1> lv;
+};
+
+//!gains of a tactile task as TacServoController uses them: kp*tjkm*sm etc.,
+//!the orientation rows already scaled by kop
+struct TacTaskView{
+    Eigen::Matrix<double,6,6> gp;
+    Eigen::Matrix<double,6,6> gi;
+    Eigen::Matrix<double,6,6> gd;
+};
+
 class ParameterManager
 {
 public:
+    EIGEN_MAKE_ALIGNED_OPERATOR_NEW
     ParameterManager();
-    ParameterManager(const std::string);
-    std::map<TACTaskNameT, taskctrlpara> tac_task_ctrl_param;
-    std::map<VISTaskNameT, taskctrlpara> vis_task_ctrl_param;
-    std::map<PROTaskNameT, taskctrlpara> pro_task_ctrl_param;
-    std::map<FORCETaskNameT, taskctrlpara> force_task_ctrl_param;
-    //    static ctrlpara o_ctrlpara;
+    //!load the xml file s, from its cache if the cache was compiled from the same file
+    ParameterManager(const std::string s, bool use_cache = true);
+    //!indexed by the task name, see taskctrlpara::loaded
+    taskctrlpara tac_task_ctrl_param[TAC_TASK_NUM];
+    taskctrlpara pro_task_ctrl_param[PRO_TASK_NUM];
     stiffpara stiff_ctrlpara;
+    //!optional JointLimitParams section, the damped LWR limits if it is missing
+    JntLimits jnt_limits;
+    //!optional CartLimitParams section, the CartLimits defaults if it is missing
+    CartLimits cart_limits;
+    //!JointLimitParams.smoothing, "filter" (default) or "generator". The apps set it
+    //!on the robot at start, a reload does not switch the smoothing of a running arm.
+    JntSmoothingT jnt_smoothing;
+    //!resolved from the task parameters once per load, indexed by the task name
+    ProTaskView pro_view[PRO_TASK_NUM];
+    TacTaskView tac_view[TAC_TASK_NUM];
+    //!true if the parameters came from the cache
+    bool from_cache() const {return cache_hit;}
 private:
-    void loadCtrlParam(std::string);
-    void load(TACTaskNameT,ptree);
-    void load(PROTaskNameT,ptree);
-    std::map<TACTaskNameT, std::string> tac_map_task_name;
-    std::map<PROTaskNameT, std::string> pro_map_task_name;
-    std::map<int,std::string> map_name_dim;
-    std::map<int,std::string> map_name_dim2;
-    std::map<int,std::string> map_name_dim3;
+    void resolve_views();
+    void loadCtrlParam(const std::string& xml);
+    //!size of the cached members
+    static uint32_t cache_size();
+    bool load_cache(const std::string& path, uint64_t xml_hash);
+    void save_cache(const std::string& path, uint64_t xml_hash);
+    bool cache_hit;
+    void load(TACTaskNameT,const ptree&);
+    void load(PROTaskNameT,const ptree&);
+    void load_jnt_limits(const ptree&);
+    void load_cart_limits(const ptree&);
 };
 
+//!a loaded parameter set, never changed afterwards. All controllers of all arms
+//!reference the same one instead of holding a copy.
+typedef std::shared_ptr<const ParameterManager> ParamSet;
+
+//!load the xml file s into a shared parameter set, see ParameterManager(s,use_cache)
+ParamSet load_param_set(const std::string s, bool use_cache = true);
+//!shared copy of p, for parameters set up in code
+ParamSet make_param_set(const ParameterManager& p);
+
 #endif // PARAMETERMANAGER_H
@@ -0,0 +1,178 @@
+#include "paramwatcher.h"
+#include <iostream>
+#include <cmath>
+#include <unistd.h>
+#include <poll.h>
+#include <sys/inotify.h>
+
+ParamWatcher::ParamWatcher(const std::string& path) : m_path(path), m_fd(-1), m_running(false), m_generation(0),\
+    m_latest(NULL), m_seen(0), m_quiescent(0), m_reloads(0), m_rejected(0), m_reclaimed(0)
+{
+    size_t slash = path.rfind('/');
+    m_dir = (slash == std::string::npos) ? "." : path.substr(0,slash);
+    m_file = (slash == std::string::npos) ? path : path.substr(slash + 1);
+}
+
+ParamWatcher::~ParamWatcher(){
+    stop();
+    for(size_t i = 0; i < m_snapshots.size(); i++)
+        delete m_snapshots[i];
+    m_snapshots.clear();
+}
+
+bool ParamWatcher::start(){
+    if(m_running.load())
+        return true;
+    m_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    //the directory is watched, editors and tools replace the file by a rename
+    if((m_fd < 0) || (inotify_add_watch(m_fd,m_dir.c_str(),IN_CLOSE_WRITE | IN_MOVED_TO) < 0)){
+        std::cout<<"parameter reload: can not watch "<<m_dir<<std::endl;
+        if(m_fd >= 0)
+            close(m_fd);
+        m_fd = -1;
+        return false;
+    }
+    m_running.store(true);
+    m_thread = std::thread(&ParamWatcher::watch,this);
+    return true;
+}
+
+void ParamWatcher::stop(){
+    m_running.store(false);
+    if(m_thread.joinable())
+        m_thread.join();
+    if(m_fd >= 0)
+        close(m_fd);
+    m_fd = -1;
+}
+
+ParamSet ParamWatcher::poll(){
+    //everything older than the snapshot in use since the last call can go
+    m_quiescent.store(m_seen,std::memory_order_release);
+    ParamSnapshot *s = m_latest.load(std::memory_order_acquire);
+    if((s == NULL) || (s->generation == m_seen))
+        return ParamSet();
+    m_seen = s->generation;
+    return s->pm;
+}
+
+uint64_t ParamWatcher::generation(){
+    return m_generation.load();
+}
+
+ParamWatchStats ParamWatcher::stats(){
+    ParamWatchStats s;
+    s.reloads = m_reloads.load();
+    s.rejected = m_rejected.load();
+    s.reclaimed = m_reclaimed.load();
+    return s;
+}
+
+static bool finite(const taskctrlpara& t){
+    return t.kpp.allFinite() && t.kpi.allFinite() && t.kpd.allFinite() && t.kop.allFinite() && t.tsm.allFinite()\
+            && t.ttjkm.allFinite() && t.vsm.allFinite() && t.vtjkm.allFinite() && t.psm.allFinite();
+}
+
+bool ParamWatcher::validate(const ParameterManager& p, std::string& reason){
+    for(int i = 0; i < TAC_TASK_NUM; i++){
+        if(finite(p.tac_task_ctrl_param[i]) == false){
+            reason = "a tactile gain is not finite";
+            return false;
+        }
+    }
+    for(int i = 0; i < PRO_TASK_NUM; i++){
+        if(finite(p.pro_task_ctrl_param[i]) == false){
+            reason = "a proprioceptive gain is not finite";
+            return false;
+        }
+    }
+    for(int i = 0; i < 7; i++){
+        if(!(p.stiff_ctrlpara.axis_stiffness[i] > 0.0) || !(p.stiff_ctrlpara.axis_damping[i] >= 0.0)\
+                || !(p.stiff_ctrlpara.axis_damping[i] <= 1.0)){
+            reason = "the axis stiffness must be positive and the damping within [0,1]";
+            return false;
+        }
+        if(!(p.jnt_limits.velocity_limits[i] > 0.0) || !(p.jnt_limits.accel_limits[i] > 0.0)\
+                || !(p.jnt_limits.jerk_limits[i] > 0.0)){
+            reason = "the joint limits must be positive";
+            return false;
+        }
+    }
+    const CartLimits& c = p.cart_limits;
+    if(!(p.jnt_limits.speedlimit > 0.0) || !(c.lin_vel > 0.0) || !(c.lin_acc > 0.0) || !(c.lin_jerk > 0.0)\
+            || !(c.rot_vel > 0.0) || !(c.rot_acc > 0.0) || !(c.rot_jerk > 0.0)){
+        reason = "the speed and cartesian limits must be positive";
+        return false;
+    }
+    return true;
+}
+
+void ParamWatcher::reload(){
+    ParamSnapshot *s = NULL;
+    std::string reason;
+    try{
+        s = new ParamSnapshot(m_path,m_generation.load() + 1);
+    }
+    catch(const std::exception& e){
+        reason = e.what();
+    }
+    if((s != NULL) && (validate(*s->pm,reason) == false)){
+        delete s;
+        s = NULL;
+    }
+    if(s == NULL){
+        m_rejected.fetch_add(1);
+        std::cout<<"parameter reload: "<<m_path<<" rejected, "<<reason<<std::endl;
+        return;
+    }
+    m_snapshots.push_back(s);
+    m_generation.store(s->generation);
+    m_latest.store(s,std::memory_order_release);
+    m_reloads.fetch_add(1);
+    std::cout<<"parameter reload: "<<m_path<<" generation "<<s->generation<<std::endl;
+}
+
+void ParamWatcher::reclaim(){
+    uint64_t q = m_quiescent.load(std::memory_order_acquire);
+    size_t k = 0;
+    for(size_t i = 0; i < m_snapshots.size(); i++){
+        //the reader can not take a new reference to a snapshot it moved past,
+        //a single reference is ours for good
+        if((m_snapshots[i]->generation < q) && (m_snapshots[i]->pm.use_count() == 1)){
+            std::atomic_thread_fence(std::memory_order_acquire);
+            delete m_snapshots[i];
+            m_reclaimed.fetch_add(1);
+        }
+        else
+            m_snapshots[k++] = m_snapshots[i];
+    }
+    m_snapshots.resize(k);
+}
+
+void ParamWatcher::watch(){
+    char buf[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+    struct pollfd pfd;
+    pfd.fd = m_fd;
+    pfd.events = POLLIN;
+    while(m_running.load()){
+        bool changed = false;
+        int timeout = PARAM_WATCH_POLL_MS;
+        //after a change wait until the file is quiet, then reload once
+        while(::poll(&pfd,1,timeout) > 0){
+            ssize_t n;
+            while((n = read(m_fd,buf,sizeof(buf))) > 0){
+                for(char *p = buf; p < buf + n; p += sizeof(struct inotify_event) + ((struct inotify_event*)p)->len){
+                    struct inotify_event *ev = (struct inotify_event*)p;
+                    if((ev->len > 0) && (m_file == ev->name))
+                        changed = true;
+                }
+            }
+            if(changed == false)
+                break;
+            timeout = PARAM_WATCH_SETTLE_MS;
+        }
+        if(changed)
+            reload();
+        reclaim();
+    }
+}
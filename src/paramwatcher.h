@@ -0,0 +1,75 @@
+#ifndef PARAMWATCHER_H
+#define PARAMWATCHER_H
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <string>
+#include <stdint.h>
+#include "parametermanager.h"
+
+//!the watcher thread checks for stop this often (ms)
+#define PARAM_WATCH_POLL_MS 100
+//!editors write a file in several steps, the reload waits until it is quiet (ms)
+#define PARAM_WATCH_SETTLE_MS 50
+
+//!a published parameter set, never changed after it is published
+struct ParamSnapshot{
+    ParamSnapshot(const std::string& path, uint64_t g) : pm(load_param_set(path)), generation(g){}
+    ParamSet pm;
+    uint64_t generation;
+};
+
+struct ParamWatchStats{
+    uint64_t reloads;
+    //!parameter files that did not parse or validate, the last good set stays active
+    uint64_t rejected;
+    uint64_t reclaimed;
+};
+
+//!reloads a parameter file when it changes on disk. The watcher thread parses and
+//!validates the file and publishes an immutable snapshot, the control thread picks
+//!it up with poll() at a cycle boundary without locking. Old snapshots are deleted
+//!once the control thread has moved past them (RCU with the control thread as the
+//!only reader) and no controller references them any more, so the last reference
+//!is never dropped on the control thread.
+class ParamWatcher
+{
+public:
+    ParamWatcher(const std::string& path);
+    ~ParamWatcher();
+    //!start watching, false if inotify is not available
+    bool start();
+    void stop();
+    //!control thread, once per cycle: the newest parameter set if it changed since
+    //!the last call, empty otherwise. Does not allocate.
+    ParamSet poll();
+    //!generation of the newest published snapshot, 0 before the first reload
+    uint64_t generation();
+    ParamWatchStats stats();
+    //!checks a parsed parameter set, false with the reason if it must not be used
+    static bool validate(const ParameterManager& p, std::string& reason);
+private:
+    void watch();
+    void reload();
+    //!delete the snapshots the reader has moved past and nobody references
+    void reclaim();
+    std::string m_path;
+    std::string m_dir;
+    std::string m_file;
+    int m_fd;
+    std::atomic<bool> m_running;
+    std::thread m_thread;
+    //!watcher thread: all snapshots not reclaimed yet, the newest last
+    std::vector<ParamSnapshot*> m_snapshots;
+    std::atomic<uint64_t> m_generation;
+    std::atomic<ParamSnapshot*> m_latest;
+    //!reader: generation of the last snapshot poll returned
+    uint64_t m_seen;
+    //!reader: snapshots older than this are not used any more
+    std::atomic<uint64_t> m_quiescent;
+    std::atomic<uint64_t> m_reloads;
+    std::atomic<uint64_t> m_rejected;
+    std::atomic<uint64_t> m_reclaimed;
+};
+
+#endif // PARAMWATCHER_H
@@ -0,0 +1,36 @@
+#include "posesnapshot.h"
+
+PoseSnapshot::PoseSnapshot() : m_seq(0)
+{
+    for(int i = 0; i < 7; i++)
+        m_pose[i].store(0.0,std::memory_order_relaxed);
+}
+
+void PoseSnapshot::publish(const Eigen::Vector3d& p, const Eigen::Quaterniond& q){
+    unsigned long s = m_seq.load(std::memory_order_relaxed);
+    m_seq.store(s + 1,std::memory_order_relaxed);
+    //a reader that sees one of the new values sees the odd sequence as well
+    std::atomic_thread_fence(std::memory_order_release);
+    for(int i = 0; i < 3; i++)
+        m_pose[i].store(p(i),std::memory_order_relaxed);
+    m_pose[3].store(q.w(),std::memory_order_relaxed);
+    m_pose[4].store(q.x(),std::memory_order_relaxed);
+    m_pose[5].store(q.y(),std::memory_order_relaxed);
+    m_pose[6].store(q.z(),std::memory_order_relaxed);
+    m_seq.store(s + 2,std::memory_order_release);
+}
+
+bool PoseSnapshot::read(Eigen::Vector3d& p, Eigen::Quaterniond& q) const {
+    double v[7];
+    unsigned long s0,s1;
+    do{
+        s0 = m_seq.load(std::memory_order_acquire);
+        for(int i = 0; i < 7; i++)
+            v[i] = m_pose[i].load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        s1 = m_seq.load(std::memory_order_relaxed);
+    }while((s0 != s1) || (s0 & 1));
+    p = Eigen::Vector3d(v[0],v[1],v[2]);
+    q = Eigen::Quaterniond(v[3],v[4],v[5],v[6]);
+    return s0 != 0;
+}
@@ -0,0 +1,25 @@
+#ifndef POSESNAPSHOT_H
+#define POSESNAPSHOT_H
+#include <atomic>
+#include <Eigen/Dense>
+#include <Eigen/Geometry>
+
+//!cartesian pose handed from the control thread to another thread, a seqlock:
+//!one writer publishes once per cycle without waiting, readers retry while a
+//!publish is in progress and never see a pose mixed from two cycles
+class PoseSnapshot
+{
+public:
+    PoseSnapshot();
+    //!writer: the pose of this cycle
+    void publish(const Eigen::Vector3d& p, const Eigen::Quaterniond& q);
+    //!reader: the last published pose, false if nothing was published yet
+    bool read(Eigen::Vector3d& p, Eigen::Quaterniond& q) const;
+private:
+    //!odd while the writer is in publish()
+    std::atomic<unsigned long> m_seq;
+    //!x y z, qw qx qy qz
+    std::atomic<double> m_pose[7];
+};
+
+#endif // POSESNAPSHOT_H
@@ -1,37 +1,45 @@
 #include "proactcontroller.h"
+#include "tracer.h"
 #include <cstddef> //for std::ptrdiff_t;
 
-ProActController::ProActController(ParameterManager &p) : ActController(p)
+ProActController::ProActController(const ParamSet& p) : ActController(p)
 {
-    initProServoCtrlParam(RLXP);
-    initProServoCtrlParam(RLYP);
-    initProServoCtrlParam(RLZP);
-    initProServoCtrlParam(RRXP);
-    initProServoCtrlParam(RRYP);
-    initProServoCtrlParam(RRZP);
-    initProServoCtrlParam(RLXN);
-    initProServoCtrlParam(RLYN);
-    initProServoCtrlParam(RLZN);
-    initProServoCtrlParam(RRXN);
-    initProServoCtrlParam(RRYN);
-    initProServoCtrlParam(RRZN);
-    initProServoCtrlParam(RP_NOCONTROL);
-    initProServoCtrlParam(RP_LINEFOLLOW);
-    initProServoCtrlParam(RP_ROTATEFOLLOW);
+    for(int i = 0; i < PRO_TASK_NUM; i++)
+        m_tuned[i] = NULL;
     llv_pro.setZero();
     lov_pro.setZero();
-    lv_pro.setZero(6);
+    traj = NULL;
 }
 
-void ProActController::set_pm(ParameterManager &p){
+ProActController::~ProActController(){
+    for(int i = 0; i < PRO_TASK_NUM; i++)
+        delete m_tuned[i];
+}
+
+void ProActController::reset(){
+    ActController::reset();
+    llv_pro.setZero();
+    lov_pro.setZero();
+}
+
+void ProActController::set_pm(const ParamSet& p){
     pm = p;
-    std::cout<<"you are update pm in proproception controller"<<std::endl;
+    //gains changed at run time by update_controller_para are replaced as well
+    for(int i = 0; i < PRO_TASK_NUM; i++)
+        updateProServoCtrlParam((PROTaskNameT)i);
 }
 
+ProTaskView& ProActController::tuned(PROTaskNameT tnt){
+    if(m_tuned[tnt] == NULL)
+        m_tuned[tnt] = new ProTaskView(pm->pro_view[tnt]);
+    return *m_tuned[tnt];
+}
 
 void ProActController::update_controller_para(Eigen::Vector3d& vel,PROTaskNameT tnt){
+    ProTaskView& v = tuned(tnt);
     for(int i = 0; i < 3; i++)
-        Kpp[tnt](i,i) = vel(i);
+        v.kpp(i,i) = vel(i);
+    v.lv = v.kpp * v.psm * Eigen::Matrix<double,6,1>::Ones();
 }
 
 void ProActController::update_controller_para(std::pair<Eigen::Vector3d,double>& r_ax,PROTaskNameT tnt){
@@ -42,44 +50,38 @@ void ProActController::update_controller_para(std::pair<Eigen::Vector3d,double>&
     for(int i = 0; i < 3; i++)
           ax(i) = fabs(ax(i));
     ax.maxCoeff(&index);
+    ProTaskView& v = tuned(tnt);
     for(int i = 3; i < 6; i++)
-        Kpp[tnt](i,i) = 0.0;
+        v.kpp(i,i) = 0.0;
     if(r_ax.first(index)>0)
-        Kpp[tnt](index+3,index+3) = r_ax.second;
+        v.kpp(index+3,index+3) = r_ax.second;
     else
-        Kpp[tnt](index+3,index+3) = (-1) * r_ax.second;
-    std::cout<<"coe......................................"<<Kpp[tnt](3,3)<<","<<Kpp[tnt](4,4)<<","<<Kpp[tnt](5,5)<<","<<index+3<<std::endl;
+        v.kpp(index+3,index+3) = (-1) * r_ax.second;
+    v.lv = v.kpp * v.psm * Eigen::Matrix<double,6,1>::Ones();
+    std::cout<<"coe......................................"<<v.kpp(3,3)<<","<<v.kpp(4,4)<<","<<v.kpp(5,5)<<","<<index+3<<std::endl;
 }
 
 void ProActController::update_controller_para_stiffness(){
 }
 
 
-void ProActController::initProServoCtrlParam(PROTaskNameT tnt){
-    Kpp[tnt].setZero(6, 6);
-    psm[tnt].setZero(6, 6);
-    Kop[tnt].setIdentity(3,3);
-    Kpp[tnt] = pm.pro_task_ctrl_param[tnt].kpp;
-    psm[tnt] = pm.pro_task_ctrl_param[tnt].psm;
-}
-
 void ProActController::updateProServoCtrlParam(PROTaskNameT tnt){
-    Kpp[tnt] = pm.pro_task_ctrl_param[tnt].kpp;
-    psm[tnt] = pm.pro_task_ctrl_param[tnt].psm;
+    delete m_tuned[tnt];
+    m_tuned[tnt] = NULL;
 }
 
 void ProActController::get_desired_lv(Robot *robot, Task *t){
-    Eigen::VectorXd identity_v;
-    identity_v.setOnes(6);
-    KukaSelfCtrlTask tst(t->curtaskname.prot);
-    tst = *(KukaSelfCtrlTask*)t;
-//    std::cout<<"kpp and psm"<<tst.curtaskname.prot<<std::endl;
-//    std::cout<<"old prot"<<t->curtaskname.prot<<std::endl;
-//    std::cout<<Kpp[tst.curtaskname.prot]<<std::endl;
-//    std::cout<<std::endl;
-    lv_pro = Kpp[tst.curtaskname.prot] * psm[tst.curtaskname.prot] * identity_v;
-    llv_pro = lv_pro.head(3);
-    lov_pro = Kop[tst.curtaskname.prot] * lv_pro.tail(3);
+    TRACE_SCOPE("pro_get_desired_lv");
+    TaskDesc td;
+    t->read_desc(td);
+    compute_lv(td);
+}
+
+void ProActController::compute_lv(const TaskDesc& td){
+    //the gain product is resolved once per parameter set, see ParameterManager::pro_view
+    const Eigen::Matrix<double,6,1>& lv = view(td.curtaskname.prot).lv;
+    llv_pro = lv.head<3>();
+    lov_pro = lv.tail<3>();
     limit_vel(get_llv_limit(),llv_pro,lov_pro);
 }
 
@@ -101,30 +103,34 @@ void ProActController::update_robot_reference(Robot *robot){
 }
 
 void ProActController::update_robot_reference(Robot *robot, Task *t){
+    TRACE_SCOPE("pro_update_robot_reference");
     Eigen::Vector3d p_target,o_target;
+    Eigen::Quaterniond q_target;
+    //LOCAL and TRAJECTORY yield a quaternion, the absolute references an axis angle
+    bool has_q = false;
+    TaskDesc td;
+    //one consistent snapshot of the task per cycle
+    t->read_desc(td);
     p_target.setZero();
     o_target.setZero();
-    if(t->mft == GLOBAL){
-        p_target = t->get_desired_p_eigen();
-        o_target = t->get_desired_o_ax();
+    if(td.mft == GLOBAL){
+        p_target = td.desired_p_eigen;
+        o_target = td.desired_o_ax;
     }
-    if(t->mft == LOCAL){
-        get_desired_lv(robot,t);
-        limit_eef_euler(get_euler_limit());
-//        std::cout<<"lv before in proservo "<<llv<<std::endl;
-//        std::cout<<lov<<std::endl;
-        llv = llv + llv_pro;
-        lov = lov + lov_pro;
-//        std::cout<<"lv after in proservo "<<llv<<std::endl;
-//        std::cout<<lov<<std::endl;
-        local_to_global(robot->get_cur_cart_p(),robot->get_cur_cart_o(),llv,\
-                        lov,p_target,o_target);
+    if(td.mft == LOCAL){
+        compute_lv(td);
+        limit_eef_orien();
+        //combining with other controllers is done by CtrlPipeline
+        set_cycle_time(robot->gettimecycle());
+        local_to_global(robot->get_cur_cart_p(),robot->get_cur_cart_o(),llv_pro,\
+                        lov_pro,p_target,q_target);
+        has_q = true;
     }
-    if(t->mft == LOCALP2P){
+    if(td.mft == LOCALP2P){
         //checking the whether moved distance is the same like desired move distance
-        if((robot->get_cur_cart_p()-t->get_initial_p_eigen()).norm()<\
-            (t->get_desired_p_eigen()-t->get_initial_p_eigen()).norm()){
-            p_target = robot->get_cur_cart_p() + t->velocity_p2p;\
+        if((robot->get_cur_cart_p()-td.initial_p_eigen).norm()<\
+            (td.desired_p_eigen-td.initial_p_eigen).norm()){
+            p_target = robot->get_cur_cart_p() + td.velocity_p2p;\
 //            std::cout<<"p cur are "<<robot->get_cur_cart_p()<<std::endl;
 //            std::cout<<"vel "<<t->velocity_p2p<<std::endl;
         }
@@ -132,14 +138,25 @@ void ProActController::update_robot_reference(Robot *robot, Task *t){
             p_target = robot->get_cur_cart_p();
         }
 //        std::cout<<"in local p2p mode"<<std::endl;
-        o_target = t->get_desired_o_ax();
+        o_target = td.desired_o_ax;
+    }
+    if(td.mft == TRAJECTORY){
+        set_cycle_time(robot->gettimecycle());
+        if((traj == NULL) || (traj->sample(get_cycle_time(),p_target,q_target) == false)){
+            p_target = robot->get_cur_cart_p();
+            q_target = Eigen::Quaterniond(robot->get_cur_cart_o());
+        }
+        has_q = true;
+    }
+    if(has_q){
+        robot->set_cart_command(p_target,q_target);
+        return;
     }
     for (int i=0; i < 3; i++){
         cart_command[i] = p_target(i);
         cart_command[i+3] = o_target(i);
     }
-    for(int i = 0; i < 6; i++)
-        robot->set_cart_command(cart_command);
+    robot->set_cart_command(cart_command);
 }
 
 
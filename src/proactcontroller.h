@@ -3,12 +3,15 @@
 #include "actcontroller.h"
 #include "Robot.h"
 #include "kukaselfctrltask.h"
+#include "trajqueue.h"
 
 
 class ProActController : public ActController
 {
 public:
-    ProActController(ParameterManager &p);
+    EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+    ProActController(const ParamSet& p);
+    ~ProActController();
     //hold the object in its current pose
     void update_robot_reference(Robot *);
     //move the object to the desired reference designed by Task
@@ -18,25 +21,30 @@ public:
     void update_controller_para(std::pair<Eigen::Vector3d,double>&,PROTaskNameT);
     void update_controller_para_stiffness();
     void updateTacServoCtrlParam(TACTaskNameT){}
+    //!back to the gains of the parameter set, drops changes made by update_controller_para
     void updateProServoCtrlParam(PROTaskNameT tnt);
-    void set_pm(ParameterManager &p);
+    void set_pm(const ParamSet& p);
+    //!clears the integration state, the gains are kept
+    void reset();
     void get_desired_lv(Robot *, Task *);
     void get_desired_lv(Robot *, Task *, myrmex_msg *){}
     void get_lv(Eigen::Vector3d& lv, Eigen::Vector3d& ov);
-    void set_init_TM(Eigen::Matrix3d tm) {m_init_tm = tm;}
+    //!queue sampled in the TRAJECTORY frame, not owned
+    void attach_trajectory(TrajQueue *q) {traj = q;}
 private:
+    ProActController(const ProActController&);
+    ProActController& operator=(const ProActController&);
     void get_joint_position();
     void set_eff_command(Eigen::Vector3d p, Eigen::Vector3d o);
     void set_eff_command(Eigen::Vector3d p, Eigen::Matrix3d o);
-    void initProServoCtrlParam(PROTaskNameT);
-    //!select matrix
-    std::map<PROTaskNameT, Eigen::MatrixXd> psm;
-    //!pose kp parameter
-    std::map<PROTaskNameT, Eigen::MatrixXd> Kpp;
-    //!pose kp parameter
-    std::map<PROTaskNameT, Eigen::Matrix3d> Kop;
+    //!copy of the task gains the controller may change, made on the first change
+    ProTaskView& tuned(PROTaskNameT);
+    void compute_lv(const TaskDesc&);
+    const ProTaskView& view(PROTaskNameT tnt) const {return m_tuned[tnt] ? *m_tuned[tnt] : pm->pro_view[tnt];}
+    //!tasks whose gains were changed at run time, NULL while the shared ones apply
+    ProTaskView *m_tuned[PRO_TASK_NUM];
     Eigen::Vector3d llv_pro,lov_pro;
-    Eigen::VectorXd lv_pro;
+    TrajQueue *traj;
 };
 
 #endif // PROACTCONTROLLER_H
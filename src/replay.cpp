@@ -0,0 +1,207 @@
+#include "replay.h"
+#include <iostream>
+#include <cmath>
+#include <time.h>
+#include <unistd.h>
+
+Replay::Replay(const std::string& param_file, RobotNameT rn)
+{
+    pm = load_param_set(param_file);
+    m_rn = rn;
+    m_cycle_time = REPLAY_DEFAULT_CYCLE_TIME;
+    com = NULL;
+    kuka = NULL;
+    pool = NULL;
+    pipeline = NULL;
+    ac = NULL;
+    task = NULL;
+}
+
+Replay::~Replay(){
+    release();
+}
+
+void Replay::release(){
+    delete pipeline;
+    delete pool;
+    delete kuka;
+    delete com;
+    pipeline = NULL;
+    pool = NULL;
+    kuka = NULL;
+    com = NULL;
+}
+
+bool Replay::open(const std::string& session){
+    std::vector<std::string> names;
+    if(log.open(session) == false)
+        return false;
+    cycle_record_channels(names);
+    if(log.channels() != names.size()){
+        std::cout<<"replay: "<<session<<" has "<<log.channels()<<" channels, a cycle log has "<<names.size()<<std::endl;
+        return false;
+    }
+    for(size_t i = 0; i < names.size(); i++){
+        if(log.channel_name(i) != names[i]){
+            std::cout<<"replay: channel "<<i<<" of "<<session<<" is "<<log.channel_name(i)<<" instead of "<<names[i]<<std::endl;
+            return false;
+        }
+    }
+    //FRI cycles are whole milliseconds
+    if(log.rows() > 1){
+        double t = (log.time(log.rows()-1) - log.time(0))/(log.rows()-1);
+        if(t > 0.0005)
+            m_cycle_time = 0.001*floor(1000.0*t + 0.5);
+    }
+    return true;
+}
+
+void Replay::read_record(uint64_t row, CycleRecord& r){
+    double values[CYCLE_LOG_CHANNELS];
+    for(int i = 0; i < CYCLE_LOG_CHANNELS; i++)
+        values[i] = log.value(row,i);
+    cycle_record_from_values(values,r);
+    r.timestamp = log.time(row);
+}
+
+void Replay::feed(const CycleRecord& r){
+    for(int i = 0; i < 7; i++){
+        com->jnt_position_act[i] = r.q_act[i];
+        com->jnt_position_mea[i] = r.q_mea[i];
+    }
+    //same order as KukaLwr::read_eef_ft
+    com->ft->x = r.ft[0];
+    com->ft->y = r.ft[1];
+    com->ft->z = r.ft[2];
+    com->ft->c = r.ft[3];
+    com->ft->b = r.ft[4];
+    com->ft->a = r.ft[5];
+}
+
+void Replay::apply_task(const TaskDesc& td, bool first){
+    KukaSelfCtrlTask *t;
+    int slot = -1;
+    if(first){
+        //the session starts with the task the app set up before the loop
+        t = pool->active_task();
+    }
+    else{
+        slot = pool->acquire();
+        if(slot < 0)
+            return;
+        t = pool->task(slot);
+    }
+    t->curtaskname = td.curtaskname;
+    t->mt = td.mt;
+    t->mft = td.mft;
+    t->velocity_p2p = td.velocity_p2p;
+    t->set_initial_p_eigen(td.initial_p_eigen);
+    t->set_desired_p_eigen(td.desired_p_eigen);
+    t->set_desired_o_ax(td.desired_o_ax);
+    if(first){
+        t->commit();
+        return;
+    }
+    pool->submit(slot);
+    if(pool->swap()){
+        ac = pool->active_controller();
+        task = pool->active_task();
+        pipeline->update_stage(PRO_STAGE,ac,task);
+        pipeline->reset();
+    }
+}
+
+bool Replay::run(ReplayStats& stats, double tolerance){
+    CycleRecord r;
+    TaskDesc td;
+    myrmex_msg tacfb;
+    double last_switches = -1.0;
+    double stiffness[7];
+    stiffpara sp = pm->stiff_ctrlpara;
+    struct timespec t0,t1;
+
+    stats.cycles = 0;
+    stats.task_switches = 0;
+    stats.divergent = 0;
+    stats.first_divergent = -1;
+    stats.max_jnt_diff = 0.0;
+    stats.max_cart_diff = 0.0;
+    stats.wall_time = 0.0;
+    if(log.rows() == 0)
+        return false;
+
+    //the CBF resource starts from the first recorded joint position
+    release();
+    read_record(0,r);
+    com = new ComOkc(m_rn,(float)m_cycle_time);
+    feed(r);
+    kuka = new KukaLwr(m_rn,*com);
+    kuka->set_jnt_limits(pm->jnt_limits);
+    kuka->set_cart_limits(pm->cart_limits);
+    if((m_out.empty() == false) && (kuka->cycle_log.open(m_out) == false))
+        return false;
+    pool = new CtrlPool(pm);
+    ac = pool->active_controller();
+    task = pool->active_task();
+    pipeline = new CtrlPipeline();
+    pipeline->set_stage(PRO_STAGE,ac,task);
+    for(int i = 0; i < 7; i++)
+        stiffness[i] = -1.0;
+
+    clock_gettime(CLOCK_MONOTONIC,&t0);
+    for(uint64_t row = 0; row < log.rows(); row++){
+        read_record(row,r);
+        bool has_tacfb = cycle_record_get_task(r,td,tacfb);
+        feed(r);
+        kuka->set_virtual_time(r.timestamp);
+        kuka->get_joint_position_act();
+        kuka->get_joint_position_mea();
+        kuka->update_robot_state();
+        for(int i = 0; i < 7; i++){
+            if(r.axis_stiffness[i] != stiffness[i]){
+                for(int j = 0; j < 7; j++)
+                    stiffness[j] = r.axis_stiffness[j];
+                kuka->setAxisStiffnessDamping(stiffness,sp.axis_damping);
+                break;
+            }
+        }
+        if(r.task_switches != last_switches){
+            apply_task(td,last_switches < 0.0);
+            if(last_switches >= 0.0)
+                stats.task_switches++;
+            last_switches = r.task_switches;
+        }
+        if(td.mft == TRAJECTORY){
+            //the queue is not recorded, the recorded command stands in for it
+            kuka->set_cart_command(r.cart_command);
+            kuka->set_log_context(td,pipeline->task_switches(),NULL);
+        }
+        else if(td.mt == JOINTS)
+            pipeline->run(kuka,has_tacfb ? &tacfb : NULL);
+        kuka->update_cbf_controller();
+        kuka->set_joint_command((RobotModeT)(int)r.mode);
+
+        double jnt_diff = 0.0;
+        double cart_diff = 0.0;
+        const double *cart_reference = kuka->get_cart_reference();
+        for(int i = 0; i < 7; i++)
+            jnt_diff = std::max(jnt_diff,fabs(kuka->jnt_command[i] - r.jnt_command[i]));
+        for(int i = 0; i < 6; i++)
+            cart_diff = std::max(cart_diff,fabs(cart_reference[i] - r.cart_reference[i]));
+        stats.max_jnt_diff = std::max(stats.max_jnt_diff,jnt_diff);
+        stats.max_cart_diff = std::max(stats.max_cart_diff,cart_diff);
+        if((jnt_diff > tolerance) || (cart_diff > tolerance)){
+            if(stats.first_divergent < 0)
+                stats.first_divergent = row;
+            stats.divergent++;
+        }
+        stats.cycles++;
+        //the writer drains in the background, do not overrun the ring
+        while(kuka->cycle_log.is_open() && (kuka->cycle_log.pending() > CYCLE_LOG_SIZE/2))
+            usleep(1000);
+    }
+    clock_gettime(CLOCK_MONOTONIC,&t1);
+    stats.wall_time = (t1.tv_sec - t0.tv_sec) + 1e-9*(t1.tv_nsec - t0.tv_nsec);
+    kuka->cycle_log.close();
+    return true;
+}
@@ -0,0 +1,67 @@
+#ifndef REPLAY_H
+#define REPLAY_H
+#include <string>
+#include <stdint.h>
+#include "ComOkc.h"
+#include "KukaLwr.h"
+#include "ctrlpipeline.h"
+#include "ctrlpool.h"
+#include "parametermanager.h"
+#include "sessionlog.h"
+#include "cyclelog.h"
+
+//!commands closer than this to the recorded ones count as equal, the recorded
+//!joint command is a float
+#define REPLAY_TOLERANCE 1e-6
+//!used if the session has less than two cycles
+#define REPLAY_DEFAULT_CYCLE_TIME 0.004
+
+struct ReplayStats{
+    uint64_t cycles;
+    uint64_t task_switches;
+    //!cycles with a joint command or cartesian reference off by more than the tolerance
+    uint64_t divergent;
+    //!first divergent cycle, -1 if the replay matches the recording
+    int64_t first_divergent;
+    double max_jnt_diff;
+    double max_cart_diff;
+    //!wall clock time of the replay (s)
+    double wall_time;
+};
+
+//!runs a recorded session log through the controller stack as fast as possible.
+//!Joint positions, ft, tactile feedback and the task switches of the recording
+//!drive a KukaLwr on a detached ComOkc, the time of the recording is its clock,
+//!and every cycle the commands are compared with the recorded ones.
+class Replay
+{
+public:
+    Replay(const std::string& param_file, RobotNameT rn = kuka_right);
+    ~Replay();
+    //!false if the file is not a cycle log of this version
+    bool open(const std::string& session);
+    //!write the replayed cycles as a session log to path, call before run
+    void log_to(const std::string& path){m_out = path;}
+    //!cycle time of the controllers, by default estimated from the recorded timestamps
+    void set_cycle_time(double t){m_cycle_time = t;}
+    double get_cycle_time(){return m_cycle_time;}
+    bool run(ReplayStats& stats, double tolerance = REPLAY_TOLERANCE);
+private:
+    void read_record(uint64_t row, CycleRecord& r);
+    void feed(const CycleRecord& r);
+    void apply_task(const TaskDesc& td, bool first);
+    void release();
+    ParamSet pm;
+    RobotNameT m_rn;
+    SessionLogReader log;
+    std::string m_out;
+    double m_cycle_time;
+    ComOkc *com;
+    KukaLwr *kuka;
+    CtrlPool *pool;
+    CtrlPipeline *pipeline;
+    ActController *ac;
+    Task *task;
+};
+
+#endif // REPLAY_H
@@ -0,0 +1,252 @@
+#include "sessionlog.h"
+#include <iostream>
+#include <algorithm>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+static uint64_t round_up(uint64_t n, uint64_t page){
+    return ((n + page - 1) / page) * page;
+}
+
+//!byte offsets inside a chunk of c channels and r rows
+static uint64_t min_offset(){return sizeof(SessionChunkHeader);}
+static uint64_t max_offset(uint64_t c){return min_offset() + c*sizeof(double);}
+static uint64_t time_offset(uint64_t c){return max_offset(c) + c*sizeof(double);}
+static uint64_t column_offset(uint64_t c, uint64_t r, int ch){return time_offset(c) + (ch+1)*r*sizeof(double);}
+
+SessionLogWriter::SessionLogWriter()
+{
+    m_fd = -1;
+    m_header = NULL;
+    m_chunk = NULL;
+    m_chunk_index = 0;
+}
+
+SessionLogWriter::~SessionLogWriter(){
+    close();
+}
+
+bool SessionLogWriter::open(const std::string& path, const std::vector<std::string>& channels,\
+                            uint32_t chunk_rows){
+    close();
+    if((channels.size() > SESSION_LOG_MAX_CHANNELS) || (chunk_rows == 0)){
+        std::cout<<"session log: at most "<<SESSION_LOG_MAX_CHANNELS<<" channels and one row per chunk"<<std::endl;
+        return false;
+    }
+    m_fd = ::open(path.c_str(),O_RDWR | O_CREAT | O_TRUNC,0644);
+    if(m_fd < 0){
+        std::cout<<"session log: can not create "<<path<<std::endl;
+        return false;
+    }
+    uint64_t page = sysconf(_SC_PAGESIZE);
+    uint64_t data_offset = round_up(sizeof(SessionLogHeader),page);
+    void *h = MAP_FAILED;
+    if(ftruncate(m_fd,data_offset) == 0)
+        h = mmap(NULL,data_offset,PROT_READ | PROT_WRITE,MAP_SHARED,m_fd,0);
+    if(h == MAP_FAILED){
+        std::cout<<"session log: can not map the header of "<<path<<std::endl;
+        ::close(m_fd);
+        m_fd = -1;
+        return false;
+    }
+    m_header = (SessionLogHeader*)h;
+    memset(m_header,0,sizeof(SessionLogHeader));
+    m_header->magic = SESSION_LOG_MAGIC;
+    m_header->version = SESSION_LOG_VERSION;
+    m_header->channels = channels.size();
+    m_header->chunk_rows = chunk_rows;
+    m_header->chunk_size = round_up(column_offset(channels.size(),chunk_rows,channels.size()),page);
+    m_header->data_offset = data_offset;
+    for(size_t i = 0; i < channels.size(); i++)
+        strncpy(m_header->names[i],channels[i].c_str(),SESSION_LOG_NAME_LEN-1);
+    m_chunk = NULL;
+    m_chunk_index = 0;
+    return true;
+}
+
+bool SessionLogWriter::map_chunk(uint64_t k){
+    uint64_t offset = m_header->data_offset + k*m_header->chunk_size;
+    if(ftruncate(m_fd,offset + m_header->chunk_size) != 0)
+        return false;
+    void *c = mmap(NULL,m_header->chunk_size,PROT_READ | PROT_WRITE,MAP_SHARED,m_fd,offset);
+    if(c == MAP_FAILED)
+        return false;
+    m_chunk = (char*)c;
+    m_chunk_index = k;
+    m_header->chunks = k + 1;
+    return true;
+}
+
+void SessionLogWriter::unmap_chunk(){
+    if(m_chunk != NULL)
+        munmap(m_chunk,m_header->chunk_size);
+    m_chunk = NULL;
+}
+
+bool SessionLogWriter::append(double t, const double *values){
+    if(m_header == NULL)
+        return false;
+    uint64_t c = m_header->channels;
+    uint64_t r = m_header->chunk_rows;
+    if(m_chunk == NULL){
+        if(map_chunk(m_header->chunks) == false)
+            return false;
+    }
+    else if(((SessionChunkHeader*)m_chunk)->rows == r){
+        unmap_chunk();
+        if(map_chunk(m_chunk_index + 1) == false)
+            return false;
+    }
+    SessionChunkHeader *ch = (SessionChunkHeader*)m_chunk;
+    double *v_min = (double*)(m_chunk + min_offset());
+    double *v_max = (double*)(m_chunk + max_offset(c));
+    uint64_t n = ch->rows;
+    ((double*)(m_chunk + time_offset(c)))[n] = t;
+    for(uint64_t i = 0; i < c; i++){
+        ((double*)(m_chunk + column_offset(c,r,i)))[n] = values[i];
+        if((n == 0) || (values[i] < v_min[i]))
+            v_min[i] = values[i];
+        if((n == 0) || (values[i] > v_max[i]))
+            v_max[i] = values[i];
+    }
+    if(n == 0)
+        ch->t_min = t;
+    ch->t_max = t;
+    ch->rows = n + 1;
+    m_header->rows++;
+    return true;
+}
+
+void SessionLogWriter::close(){
+    if(m_header != NULL){
+        unmap_chunk();
+        munmap(m_header,m_header->data_offset);
+        m_header = NULL;
+    }
+    if(m_fd >= 0)
+        ::close(m_fd);
+    m_fd = -1;
+}
+
+SessionLogReader::SessionLogReader()
+{
+    m_fd = -1;
+    m_size = 0;
+    m_data = NULL;
+    m_header = NULL;
+}
+
+SessionLogReader::~SessionLogReader(){
+    close();
+}
+
+bool SessionLogReader::open(const std::string& path){
+    struct stat st;
+    close();
+    m_fd = ::open(path.c_str(),O_RDONLY);
+    if((m_fd < 0) || (fstat(m_fd,&st) != 0) || ((size_t)st.st_size < sizeof(SessionLogHeader))){
+        std::cout<<"session log: can not open "<<path<<std::endl;
+        close();
+        return false;
+    }
+    m_size = st.st_size;
+    void *d = mmap(NULL,m_size,PROT_READ,MAP_SHARED,m_fd,0);
+    if(d == MAP_FAILED){
+        std::cout<<"session log: can not map "<<path<<std::endl;
+        m_size = 0;
+        close();
+        return false;
+    }
+    m_data = (const char*)d;
+    m_header = (const SessionLogHeader*)m_data;
+    if((m_header->magic != SESSION_LOG_MAGIC) || (m_header->version != SESSION_LOG_VERSION) ||\
+            (m_header->data_offset + m_header->chunks*m_header->chunk_size > m_size)){
+        std::cout<<"session log: "<<path<<" is not a session log or is truncated"<<std::endl;
+        close();
+        return false;
+    }
+    return true;
+}
+
+void SessionLogReader::close(){
+    if(m_data != NULL)
+        munmap((void*)m_data,m_size);
+    if(m_fd >= 0)
+        ::close(m_fd);
+    m_fd = -1;
+    m_size = 0;
+    m_data = NULL;
+    m_header = NULL;
+}
+
+std::string SessionLogReader::channel_name(int ch){
+    return std::string(m_header->names[ch],strnlen(m_header->names[ch],SESSION_LOG_NAME_LEN));
+}
+
+int SessionLogReader::channel_index(const std::string& name){
+    for(uint32_t i = 0; i < m_header->channels; i++){
+        if(channel_name(i) == name)
+            return i;
+    }
+    return -1;
+}
+
+const double* SessionLogReader::column(uint64_t k, int ch){
+    return (const double*)((const char*)chunk(k) + column_offset(m_header->channels,m_header->chunk_rows,ch));
+}
+
+uint64_t SessionLogReader::lower_bound(double t){
+    //first chunk that ends at or after t, the chunk headers are the index
+    uint64_t lo = 0;
+    uint64_t hi = m_header->chunks;
+    while(lo < hi){
+        uint64_t mid = (lo + hi)/2;
+        const SessionChunkHeader *c = chunk(mid);
+        if((c->rows == 0) || (c->t_max < t))
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    if(lo == m_header->chunks)
+        return rows();
+    const double *times = column(lo,-1);
+    return lo*m_header->chunk_rows + (std::lower_bound(times,times + chunk(lo)->rows,t) - times);
+}
+
+uint64_t SessionLogReader::read(int ch, double t0, double t1, std::vector<double>* times, std::vector<double>& values){
+    uint64_t row = lower_bound(t0);
+    uint64_t r = m_header->chunk_rows;
+    uint64_t n = 0;
+    values.clear();
+    if(times != NULL)
+        times->clear();
+    while(row < rows()){
+        uint64_t k = row/r;
+        const double *t = column(k,-1);
+        const double *v = column(k,ch);
+        uint64_t end = chunk(k)->rows;
+        uint64_t i = row%r;
+        for(; (i < end) && (t[i] < t1); i++){
+            values.push_back(v[i]);
+            if(times != NULL)
+                times->push_back(t[i]);
+            n++;
+        }
+        if(i < end)
+            break;
+        row = (k+1)*r;
+    }
+    return n;
+}
+
+void SessionLogReader::chunk_index(uint64_t k, int ch, double& t_min, double& t_max, double& v_min, double& v_max){
+    const SessionChunkHeader *c = chunk(k);
+    uint64_t channels = m_header->channels;
+    t_min = c->t_min;
+    t_max = c->t_max;
+    v_min = ((const double*)((const char*)c + min_offset()))[ch];
+    v_max = ((const double*)((const char*)c + max_offset(channels)))[ch];
+}
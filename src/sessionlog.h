@@ -0,0 +1,100 @@
+#ifndef SESSIONLOG_H
+#define SESSIONLOG_H
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#define SESSION_LOG_MAGIC 0x474c534b
+#define SESSION_LOG_VERSION 1
+//!rows per chunk, 1024 rows are about 4s at 250Hz
+#define SESSION_LOG_CHUNK_ROWS 1024
+#define SESSION_LOG_MAX_CHANNELS 128
+#define SESSION_LOG_NAME_LEN 32
+
+//!Columnar session log. The file starts with a SessionLogHeader, the data
+//!starts at data_offset and consists of chunks of chunk_size bytes:
+//!  SessionChunkHeader
+//!  double min[channels], max[channels]    per chunk index of every channel
+//!  double time[chunk_rows]
+//!  double value[channels][chunk_rows]    one column per channel
+//!Chunks have a fixed size, so row r is found in chunk r/chunk_rows without a
+//!separate index. Only the last chunk may be partially filled.
+struct SessionLogHeader{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t channels;
+    uint32_t chunk_rows;
+    uint64_t chunk_size;
+    uint64_t data_offset;
+    uint64_t chunks;
+    uint64_t rows;
+    char names[SESSION_LOG_MAX_CHANNELS][SESSION_LOG_NAME_LEN];
+};
+
+struct SessionChunkHeader{
+    uint64_t rows;
+    uint64_t reserved;
+    double t_min;
+    double t_max;
+};
+
+//!appends rows to a session log through a mapping of the current chunk, the
+//!file grows by one chunk at a time
+class SessionLogWriter
+{
+public:
+    SessionLogWriter();
+    ~SessionLogWriter();
+    bool open(const std::string& path, const std::vector<std::string>& channels,\
+              uint32_t chunk_rows = SESSION_LOG_CHUNK_ROWS);
+    //!append one row, values holds one value per channel. Times have to be non decreasing.
+    bool append(double t, const double *values);
+    void close();
+    bool is_open(){return m_fd >= 0;}
+    uint64_t rows(){return m_header ? m_header->rows : 0;}
+private:
+    bool map_chunk(uint64_t k);
+    void unmap_chunk();
+    int m_fd;
+    SessionLogHeader *m_header;
+    char *m_chunk;
+    uint64_t m_chunk_index;
+};
+
+//!random access to a session log by time range and channel, the file is mapped
+//!read only and nothing is parsed up front
+class SessionLogReader
+{
+public:
+    SessionLogReader();
+    ~SessionLogReader();
+    bool open(const std::string& path);
+    void close();
+    uint32_t channels(){return m_header->channels;}
+    std::string channel_name(int ch);
+    //!-1 if there is no channel of that name
+    int channel_index(const std::string& name);
+    uint64_t rows(){return m_header->rows;}
+    uint64_t chunks(){return m_header->chunks;}
+    double time(uint64_t row){return column(row/m_header->chunk_rows,-1)[row%m_header->chunk_rows];}
+    double value(uint64_t row, int ch){return column(row/m_header->chunk_rows,ch)[row%m_header->chunk_rows];}
+    //!first row with a time not before t, rows() if there is none
+    uint64_t lower_bound(double t);
+    //!copy channel ch of the rows with t0 <= time < t1, times may be NULL.
+    //!Returns the number of rows.
+    uint64_t read(int ch, double t0, double t1, std::vector<double>* times, std::vector<double>& values);
+    //!time range of chunk k and the range of channel ch in it
+    void chunk_index(uint64_t k, int ch, double& t_min, double& t_max, double& v_min, double& v_max);
+private:
+    const SessionChunkHeader* chunk(uint64_t k){
+        return (const SessionChunkHeader*)(m_data + m_header->data_offset + k*m_header->chunk_size);
+    }
+    //!column of channel ch in chunk k, ch = -1 is the time column
+    const double* column(uint64_t k, int ch);
+    int m_fd;
+    size_t m_size;
+    const char *m_data;
+    const SessionLogHeader *m_header;
+};
+
+#endif // SESSIONLOG_H
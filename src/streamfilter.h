@@ -0,0 +1,224 @@
+#ifndef STREAMFILTER_H
+#define STREAMFILTER_H
+#include <cmath>
+#include <Eigen/Dense>
+
+//!Fixed capacity streaming filters for the signals of the control cycle. The
+//!state lives inside the filter object, a sample costs O(1) (O(N) for the
+//!median of a fixed N) and nothing is allocated. The value type is double or a
+//!fixed size Eigen vector such as Eigen::Vector3d or Eigen::Matrix<double,7,1>,
+//!vectors are filtered component by component.
+
+//!the operations the filters need from a value type, fixed size Eigen vectors
+template<typename T>
+struct StreamValue{
+    static const int size = T::SizeAtCompileTime;
+    static T zero(){return T::Zero();}
+    static double& coeff(T& v, int i){return v(i);}
+    static double coeff(const T& v, int i){return v(i);}
+    static double norm(const T& v){return v.norm();}
+};
+
+template<>
+struct StreamValue<double>{
+    static const int size = 1;
+    static double zero(){return 0.0;}
+    static double& coeff(double& v, int){return v;}
+    static double coeff(const double& v, int){return v;}
+    static double norm(const double& v){return fabs(v);}
+};
+
+//!mean of the last N samples with a running sum. The sum is rebuilt from the
+//!window whenever the ring buffer wraps, rounding errors do not accumulate.
+template<typename T, int N>
+class MovingAverage
+{
+public:
+    EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+    MovingAverage(){reset();}
+    void reset(){
+        m_sum = StreamValue<T>::zero();
+        m_head = 0;
+        m_count = 0;
+    }
+    const T& add(const T& x){
+        if(m_count == N)
+            m_sum -= m_buf[m_head];
+        else
+            m_count++;
+        m_buf[m_head] = x;
+        m_sum += x;
+        if(++m_head == N){
+            m_head = 0;
+            m_sum = m_buf[0];
+            for(int i = 1; i < m_count; i++)
+                m_sum += m_buf[i];
+        }
+        m_value = m_sum/(double)m_count;
+        return m_value;
+    }
+    const T& value() const {return m_value;}
+    //!number of samples in the window, N once it is full
+    int count() const {return m_count;}
+private:
+    T m_buf[N];
+    T m_sum;
+    T m_value;
+    int m_head;
+    int m_count;
+};
+
+//!second order IIR section in transposed direct form II,
+//!y = (b0 + b1 z^-1 + b2 z^-2)/(1 + a1 z^-1 + a2 z^-2) x.
+//!Starts with zero state, reset(x) starts in the steady state of x instead.
+template<typename T>
+class Biquad
+{
+public:
+    EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+    Biquad(){set_coeffs(1.0,0.0,0.0,0.0,0.0);}
+    void set_coeffs(double b0, double b1, double b2, double a1, double a2){
+        m_b0 = b0; m_b1 = b1; m_b2 = b2; m_a1 = a1; m_a2 = a2;
+        reset();
+    }
+    //!butterworth low pass (q = 1/sqrt(2)) with the cutoff fc in Hz at the sample time dt
+    void set_lowpass(double fc, double dt, double q = M_SQRT1_2){
+        double w = 2.0*M_PI*fc*dt;
+        double alpha = sin(w)/(2.0*q);
+        double c = cos(w);
+        double a0 = 1.0 + alpha;
+        set_coeffs(0.5*(1.0 - c)/a0,(1.0 - c)/a0,0.5*(1.0 - c)/a0,-2.0*c/a0,(1.0 - alpha)/a0);
+    }
+    //!first order y = alpha*x + (1-alpha)*y_last
+    void set_one_pole(double alpha){
+        set_coeffs(alpha,0.0,0.0,alpha - 1.0,0.0);
+    }
+    void reset(){
+        m_z1 = StreamValue<T>::zero();
+        m_z2 = StreamValue<T>::zero();
+        m_value = StreamValue<T>::zero();
+    }
+    void reset(const T& x){
+        double dc = (m_b0 + m_b1 + m_b2)/(1.0 + m_a1 + m_a2);
+        m_value = dc*x;
+        m_z1 = m_value - m_b0*x;
+        m_z2 = m_b2*x - m_a2*m_value;
+    }
+    const T& add(const T& x){
+        m_value = m_b0*x + m_z1;
+        m_z1 = m_b1*x - m_a1*m_value + m_z2;
+        m_z2 = m_b2*x - m_a2*m_value;
+        return m_value;
+    }
+    const T& value() const {return m_value;}
+private:
+    double m_b0,m_b1,m_b2,m_a1,m_a2;
+    T m_z1,m_z2;
+    T m_value;
+};
+
+//!median of the last N samples for every component. Each component keeps its
+//!window sorted, a sample replaces the oldest value by one insertion step.
+template<typename T, int N>
+class MedianFilter
+{
+public:
+    EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+    MedianFilter(){reset();}
+    void reset(){
+        m_head = 0;
+        m_count = 0;
+        m_value = StreamValue<T>::zero();
+    }
+    const T& add(const T& x){
+        for(int c = 0; c < StreamValue<T>::size; c++){
+            double v = StreamValue<T>::coeff(x,c);
+            double *s = m_sorted[c];
+            int k = m_count;
+            int last = m_count;
+            if(m_count == N){
+                //the oldest sample leaves, k is its place in the sorted window
+                double old = StreamValue<T>::coeff(m_buf[m_head],c);
+                for(k = 0; (k < N - 1) && (s[k] != old); k++);
+                last = N - 1;
+            }
+            //move the hole at k to the place of v
+            while((k > 0) && (s[k-1] > v)){
+                s[k] = s[k-1];
+                k--;
+            }
+            while((k < last) && (s[k+1] < v)){
+                s[k] = s[k+1];
+                k++;
+            }
+            s[k] = v;
+        }
+        m_buf[m_head] = x;
+        if(++m_head == N)
+            m_head = 0;
+        if(m_count < N)
+            m_count++;
+        for(int c = 0; c < StreamValue<T>::size; c++){
+            const double *s = m_sorted[c];
+            StreamValue<T>::coeff(m_value,c) = (m_count % 2) ? s[m_count/2] : 0.5*(s[m_count/2 - 1] + s[m_count/2]);
+        }
+        return m_value;
+    }
+    const T& value() const {return m_value;}
+    int count() const {return m_count;}
+private:
+    T m_buf[N];
+    double m_sorted[StreamValue<T>::size][N];
+    T m_value;
+    int m_head;
+    int m_count;
+};
+
+//!one euro filter (Casiez et al. 2012): a low pass whose cutoff rises with the
+//!speed of the signal, smooth at rest and with little lag when it moves.
+//!min_cutoff in Hz, beta in 1/(unit of the signal), dt in s.
+template<typename T>
+class OneEuroFilter
+{
+public:
+    EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+    OneEuroFilter(double min_cutoff = 1.0, double beta = 0.0, double dt = 0.004, double d_cutoff = 1.0){
+        set_params(min_cutoff,beta,dt,d_cutoff);
+        reset();
+    }
+    void set_params(double min_cutoff, double beta, double dt, double d_cutoff = 1.0){
+        m_min_cutoff = min_cutoff;
+        m_beta = beta;
+        m_dt = dt;
+        m_d_alpha = alpha(d_cutoff);
+    }
+    void reset(){
+        m_init = false;
+        m_value = StreamValue<T>::zero();
+        m_dx = StreamValue<T>::zero();
+    }
+    const T& add(const T& x){
+        if(m_init == false){
+            m_value = x;
+            m_dx = StreamValue<T>::zero();
+            m_init = true;
+            return m_value;
+        }
+        m_dx = m_d_alpha*((x - m_value)/m_dt) + (1.0 - m_d_alpha)*m_dx;
+        double a = alpha(m_min_cutoff + m_beta*StreamValue<T>::norm(m_dx));
+        m_value = a*x + (1.0 - a)*m_value;
+        return m_value;
+    }
+    const T& value() const {return m_value;}
+private:
+    double alpha(double cutoff) const {
+        double tau = 1.0/(2.0*M_PI*cutoff);
+        return 1.0/(1.0 + tau/m_dt);
+    }
+    double m_min_cutoff,m_beta,m_dt,m_d_alpha;
+    bool m_init;
+    T m_value;
+    T m_dx;
+};
+
+#endif // STREAMFILTER_H
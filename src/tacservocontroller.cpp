@@ -1,25 +1,10 @@
 #include "tacservocontroller.h"
 #include "tacservotask.h"
+#include "tracer.h"
 #include <sys/stat.h>     //create folder for data record
 
- void TacServoController::initTacServoCtrlParam(TACTaskNameT tnt){
-     Kpp[tnt].setZero(6, 6);
-     Kpi[tnt].setZero(6, 6);
-     Kpd[tnt].setZero(6, 6);
-     Kop[tnt].setZero(3, 3);
-     sm[tnt].setZero(6, 6);
-     tjkm[tnt].setZero(6, 6);
-     Kpp[tnt] = pm.tac_task_ctrl_param[tnt].kpp;
-     Kpi[tnt] = pm.tac_task_ctrl_param[tnt].kpi;
-     Kpd[tnt] = pm.tac_task_ctrl_param[tnt].kpd;
-     Kop[tnt] = pm.tac_task_ctrl_param[tnt].kop;
-     sm[tnt] = pm.tac_task_ctrl_param[tnt].tsm;
-     tjkm[tnt] = pm.tac_task_ctrl_param[tnt].ttjkm;
- }
-
- void TacServoController::set_pm(ParameterManager &p){
+ void TacServoController::set_pm(const ParamSet& p){
      pm = p;
-     std::cout<<"you are update pm in tactile servo controller"<<std::endl;
  }
 
  void TacServoController::update_controller_para(Eigen::Vector3d &, PROTaskNameT){
@@ -28,35 +13,36 @@
  void TacServoController::update_controller_para_stiffness(){
  }
 
-
- void TacServoController::updateTacServoCtrlParam(TACTaskNameT tnt){
-     Kpp[tnt] = pm.tac_task_ctrl_param[tnt].kpp;
-     Kpi[tnt] = pm.tac_task_ctrl_param[tnt].kpi;
-     Kpd[tnt] = pm.tac_task_ctrl_param[tnt].kpd;
-     Kop[tnt] = pm.tac_task_ctrl_param[tnt].kop;
-     sm[tnt] = pm.tac_task_ctrl_param[tnt].tsm;
-     tjkm[tnt] = pm.tac_task_ctrl_param[tnt].ttjkm;
+ //!the fused gains are resolved once per parameter set, see ParameterManager::tac_view
+ void TacServoController::updateTacServoCtrlParam(TACTaskNameT){
  }
 
-TacServoController::TacServoController(ParameterManager &p) : ActController(p)
+void TacServoController::reset(){
+    ActController::reset();
+    deltais.setZero();
+    deltais_int.setZero();
+    deltais_old.setZero();
+    delta_obj_int.setZero();
+    delta_obj_old.setZero();
+    delta_obj_int_o.setZero();
+    delta_obj_old_o.setZero();
+    deltape.setZero();
+    llv_tac.setZero();
+    lov_tac.setZero();
+    tac_median.reset();
+}
+
+TacServoController::TacServoController(const ParamSet& p) : ActController(p)
 {
-    deltais.setZero(6);
-    deltais_int.setZero(6);
-    deltais_old.setZero(6);
+    deltais.setZero();
+    deltais_int.setZero();
+    deltais_old.setZero();
     delta_obj_int.setZero(3);
     delta_obj_old.setZero(3);
     delta_obj_int_o.setZero(3);
     delta_obj_old_o.setZero(3);
-    deltape.setZero(6);
+    deltape.setZero();
 
-    initTacServoCtrlParam(CONTACT_POINT_TRACKING);
-    initTacServoCtrlParam(CONTACT_FORCE_TRACKING);
-    initTacServoCtrlParam(CONTACT_POINT_FORCE_TRACKING);
-    initTacServoCtrlParam(SENSING_POLE_TRACKING);
-    initTacServoCtrlParam(Z_ORIEN_TRACKING);
-    initTacServoCtrlParam(LINEAR_TRACKING);
-    initTacServoCtrlParam(COVER_OBJECT_SURFACE);
-    initTacServoCtrlParam(OBJECT_SURFACE_EXPLORING);
     llv_tac.setZero();
     lov_tac.setZero();
 //    if(mkdir("/dev/shm/debug",0777)==-1)//creating a directory
@@ -90,70 +76,60 @@ void TacServoController::update_robot_reference(Robot *robot){
 }
 
 void TacServoController::get_desired_lv(Robot *robot, Task *t, myrmex_msg *tacfb){
-    TacServoTask tst(t->curtaskname.tact);
-    tst = *(TacServoTask*)t;
-    double desired_cp[2];
-    double desiredf;
-    //robot current state
-    tst.get_desired_cp_myrmex(desired_cp);
-    tst.get_desired_cf_myrmex(desiredf);
+    TRACE_SCOPE("tac_get_desired_lv");
+    TaskDesc td;
+    //one consistent snapshot of the task per cycle, no copy of the task object
+    t->read_desc(td);
+    const double *desired_cp = td.desired_cp_myrmex;
+    const double desiredf = td.desired_cf_myrmex;
 //    std::cout<<"desired contact p in myrmex "<<desired_cp[0]<<","<<desired_cp[1]<<std::endl;
+    double cf = tacfb->cf;
     if(tacfb->contactflag == true){
-        deltais(1) = tacfb->cogx - desired_cp[0];
-        deltais(0) = tacfb->cogy - desired_cp[1];
-        deltais(5) = M_PI/2 - tacfb->lineorien;
+        const Eigen::Vector4d& m = tac_median.add(Eigen::Vector4d(tacfb->cogx,tacfb->cogy,tacfb->cf,tacfb->lineorien));
+        deltais(1) = m(0) - desired_cp[0];
+        deltais(0) = m(1) - desired_cp[1];
+        cf = m(2);
+        deltais(5) = M_PI/2 - m(3);
     }
     else{
         deltais(0) = 0;
         deltais(1) = 0;
         deltais(5) = 0;
         deltais_int.setZero();
+        //a new contact starts a new window
+        tac_median.reset();
     }
-    deltais(2) =  desiredf - tacfb->cf;
+    deltais(2) =  desiredf - cf;
     //!this two value can be updated by other feedback in future
     deltais(3) = 0;
     deltais(4) = 0;
     deltais_int = deltais_int + deltais;
 //    std::cout<<"desiredis "<<deltais<<std::endl;
-//    std::cout<<"current task name "<<tst.curtaskname.tact<<std::endl;
-//    std::cout<<"kop: "<<std::endl;
-//    std::cout<<Kop[tst.curtaskname.tact]<<std::endl;
-//    std::cout<<"kpp: "<<std::endl;
-//    std::cout<<Kpp[tst.curtaskname.tact]<<std::endl;
-//    std::cout<<"tjkm: "<<std::endl;
-//    std::cout<<tjkm[tst.curtaskname.tact]<<std::endl;
-//    std::cout<<"sm: "<<std::endl;
-//    std::cout<<sm[tst.curtaskname.tact]<<std::endl;
+//    std::cout<<"current task name "<<td.curtaskname.tact<<std::endl;
 
-    deltape = Kpp[tst.curtaskname.tact] * tjkm[tst.curtaskname.tact] * sm[tst.curtaskname.tact] * deltais + \
-            Kpi[tst.curtaskname.tact] * tjkm[tst.curtaskname.tact] * sm[tst.curtaskname.tact] * deltais_int + \
-            Kpd[tst.curtaskname.tact] * tjkm[tst.curtaskname.tact] * sm[tst.curtaskname.tact] * (deltais - deltais_old);
+    //kop is already part of the orientation rows of the fused gains
+    const TACTaskNameT tnt = td.curtaskname.tact;
+    const TacTaskView& g = pm->tac_view[tnt];
+    deltape.noalias() = g.gp * deltais;
+    deltape.noalias() += g.gi * deltais_int;
+    deltape.noalias() += g.gd * (deltais - deltais_old);
 //    std::cout<<"deltapa are "<<deltape<<std::endl;
-    llv_tac = deltape.head(3);
-    lov_tac = Kop[tst.curtaskname.tact] * deltape.tail(3);
+    llv_tac = deltape.head<3>();
+    lov_tac = deltape.tail<3>();
     limit_vel(get_llv_limit(),llv_tac,lov_tac);
     deltais_old = deltais;
 }
 
 void TacServoController::update_robot_reference(Robot *robot, Task *t, myrmex_msg *tacfb){
-    Eigen::Vector3d o_target,p_target;
-    p_target.setZero();
-    o_target.setZero();
+    TRACE_SCOPE("tac_update_robot_reference");
+    Eigen::Vector3d p_target;
+    Eigen::Quaterniond q_target;
     get_desired_lv(robot,t,tacfb);
-//    std::cout<<"lv before in tacservo "<<llv<<std::endl;
-//    std::cout<<lov<<std::endl;
-    llv = llv + llv_tac;
-    lov = lov + lov_tac;
-//    std::cout<<"lv after in tacservo "<<llv<<std::endl;
-//    std::cout<<lov<<std::endl;
-    local_to_global(robot->get_cur_cart_p(),robot->get_cur_cart_o(),llv,\
-                    lov,p_target,o_target);
-    for (int i=0; i < 3; i++){
-        cart_command[i] = p_target(i);
-        cart_command[i+3] = o_target(i);
-    }
-    for(int i = 0; i < 6; i++)
-        robot->set_cart_command(cart_command);
+    //combining with other controllers is done by CtrlPipeline
+    set_cycle_time(robot->gettimecycle());
+    local_to_global(robot->get_cur_cart_p(),robot->get_cur_cart_o(),llv_tac,\
+                    lov_tac,p_target,q_target);
+    robot->set_cart_command(p_target,q_target);
 }
 
 void TacServoController::get_lv(Eigen::Vector3d& lv, Eigen::Vector3d& ov){
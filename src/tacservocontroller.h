@@ -4,13 +4,18 @@
 #include "actcontroller.h"
 #include <map>
 #include "msgcontenttype.h"
+#include "streamfilter.h"
 #include <fstream>
 
+//!frames in the median of the tactile feedback, removes single frame outliers
+#define TAC_MEDIAN_N 3
+
 
 class TacServoController : public ActController
 {
 public:
-    TacServoController(ParameterManager &p);
+    EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+    TacServoController(const ParamSet& p);
     //hold the object in its current pose
     void update_robot_reference(Robot *);
     //move the object to the desired reference designed by Task
@@ -24,29 +29,19 @@ public:
     void updateTacServoCtrlParam(TACTaskNameT);
     void updateProServoCtrlParam(PROTaskNameT tnt){}
     void get_lv(Eigen::Vector3d& lv, Eigen::Vector3d& ov);
-    void set_pm(ParameterManager &p);
-    void set_init_TM(Eigen::Matrix3d tm) {m_init_tm = tm;}
+    void set_pm(const ParamSet& p);
+    //!clears the PID state, the fused gains are kept
+    void reset();
 private:
-    //!select matrix
-    std::map<TACTaskNameT, Eigen::MatrixXd> sm;
-    //!task jacobian matrix
-    std::map<TACTaskNameT, Eigen::MatrixXd> tjkm;
-    //!pose kp parameter
-    std::map<TACTaskNameT, Eigen::MatrixXd> Kpp;
-    //!pose ki parameter
-    std::map<TACTaskNameT, Eigen::MatrixXd> Kpi;
-    //!pose kd parameter
-    std::map<TACTaskNameT, Eigen::MatrixXd> Kpd;
-    //!orien increamental matrix
-    std::map<TACTaskNameT, Eigen::MatrixXd> Kop;
-    Eigen::VectorXd deltape;
+    Eigen::Matrix<double,6,1> deltape;
     Eigen::Vector3d llv_tac,lov_tac;
-    void initTacServoCtrlParam(TACTaskNameT);
+    //!cogx, cogy, cf and lineorien while in contact
+    MedianFilter<Eigen::Vector4d,TAC_MEDIAN_N> tac_median;
 
 public:
-    Eigen::VectorXd deltais;
-    Eigen::VectorXd deltais_int;
-    Eigen::VectorXd deltais_old;
+    Eigen::Matrix<double,6,1> deltais;
+    Eigen::Matrix<double,6,1> deltais_int;
+    Eigen::Matrix<double,6,1> deltais_old;
     Eigen::VectorXd delta_obj_int;
     Eigen::VectorXd delta_obj_old;
     Eigen::VectorXd delta_obj_int_o;
@@ -6,16 +6,28 @@ TacServoTask::TacServoTask(TACTaskNameT taskname)
     desired_cp_myrmex[0] = 8.0;
     desired_cp_myrmex[1] = 8.0;
     desired_cf_myrmex = 0.1;
+    desired_cf_kuka = 0.0;
+    commit();
 }
 void TacServoTask::switchtotask(TACTaskNameT taskname){
     curtaskname.tact = taskname;
+    commit();
 }
 
 void TacServoTask::set_desired_cp_myrmex(double *cp){
     desired_cp_myrmex[0] = cp[0];
     desired_cp_myrmex[1] = cp[1];
+    commit();
 }
 
 void TacServoTask::set_desired_cf_myrmex(double cf){
     desired_cf_myrmex = cf;
+    commit();
+}
+
+void TacServoTask::write_desc(TaskDesc& d){
+    Task::write_desc(d);
+    d.desired_cp_myrmex[0] = desired_cp_myrmex[0];
+    d.desired_cp_myrmex[1] = desired_cp_myrmex[1];
+    d.desired_cf_myrmex = desired_cf_myrmex;
 }
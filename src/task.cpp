@@ -8,8 +8,14 @@
 #define initO_y M_PI/2;
 #define initO_z 0.0;
 
-Task::Task()
+Task::Task() : desc_seq(0)
 {
+    reset();
+}
+
+void Task::reset(){
+    initial_p_eigen.setZero();
+    desired_o_eigen.setIdentity();
     desired_p_eigen(0) = -1 * initP_x;
     desired_p_eigen(1) = initP_y;
     desired_p_eigen(2) = initP_z;
@@ -21,4 +27,60 @@ Task::Task()
     mt = JOINTS;
     mft = GLOBAL;
     velocity_p2p.setZero();
+    commit();
+}
+
+Task::Task(const Task& t) : desc_seq(0)
+{
+    *this = t;
+}
+
+Task& Task::operator=(const Task& t){
+    curtaskname = t.curtaskname;
+    mt = t.mt;
+    mft = t.mft;
+    velocity_p2p = t.velocity_p2p;
+    desired_p_eigen = t.desired_p_eigen;
+    initial_p_eigen = t.initial_p_eigen;
+    desired_o_eigen = t.desired_o_eigen;
+    desired_o_ax = t.desired_o_ax;
+    TaskDesc d;
+    t.read_desc(d);
+    unsigned s = desc_seq.load(std::memory_order_relaxed);
+    desc_seq.store(s+1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    desc = d;
+    desc_seq.store(s+2, std::memory_order_release);
+    return *this;
+}
+
+void Task::write_desc(TaskDesc& d){
+    d.curtaskname = curtaskname;
+    d.mt = mt;
+    d.mft = mft;
+    d.desired_cp_myrmex[0] = 0.0;
+    d.desired_cp_myrmex[1] = 0.0;
+    d.desired_cf_myrmex = 0.0;
+    d.velocity_p2p = velocity_p2p;
+    d.desired_p_eigen = desired_p_eigen;
+    d.initial_p_eigen = initial_p_eigen;
+    d.desired_o_ax = desired_o_ax;
+}
+
+void Task::commit(){
+    unsigned s = desc_seq.load(std::memory_order_relaxed);
+    desc_seq.store(s+1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    write_desc(desc);
+    desc_seq.store(s+2, std::memory_order_release);
+}
+
+void Task::read_desc(TaskDesc& d) const{
+    unsigned s0,s1;
+    do{
+        s0 = desc_seq.load(std::memory_order_acquire);
+        d = desc;
+        std::atomic_thread_fence(std::memory_order_acquire);
+        s1 = desc_seq.load(std::memory_order_relaxed);
+    }while((s0 & 1) || (s0 != s1));
 }
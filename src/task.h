@@ -2,6 +2,7 @@
 #define TASK_H
 #include <Eigen/Dense>
 #include <vector>
+#include <atomic>
 
 enum TACTaskNameT{
     CONTACT_POINT_TRACKING,
@@ -40,6 +41,10 @@ enum PROTaskNameT{
     RP_ROTATEFOLLOW = 15
 };
 
+//!size of the task indexed parameter tables, the task name is the index
+#define TAC_TASK_NUM 16
+#define PRO_TASK_NUM 16
+
 enum VISTaskNameT{
     V_NOCONTROL
 };
@@ -66,13 +71,54 @@ enum ModalityT{
 enum MoveFrameT{
     GLOBAL,
     LOCAL,
-    LOCALP2P
+    LOCALP2P,
+    //!follow the trajectory queue attached to the controller
+    TRAJECTORY
+};
+
+//!compact copy of everything the controllers read from a task each cycle,
+//!hot fields first so that the proprioceptive controller stays in the first cache line
+struct TaskDesc{
+    TaskNameT curtaskname;
+    ModalityT mt;
+    MoveFrameT mft;
+    double desired_cp_myrmex[2];
+    double desired_cf_myrmex;
+    Eigen::Vector3d velocity_p2p;
+    Eigen::Vector3d desired_p_eigen;
+    Eigen::Vector3d initial_p_eigen;
+    Eigen::Vector3d desired_o_ax;
+    //!all fields zero and every enum at its first value
+    void reset(){
+        curtaskname.tact = CONTACT_POINT_TRACKING;
+        curtaskname.prot = RLXP;
+        curtaskname.vist = V_NOCONTROL;
+        curtaskname.forcet = F_NOCONTROL;
+        mt = JOINTS;
+        mft = GLOBAL;
+        desired_cp_myrmex[0] = 0.0;
+        desired_cp_myrmex[1] = 0.0;
+        desired_cf_myrmex = 0.0;
+        velocity_p2p.setZero();
+        desired_p_eigen.setZero();
+        initial_p_eigen.setZero();
+        desired_o_ax.setZero();
+    }
 };
 
 class Task
 {
 public:
     Task();
+    Task(const Task&);
+    Task& operator=(const Task&);
+    virtual ~Task(){}
+    //!publish the current settings to the controllers, must be called from one thread only
+    void commit();
+    //!consistent snapshot of the last committed settings, safe against a concurrent commit
+    void read_desc(TaskDesc&) const;
+    //!restore the defaults of a new task and commit them
+    void reset();
     virtual Eigen::Vector3d get_desired_p_eigen() = 0;
     virtual Eigen::Vector3d get_initial_p_eigen() = 0;
     virtual Eigen::Matrix3d get_desired_o_eigen() = 0;
@@ -84,14 +130,20 @@ public:
     virtual void set_desired_cp_myrmex(double *) = 0;
     virtual void set_desired_cf_myrmex(double) = 0;
     virtual void set_desired_cf_kuka(double) = 0;
+    //!the controllers only see direct changes of these fields after commit()
     TaskNameT curtaskname;
     ModalityT mt;
     MoveFrameT mft;
     Eigen::Vector3d velocity_p2p;
 protected:
+    virtual void write_desc(TaskDesc&);
     Eigen::Vector3d desired_p_eigen,initial_p_eigen;
     Eigen::Matrix3d desired_o_eigen;
     Eigen::Vector3d desired_o_ax;
+private:
+    //!sequence lock of desc, odd while a commit is in progress
+    std::atomic<unsigned> desc_seq;
+    TaskDesc desc;
 };
 
 #endif // TASK_H
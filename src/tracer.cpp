@@ -0,0 +1,160 @@
+#include "tracer.h"
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <algorithm>
+#include <mutex>
+#include <time.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+
+std::atomic<bool> Tracer::m_enabled(false);
+
+//!one slot of a ring. The owner stores the fields relaxed before it publishes
+//!the slot with the head, a reader checks the head again after the copy.
+struct TraceSlot{
+    std::atomic<const char*> name;
+    std::atomic<uint64_t> begin;
+    std::atomic<uint64_t> end;
+};
+
+//!spans of one thread, only the owning thread writes. head counts the published
+//!spans, spans before start are cleared.
+struct TraceRing{
+    TraceRing() : head(0), start(0), tid(0){
+        slots = new TraceSlot[TRACE_RING_SIZE];
+        for(int i = 0; i < TRACE_RING_SIZE; i++){
+            slots[i].name.store(NULL,std::memory_order_relaxed);
+            slots[i].begin.store(0,std::memory_order_relaxed);
+            slots[i].end.store(0,std::memory_order_relaxed);
+        }
+    }
+    TraceSlot *slots;
+    std::atomic<uint64_t> head;
+    std::atomic<uint64_t> start;
+    long tid;
+    std::string name;
+};
+
+//!rings are never freed, a span may be recorded by a thread that is about to exit
+static std::vector<TraceRing*> rings;
+static std::mutex rings_mutex;
+static thread_local TraceRing *local_ring = NULL;
+
+//!ticks and CLOCK_MONOTONIC when tracing was enabled, to convert ticks to time
+static uint64_t clock_tick0 = 0;
+static double clock_ns0 = 0.0;
+
+static double monotonic_ns(){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC,&ts);
+    return 1e9*ts.tv_sec + ts.tv_nsec;
+}
+
+void Tracer::enable(bool on){
+    if(on && (enabled() == false)){
+        clock_tick0 = trace_now();
+        clock_ns0 = monotonic_ns();
+    }
+    m_enabled.store(on);
+}
+
+void Tracer::register_thread(const char *name){
+    if(local_ring != NULL)
+        return;
+    TraceRing *r = new TraceRing();
+    r->tid = syscall(SYS_gettid);
+    r->name = name;
+    std::lock_guard<std::mutex> lock(rings_mutex);
+    rings.push_back(r);
+    local_ring = r;
+}
+
+void Tracer::record(const char *name, uint64_t begin, uint64_t end){
+    TraceRing *r = local_ring;
+    if(r == NULL)
+        return;
+    uint64_t h = r->head.load(std::memory_order_relaxed);
+    //a reader that sees the new slot sees the head of the last span as well
+    std::atomic_thread_fence(std::memory_order_release);
+    TraceSlot& s = r->slots[h % TRACE_RING_SIZE];
+    s.name.store(name,std::memory_order_relaxed);
+    s.begin.store(begin,std::memory_order_relaxed);
+    s.end.store(end,std::memory_order_relaxed);
+    r->head.store(h + 1,std::memory_order_release);
+}
+
+void Tracer::clear(){
+    std::lock_guard<std::mutex> lock(rings_mutex);
+    for(size_t i = 0; i < rings.size(); i++)
+        rings[i]->start.store(rings[i]->head.load(std::memory_order_acquire));
+}
+
+//!copy the published spans of r. The owner may overwrite the oldest slots during
+//!the copy, those are dropped once the head has been read again: with the head at
+//!h2 the owner may be writing span h2, the spans up to h2 - TRACE_RING_SIZE are lost.
+static void snapshot(TraceRing *r, std::vector<TraceSpan>& out){
+    out.clear();
+    uint64_t head = r->head.load(std::memory_order_acquire);
+    uint64_t first = r->start.load(std::memory_order_relaxed);
+    if(head > TRACE_RING_SIZE)
+        first = std::max(first,head - TRACE_RING_SIZE);
+    for(uint64_t k = first; k < head; k++){
+        const TraceSlot& s = r->slots[k % TRACE_RING_SIZE];
+        TraceSpan span;
+        span.name = s.name.load(std::memory_order_relaxed);
+        span.begin = s.begin.load(std::memory_order_relaxed);
+        span.end = s.end.load(std::memory_order_relaxed);
+        out.push_back(span);
+    }
+    //the slot loads happen before the second head load
+    std::atomic_thread_fence(std::memory_order_acquire);
+    uint64_t head2 = r->head.load(std::memory_order_relaxed);
+    if(head2 + 1 > first + TRACE_RING_SIZE){
+        uint64_t lost = std::min((uint64_t)out.size(),head2 + 1 - first - TRACE_RING_SIZE);
+        out.erase(out.begin(),out.begin() + lost);
+    }
+}
+
+bool Tracer::write_chrome_json(const std::string& path){
+    //ticks per ns over the whole trace
+    double ns_per_tick = 1.0;
+    uint64_t tick1 = trace_now();
+    double ns1 = monotonic_ns();
+    if(tick1 > clock_tick0)
+        ns_per_tick = (ns1 - clock_ns0)/(tick1 - clock_tick0);
+    std::ofstream f(path.c_str());
+    if(!f){
+        std::cout<<"tracer: can not write "<<path<<std::endl;
+        return false;
+    }
+    uint64_t spans = 0;
+    f<<"{\"traceEvents\":[\n"<<std::fixed<<std::setprecision(3);
+    bool first = true;
+    std::vector<TraceSpan> copy;
+    copy.reserve(TRACE_RING_SIZE);
+    std::lock_guard<std::mutex> lock(rings_mutex);
+    for(size_t i = 0; i < rings.size(); i++){
+        TraceRing *r = rings[i];
+        f<<(first ? "" : ",\n")<<"{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":"<<getpid()\
+         <<",\"tid\":"<<r->tid<<",\"args\":{\"name\":\""<<r->name<<"\"}}";
+        first = false;
+        snapshot(r,copy);
+        for(size_t k = 0; k < copy.size(); k++){
+            const TraceSpan& s = copy[k];
+            //spans recorded before the last enable have no time base
+            if(s.begin < clock_tick0)
+                continue;
+            double ts = 1e-3*(clock_ns0 + ns_per_tick*(s.begin - clock_tick0));
+            double dur = 1e-3*ns_per_tick*(s.end - s.begin);
+            f<<(first ? "" : ",\n")<<"{\"name\":\""<<s.name<<"\",\"ph\":\"X\",\"pid\":"<<getpid()\
+             <<",\"tid\":"<<r->tid<<",\"ts\":"<<ts<<",\"dur\":"<<dur<<"}";
+            first = false;
+            spans++;
+        }
+    }
+    f<<"\n],\"displayTimeUnit\":\"ns\"}\n";
+    std::cout<<"tracer: "<<spans<<" spans written to "<<path<<std::endl;
+    return true;
+}
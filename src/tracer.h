@@ -0,0 +1,76 @@
+#ifndef TRACER_H
+#define TRACER_H
+#include <atomic>
+#include <string>
+#include <stdint.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#else
+#include <time.h>
+#endif
+
+//!spans kept per thread, the oldest are overwritten. A power of two, 16384
+//!spans are about 3s of a fully traced control cycle.
+#define TRACE_RING_SIZE 16384
+#define TRACE_FILE "/tmp/kukatrace.json"
+
+//!one finished span in ticks of trace_now()
+struct TraceSpan{
+    const char *name;
+    uint64_t begin;
+    uint64_t end;
+};
+
+//!time stamp counter where there is one, CLOCK_MONOTONIC ns otherwise
+inline uint64_t trace_now(){
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC,&ts);
+    return (uint64_t)ts.tv_sec*1000000000ull + ts.tv_nsec;
+#endif
+}
+
+//!per thread rings of spans, exported in the Chrome trace event format
+//!(chrome://tracing, ui.perfetto.dev). Disabled a span costs one relaxed load.
+//!A thread records only after register_thread(), spans of other threads are dropped.
+class Tracer
+{
+public:
+    static void enable(bool on);
+    static bool enabled(){return m_enabled.load(std::memory_order_relaxed);}
+    //!allocate the ring of the calling thread under name, call it at thread start
+    //!and not in a control cycle. Later calls of the same thread do nothing.
+    static void register_thread(const char *name);
+    //!record a span of the calling thread, name has to outlive the tracer
+    static void record(const char *name, uint64_t begin, uint64_t end);
+    //!write the published spans of all rings as json while the threads go on
+    //!recording, false if the file can not be written. Not for a control thread.
+    static bool write_chrome_json(const std::string& path);
+    //!forget all recorded spans
+    static void clear();
+private:
+    static std::atomic<bool> m_enabled;
+};
+
+//!records the lifetime of the scope as one span while tracing is enabled
+class TraceScope
+{
+public:
+    explicit TraceScope(const char *n) : name(n), begin(Tracer::enabled() ? trace_now() : 0){}
+    ~TraceScope(){
+        if(begin != 0)
+            Tracer::record(name,begin,trace_now());
+    }
+private:
+    const char *name;
+    uint64_t begin;
+};
+
+#define TRACE_CONCAT2(a,b) a##b
+#define TRACE_CONCAT(a,b) TRACE_CONCAT2(a,b)
+//!trace the rest of the enclosing scope under name, a string literal
+#define TRACE_SCOPE(name) TraceScope TRACE_CONCAT(trace_scope_,__LINE__)(name)
+
+#endif // TRACER_H
@@ -0,0 +1,174 @@
+#include "trajqueue.h"
+#include <cmath>
+#include <algorithm>
+
+void TrajSegment::sample(double t, Eigen::Vector3d& p, Eigen::Quaterniond& q) const{
+    double tau = t - t0;
+    if(tau < 0) tau = 0;
+    if(tau > duration) tau = duration;
+    double s = (duration > 0) ? tau/duration : 1.0;
+    if(type == SEG_LINEAR){
+        p = p0 + s * (p1 - p0);
+    }
+    if(type == SEG_SPLINE){
+        double s2 = s*s;
+        double s3 = s2*s;
+        p = (2*s3 - 3*s2 + 1) * p0 + (s3 - 2*s2 + s) * duration * v0 + \
+                (-2*s3 + 3*s2) * p1 + (s3 - s2) * duration * v1;
+    }
+    if(type == SEG_SINUSOID){
+        p = p0 + (sin(2*M_PI*freq*tau + phase) - sin(phase)) * amp;
+    }
+    q = q0.slerp(s,q1);
+}
+
+Eigen::Vector3d TrajSegment::velocity(double t) const{
+    double tau = t - t0;
+    if(tau < 0) tau = 0;
+    if(tau > duration) tau = duration;
+    if(duration <= 0)
+        return Eigen::Vector3d::Zero();
+    if(type == SEG_LINEAR)
+        return (p1 - p0) / duration;
+    if(type == SEG_SPLINE){
+        double s = tau/duration;
+        double s2 = s*s;
+        return ((6*s2 - 6*s) * (p0 - p1)) / duration + (3*s2 - 4*s + 1) * v0 + (3*s2 - 2*s) * v1;
+    }
+    return 2*M_PI*freq*cos(2*M_PI*freq*tau + phase) * amp;
+}
+
+TrajQueue::TrajQueue() : m_head(0), m_tail(0), m_flush(0), m_time(0.0)
+{
+    m_end_t = 0.0;
+    m_end_p.setZero();
+    m_end_v.setZero();
+    m_end_q.setIdentity();
+    m_cycles = 0;
+    m_has_pose = false;
+    m_hold_p.setZero();
+    m_hold_q.setIdentity();
+}
+
+bool TrajQueue::restart(const Eigen::Vector3d& p, const Eigen::Quaterniond& q){
+    //a zero length segment at p,q: the control thread holds the restart pose, not
+    //the end of a flushed segment, until the next segment is pushed
+    TrajSegment s;
+    s.type = SEG_LINEAR;
+    s.t0 = time();
+    s.duration = 0.0;
+    s.p0 = p;
+    s.p1 = p;
+    s.q0 = q;
+    s.q1 = q;
+    s.v0.setZero();
+    s.v1.setZero();
+    s.amp.setZero();
+    s.freq = 0.0;
+    s.phase = 0.0;
+    unsigned long head = m_head.load(std::memory_order_relaxed);
+    if(push(s) == false)
+        return false;
+    //released after the head, a consumer that sees the flush sees the segment
+    m_flush.store(head,std::memory_order_release);
+    return true;
+}
+
+bool TrajQueue::append(TrajSegment& s){
+    //a queue that ran dry continues at the current time
+    s.t0 = std::max(m_end_t,time());
+    s.p0 = m_end_p;
+    s.q0 = m_end_q;
+    return push(s);
+}
+
+bool TrajQueue::push_linear(const Eigen::Vector3d& p1, const Eigen::Quaterniond& q1, double duration){
+    TrajSegment s;
+    s.type = SEG_LINEAR;
+    s.duration = duration;
+    s.p1 = p1;
+    s.q1 = q1;
+    s.v0.setZero();
+    s.v1.setZero();
+    s.amp.setZero();
+    s.freq = 0.0;
+    s.phase = 0.0;
+    return append(s);
+}
+
+bool TrajQueue::push_spline(const Eigen::Vector3d& p1, const Eigen::Vector3d& v1,\
+                            const Eigen::Quaterniond& q1, double duration){
+    TrajSegment s;
+    s.type = SEG_SPLINE;
+    s.duration = duration;
+    s.p1 = p1;
+    s.q1 = q1;
+    s.v0 = m_end_v;
+    s.v1 = v1;
+    s.amp.setZero();
+    s.freq = 0.0;
+    s.phase = 0.0;
+    return append(s);
+}
+
+bool TrajQueue::push_sinusoid(const Eigen::Vector3d& amp, double freq, double phase, double duration){
+    TrajSegment s;
+    s.type = SEG_SINUSOID;
+    s.duration = duration;
+    s.amp = amp;
+    s.freq = freq;
+    s.phase = phase;
+    s.q1 = m_end_q;
+    s.v0.setZero();
+    s.v1.setZero();
+    s.p1 = m_end_p + (sin(2*M_PI*freq*duration + phase) - sin(phase)) * amp;
+    return append(s);
+}
+
+bool TrajQueue::push(const TrajSegment& s){
+    unsigned long head = m_head.load(std::memory_order_relaxed);
+    if(head - m_tail.load(std::memory_order_acquire) >= TRAJ_QUEUE_SIZE)
+        return false;
+    ring[head % TRAJ_QUEUE_SIZE] = s;
+    m_head.store(head + 1,std::memory_order_release);
+    m_end_t = s.t0 + s.duration;
+    m_end_p = s.p1;
+    m_end_q = s.q1;
+    m_end_v = s.velocity(m_end_t);
+    return true;
+}
+
+bool TrajQueue::sample(double dt, Eigen::Vector3d& p, Eigen::Quaterniond& q){
+    m_cycles++;
+    double t = m_cycles * dt;
+    m_time.store(t,std::memory_order_release);
+    //flush before head, the restart segment is published before its flush
+    unsigned long flush = m_flush.load(std::memory_order_acquire);
+    unsigned long head = m_head.load(std::memory_order_acquire);
+    unsigned long tail = m_tail.load(std::memory_order_relaxed);
+    if(tail < flush)
+        tail = flush;
+    //retire finished segments, their end pose is held if nothing follows
+    while(tail != head){
+        const TrajSegment& s = ring[tail % TRAJ_QUEUE_SIZE];
+        if(t < s.t0 + s.duration)
+            break;
+        m_hold_p = s.p1;
+        m_hold_q = s.q1;
+        m_has_pose = true;
+        tail++;
+    }
+    m_tail.store(tail,std::memory_order_release);
+    if(tail != head){
+        const TrajSegment& s = ring[tail % TRAJ_QUEUE_SIZE];
+        if((t >= s.t0) || (m_has_pose == false)){
+            s.sample(t,p,q);
+            return true;
+        }
+    }
+    if(m_has_pose == false)
+        return false;
+    p = m_hold_p;
+    q = m_hold_q;
+    return true;
+}
@@ -0,0 +1,80 @@
+#ifndef TRAJQUEUE_H
+#define TRAJQUEUE_H
+#include <atomic>
+#include <Eigen/Dense>
+#include <Eigen/Geometry>
+
+//!number of segments that can be queued ahead
+#define TRAJ_QUEUE_SIZE 64
+
+enum TrajSegmentT{
+    //!straight line p0->p1
+    SEG_LINEAR,
+    //!cubic hermite p0->p1 with the velocities v0,v1
+    SEG_SPLINE,
+    //!p0 + amp*(sin(2*pi*freq*tau+phase)-sin(phase))
+    SEG_SINUSOID
+};
+
+//!time parameterised cartesian segment, t0 and duration are in seconds of queue time.
+//!The orientation is interpolated by slerp q0->q1 over the duration.
+struct TrajSegment{
+    EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+    TrajSegmentT type;
+    double t0;
+    double duration;
+    Eigen::Vector3d p0,p1;
+    Eigen::Vector3d v0,v1;
+    Eigen::Vector3d amp;
+    double freq,phase;
+    Eigen::Quaterniond q0,q1;
+    void sample(double t, Eigen::Vector3d& p, Eigen::Quaterniond& q) const;
+    Eigen::Vector3d velocity(double t) const;
+};
+
+//!single producer single consumer queue of cartesian segments. The producer
+//!streams segments ahead of time, the control thread samples them once per
+//!cycle. Nothing is allocated after construction.
+class TrajQueue
+{
+public:
+    EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+    TrajQueue();
+    //!producer: drop all queued segments and continue from p,q at the current queue
+    //!time, the control thread holds p,q from its next cycle. False if the queue is full.
+    bool restart(const Eigen::Vector3d& p, const Eigen::Quaterniond& q);
+    //!producer: append segments starting where the last one ends, false if the queue is full
+    bool push_linear(const Eigen::Vector3d& p1, const Eigen::Quaterniond& q1, double duration);
+    bool push_spline(const Eigen::Vector3d& p1, const Eigen::Vector3d& v1,\
+                     const Eigen::Quaterniond& q1, double duration);
+    bool push_sinusoid(const Eigen::Vector3d& amp, double freq, double phase, double duration);
+    //!producer: append a segment with its own start time and pose
+    bool push(const TrajSegment&);
+    //!producer: queue time where the last pushed segment ends
+    double end_time(){return m_end_t;}
+    //!queue time of the last sample of the control thread
+    double time(){return m_time.load(std::memory_order_acquire);}
+    //!control thread: advance the queue time by one cycle of dt and sample the
+    //!segment at that time. Holds the last end pose when the queue runs empty,
+    //!false if nothing was pushed yet.
+    bool sample(double dt, Eigen::Vector3d& p, Eigen::Quaterniond& q);
+private:
+    bool append(TrajSegment& s);
+    TrajSegment ring[TRAJ_QUEUE_SIZE];
+    //!segment counters, written by the producer (head, flush) and the consumer (tail)
+    std::atomic<unsigned long> m_head;
+    std::atomic<unsigned long> m_tail;
+    std::atomic<unsigned long> m_flush;
+    std::atomic<double> m_time;
+    //!producer side end of the queued trajectory
+    double m_end_t;
+    Eigen::Vector3d m_end_p,m_end_v;
+    Eigen::Quaterniond m_end_q;
+    //!consumer side, the queue time is cycles*dt so it does not drift
+    unsigned long m_cycles;
+    bool m_has_pose;
+    Eigen::Vector3d m_hold_p;
+    Eigen::Quaterniond m_hold_q;
+};
+
+#endif // TRAJQUEUE_H